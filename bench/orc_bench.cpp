@@ -0,0 +1,875 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_bench.cpp
+ *    Decode microbenchmark for ORC FDW that runs without PostgreSQL.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ *    Generates ORC files with a single column for each combination of
+ *    type, width, NULL ratio, encoding and compression codec, and then
+ *    measures reader creation, batch fetch, conversion to Datums, casts
+ *    and runtime filtering on each file. Readers are created through
+ *    orc_wrapper.cpp, filters are applied by orc_filter.cpp, and columns
+ *    are packed into Datums and NULL flags by orc_kernels.cpp and cast by
+ *    orc_cast.cpp, against the stubbed Datum API in pg_stub. Types the
+ *    scan converts a value at a time are built the way the scan builds
+ *    them.
+ *
+ *    Results are written to stdout as JSON lines, one object for each
+ *    measurement, so that runs of different builds may be compared.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    bench/orc_bench.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+/* C++ header files */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/* Apache ORC header files */
+#include <orc/OrcFile.hh>
+#include <orc/Writer.hh>
+
+/* ORC FDW header files */
+#include <orc_cast.h>
+#include <orc_filter.h>
+#include <orc_interface_typedefs.h>
+#include <orc_kernels.h>
+#include <orc_wrapper.h>
+
+/* PostgreSQL stub and FDW header files */
+extern "C"
+{
+    #include "c.h"
+    #include "orc_fdw.h"
+}
+
+
+/* Reader creations timed per iteration */
+#define ORC_BENCH_READER_CREATIONS 100
+
+/* Values in the runtime filter of the filter benchmark */
+#define ORC_BENCH_FILTER_VALUES 1024
+
+
+/* A generated file */
+struct BenchCase
+{
+    OrcPgTypeKind kind;
+    std::string type_name;
+    std::string orc_type;
+    int width;
+    double null_ratio;
+    std::string encoding;
+    orc::CompressionKind codec;
+    std::string codec_name;
+    std::string path;
+    uint64_t file_bytes;
+
+    /* Sample of values for the runtime filter; integer types only */
+    std::vector<int64_t> filter_values;
+};
+
+/* Options given on the command line */
+struct BenchOptions
+{
+    uint64_t rows = 1000000;
+    int iterations = 3;
+    std::string dir = "/tmp";
+    std::vector<std::string> types;
+    std::vector<std::string> codecs;
+    std::vector<double> nulls;
+    bool keep = false;
+};
+
+/* Keeps the compiler from dropping conversions whose results are unused */
+static volatile Datum bench_sink;
+
+/* Types and their names; widths of string types are given separately */
+static const struct
+{
+    OrcPgTypeKind kind;
+    const char *name;
+    const char *orc_type;
+} bench_types[] =
+{
+    {BOOLEAN, "BOOLEAN", "boolean"},
+    {BYTE, "BYTE", "tinyint"},
+    {SHORT, "SHORT", "smallint"},
+    {INT, "INT", "int"},
+    {LONG, "LONG", "bigint"},
+    {FLOAT, "FLOAT", "float"},
+    {DOUBLE, "DOUBLE", "double"},
+    {STRING, "STRING", "string"},
+    {BINARY, "BINARY", "binary"},
+    {TIMESTAMP, "TIMESTAMP", "timestamp"},
+    {DECIMAL, "DECIMAL", "decimal"},
+    {DATE, "DATE", "date"},
+    {VARCHAR, "VARCHAR", "varchar"},
+    {CHAR, "CHAR", "char"}
+};
+
+/* Table types that columns are cast to by the cast benchmark */
+static const struct
+{
+    Oid typid;
+    const char *name;
+} bench_cast_types[] =
+{
+    {INT4OID, "int4"},
+    {INT8OID, "int8"},
+    {FLOAT8OID, "float8"},
+    {DATEOID, "date"},
+    {TIMESTAMPOID, "timestamp"}
+};
+
+/* Compression codecs */
+static const struct
+{
+    orc::CompressionKind codec;
+    const char *name;
+} bench_codecs[] =
+{
+    {orc::CompressionKind_NONE, "none"},
+    {orc::CompressionKind_ZLIB, "zlib"},
+    {orc::CompressionKind_SNAPPY, "snappy"},
+    {orc::CompressionKind_LZ4, "lz4"},
+    {orc::CompressionKind_ZSTD, "zstd"}
+};
+
+
+/* Declare the functions to use within this file */
+static std::vector<std::string> splitList(const std::string &list);
+static bool parseOptions(int argc, char **argv, BenchOptions &options);
+static bool isStringKind(OrcPgTypeKind kind);
+static bool isIntegerKind(OrcPgTypeKind kind);
+static std::vector<BenchCase> buildCases(const BenchOptions &options);
+static void writeFile(BenchCase &bench, uint64_t rows);
+static OrcFdwPackKind getPackKind(OrcPgTypeKind kind);
+static Oid getTypeOid(OrcPgTypeKind kind);
+static Datum convertValue(OrcPgTypeKind kind, orc::ColumnVectorBatch *col, uint64_t row, uint64_t *bytes);
+static void printResult(const BenchCase &bench, const char *benchmark, uint64_t rows, uint64_t bytes, std::vector<double> &seconds);
+static void benchReaderCreate(const BenchCase &bench, const BenchOptions &options);
+static void benchScan(const BenchCase &bench, const BenchOptions &options);
+static void benchCast(const BenchCase &bench, const BenchOptions &options);
+static void benchFilter(const BenchCase &bench, const BenchOptions &options);
+
+
+/*
+ * splitList
+ *    Splits a comma separated list.
+ */
+static
+std::vector<std::string>
+splitList(const std::string &list)
+{
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+
+    while (std::getline(ss, item, ','))
+    {
+        if (!item.empty())
+            items.push_back(item);
+    }
+
+    return items;
+}
+
+/*
+ * parseOptions
+ *    Returns false and prints usage for unknown options.
+ */
+static
+bool
+parseOptions(int argc, char **argv, BenchOptions &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+
+        if (arg == "--rows" && hasValue)
+            options.rows = std::stoull(argv[++i]);
+        else if (arg == "--iterations" && hasValue)
+            options.iterations = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--dir" && hasValue)
+            options.dir = argv[++i];
+        else if (arg == "--types" && hasValue)
+            options.types = splitList(argv[++i]);
+        else if (arg == "--codecs" && hasValue)
+            options.codecs = splitList(argv[++i]);
+        else if (arg == "--nulls" && hasValue)
+        {
+            for (auto &ratio : splitList(argv[++i]))
+                options.nulls.push_back(std::stod(ratio));
+        }
+        else if (arg == "--keep")
+            options.keep = true;
+        else
+        {
+            fprintf(stderr,
+                    "Usage: %s [--rows N] [--iterations N] [--dir DIR] [--types LIST]\n"
+                    "          [--codecs LIST] [--nulls LIST] [--keep]\n"
+                    "\n"
+                    "LIST is comma separated, e.g. --types INT,STRING --codecs none,zstd --nulls 0,0.5\n",
+                    argv[0]);
+            return false;
+        }
+    }
+
+    if (options.nulls.empty())
+        options.nulls = {0.0, 0.1, 0.5};
+
+    return true;
+}
+
+static
+bool
+isStringKind(OrcPgTypeKind kind)
+{
+    return (kind == STRING || kind == BINARY || kind == VARCHAR || kind == CHAR);
+}
+
+static
+bool
+isIntegerKind(OrcPgTypeKind kind)
+{
+    return (kind == BYTE || kind == SHORT || kind == INT || kind == LONG || kind == DATE);
+}
+
+/*
+ * buildCases
+ *    Returns the files to generate for the selected types, codecs and NULL
+ *    ratios. String types vary in width and dictionary or direct encoding;
+ *    integer types vary in run-length friendly or random values; decimals
+ *    vary in 64 or 128 bit precision.
+ */
+static
+std::vector<BenchCase>
+buildCases(const BenchOptions &options)
+{
+    std::vector<BenchCase> cases;
+
+    for (auto &type : bench_types)
+    {
+        std::vector<int> widths = {0};
+        std::vector<std::string> encodings = {"random"};
+
+        if (!options.types.empty()
+            && std::find(options.types.begin(), options.types.end(), type.name) == options.types.end())
+            continue;
+
+        if (isStringKind(type.kind))
+        {
+            widths = {8, 64};
+            encodings = {"direct", "dictionary"};
+        }
+        else if (type.kind == DECIMAL)
+            widths = {12, 30};
+        else if (isIntegerKind(type.kind) || type.kind == TIMESTAMP)
+            encodings = {"sequential", "random"};
+
+        for (auto &codec : bench_codecs)
+        {
+            if (!options.codecs.empty()
+                && std::find(options.codecs.begin(), options.codecs.end(), codec.name) == options.codecs.end())
+                continue;
+
+            for (auto width : widths)
+            {
+                for (auto &encoding : encodings)
+                {
+                    for (auto null_ratio : options.nulls)
+                    {
+                        BenchCase bench;
+                        std::stringstream orc_type;
+                        std::stringstream path;
+
+                        orc_type << type.orc_type;
+                        if (type.kind == VARCHAR || type.kind == CHAR)
+                            orc_type << "(" << width << ")";
+                        else if (type.kind == DECIMAL)
+                            orc_type << "(" << width << ",2)";
+
+                        path << options.dir << "/orc_bench_" << type.name << "_" << width << "_"
+                             << encoding << "_" << codec.name << "_" << null_ratio << ".orc";
+
+                        bench.kind = type.kind;
+                        bench.type_name = type.name;
+                        bench.orc_type = orc_type.str();
+                        bench.width = width;
+                        bench.null_ratio = null_ratio;
+                        bench.encoding = encoding;
+                        bench.codec = codec.codec;
+                        bench.codec_name = codec.name;
+                        bench.path = path.str();
+                        bench.file_bytes = 0;
+
+                        cases.push_back(bench);
+                    }
+                }
+            }
+        }
+    }
+
+    return cases;
+}
+
+/*
+ * writeFile
+ *    Writes the file of a case with deterministic values.
+ */
+static
+void
+writeFile(BenchCase &bench, uint64_t rows)
+{
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    ORC_UNIQUE_PTR<orc::Type> type(orc::Type::buildTypeFromString("struct<c:" + bench.orc_type + ">"));
+    orc::WriterOptions options;
+    std::vector<std::string> strings(ORC_DEFAULT_BATCH_SIZE * 8);
+    bool sequential = (bench.encoding == "sequential");
+    uint64_t written = 0;
+
+    options.setCompression(bench.codec);
+    options.setDictionaryKeySizeThreshold(bench.encoding == "dictionary" ? 1.0 : 0.0);
+
+    ORC_UNIQUE_PTR<orc::OutputStream> out = orc::writeLocalFile(bench.path);
+    ORC_UNIQUE_PTR<orc::Writer> writer = orc::createWriter(*type, out.get(), options);
+    ORC_UNIQUE_PTR<orc::ColumnVectorBatch> batch = writer->createRowBatch(strings.size());
+    orc::StructVectorBatch *root = dynamic_cast<orc::StructVectorBatch *>(batch.get());
+    orc::ColumnVectorBatch *col = root->fields[0];
+
+    bench.filter_values.clear();
+
+    while (written < rows)
+    {
+        uint64_t n = std::min((uint64_t) strings.size(), rows - written);
+
+        col->hasNulls = (bench.null_ratio > 0);
+
+        for (uint64_t i = 0; i < n; i++)
+        {
+            uint64_t row = written + i;
+            uint64_t r = rng();
+
+            col->notNull[i] = (unit(rng) >= bench.null_ratio);
+
+            switch (bench.kind)
+            {
+                case BOOLEAN:
+                    dynamic_cast<orc::LongVectorBatch *>(col)->data[i] = r & 1;
+                    break;
+                case BYTE:
+                    dynamic_cast<orc::LongVectorBatch *>(col)->data[i] = (int8_t) (sequential ? row : r);
+                    break;
+                case SHORT:
+                    dynamic_cast<orc::LongVectorBatch *>(col)->data[i] = (int16_t) (sequential ? row : r);
+                    break;
+                case INT:
+                    dynamic_cast<orc::LongVectorBatch *>(col)->data[i] = (int32_t) (sequential ? row : r);
+                    break;
+                case LONG:
+                    dynamic_cast<orc::LongVectorBatch *>(col)->data[i] = (int64_t) (sequential ? row : r);
+                    break;
+                case DATE:
+                    dynamic_cast<orc::LongVectorBatch *>(col)->data[i] = (int64_t) ((sequential ? row / 1000 : r) % 36500);
+                    break;
+                case FLOAT:
+                case DOUBLE:
+                    dynamic_cast<orc::DoubleVectorBatch *>(col)->data[i] = unit(rng) * 1000000.0;
+                    break;
+                case TIMESTAMP:
+                {
+                    orc::TimestampVectorBatch *ts = dynamic_cast<orc::TimestampVectorBatch *>(col);
+
+                    ts->data[i] = (int64_t) (sequential ? 1600000000 + row : 1600000000 + r % 100000000);
+                    ts->nanoseconds[i] = (int64_t) ((r >> 32) % 1000000) * 1000;
+                    break;
+                }
+                case DECIMAL:
+                {
+                    int64_t value = (int64_t) (r % 100000000000);
+
+                    if (bench.width <= 18)
+                        dynamic_cast<orc::Decimal64VectorBatch *>(col)->values[i] = value;
+                    else
+                    {
+                        orc::Int128 wide(value);
+
+                        wide *= orc::Int128(1000000007);
+                        dynamic_cast<orc::Decimal128VectorBatch *>(col)->values[i] = wide;
+                    }
+                    break;
+                }
+                case STRING:
+                case BINARY:
+                case VARCHAR:
+                case CHAR:
+                {
+                    orc::StringVectorBatch *s = dynamic_cast<orc::StringVectorBatch *>(col);
+                    uint64_t len = (bench.kind == CHAR) ? bench.width : 1 + r % bench.width;
+
+                    /* Dictionary encoding pays off with few distinct values */
+                    if (bench.encoding == "dictionary")
+                        r %= 256;
+
+                    strings[i] = std::to_string(r);
+                    strings[i].resize(len, 'x');
+
+                    s->data[i] = const_cast<char *>(strings[i].data());
+                    s->length[i] = (int64_t) strings[i].size();
+                    break;
+                }
+                default:
+                    break;
+            }
+
+            /* Keep a sample of values for the runtime filter */
+            if (isIntegerKind(bench.kind) && col->notNull[i]
+                && bench.filter_values.size() < ORC_BENCH_FILTER_VALUES && r % 97 == 0)
+                bench.filter_values.push_back(dynamic_cast<orc::LongVectorBatch *>(col)->data[i]);
+        }
+
+        col->numElements = n;
+        root->numElements = n;
+        writer->add(*batch);
+        written += n;
+    }
+
+    writer->close();
+    bench.file_bytes = out->getLength();
+}
+
+/*
+ * getPackKind
+ *    Returns the kernel packing a column of kind, as picked by the scan;
+ *    ORC_PACK_NONE if the scan converts its values one at a time.
+ */
+static
+OrcFdwPackKind
+getPackKind(OrcPgTypeKind kind)
+{
+    switch (kind)
+    {
+        case BOOLEAN:
+            return ORC_PACK_BOOL;
+        case BYTE:
+        case SHORT:
+            return ORC_PACK_INT2;
+        case INT:
+            return ORC_PACK_INT4;
+        case LONG:
+            return ORC_PACK_INT8;
+        case FLOAT:
+            return ORC_PACK_FLOAT4;
+        case DOUBLE:
+            return ORC_PACK_FLOAT8;
+        case DATE:
+            return ORC_PACK_DATE;
+        default:
+            return ORC_PACK_NONE;
+    }
+}
+
+/*
+ * getTypeOid
+ *    Returns the type of a column of kind as read by the scan.
+ */
+static
+Oid
+getTypeOid(OrcPgTypeKind kind)
+{
+    switch (kind)
+    {
+        case BYTE:
+        case SHORT:
+            return INT2OID;
+        case INT:
+            return INT4OID;
+        case LONG:
+            return INT8OID;
+        case FLOAT:
+            return FLOAT4OID;
+        case DOUBLE:
+            return FLOAT8OID;
+        case DATE:
+            return DATEOID;
+        case TIMESTAMP:
+            return TIMESTAMPOID;
+        case STRING:
+            return TEXTOID;
+        case VARCHAR:
+            return VARCHAROID;
+        default:
+            return InvalidOid;
+    }
+}
+
+/*
+ * convertValue
+ *    Builds a Datum for a row of a column the scan converts a value at a
+ *    time, adding the bytes produced to bytes. Numerics and timestamps
+ *    are built by server functions in the scan; these are approximated by
+ *    the formatting and arithmetic that precede those calls.
+ */
+static
+Datum
+convertValue(OrcPgTypeKind kind, orc::ColumnVectorBatch *col, uint64_t row, uint64_t *bytes)
+{
+    *bytes += sizeof(Datum);
+
+    switch (kind)
+    {
+        case TIMESTAMP:
+        {
+            orc::TimestampVectorBatch *ts = dynamic_cast<orc::TimestampVectorBatch *>(col);
+            int64 secs = ts->data[row] - (int64) (POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE) * SECS_PER_DAY;
+
+            return Int64GetDatum(secs * USECS_PER_SEC + ts->nanoseconds[row] / 1000);
+        }
+        case DECIMAL:
+        {
+            orc::Decimal64VectorBatch *d64 = dynamic_cast<orc::Decimal64VectorBatch *>(col);
+            std::string nvalue;
+            char *value;
+
+            if (d64 != NULL)
+                nvalue = std::to_string(d64->values[row]);
+            else
+                nvalue = dynamic_cast<orc::Decimal128VectorBatch *>(col)->values[row].toString();
+
+            value = (char *) palloc(nvalue.size() + 1);
+            memcpy(value, nvalue.c_str(), nvalue.size() + 1);
+            *bytes += nvalue.size() + 1;
+
+            return PointerGetDatum(value);
+        }
+        case STRING:
+        case BINARY:
+        case VARCHAR:
+        case CHAR:
+        {
+            orc::StringVectorBatch *s = dynamic_cast<orc::StringVectorBatch *>(col);
+            int64_t orc_data_len = s->length[row];
+            int64_t var_len = VARHDRSZ + orc_data_len;
+            bytea *data = (bytea *) palloc(var_len);
+
+            SET_VARSIZE(data, var_len);
+            memcpy(VARDATA(data), s->data[row], orc_data_len);
+            *bytes += var_len;
+
+            return PointerGetDatum(data);
+        }
+        default:
+            return (Datum) 0;
+    }
+}
+
+/*
+ * printResult
+ *    Prints a JSON line for the median of the iterations.
+ */
+static
+void
+printResult(const BenchCase &bench, const char *benchmark, uint64_t rows, uint64_t bytes, std::vector<double> &seconds)
+{
+    double median;
+
+    std::sort(seconds.begin(), seconds.end());
+    median = seconds[seconds.size() / 2];
+
+    printf("{\"benchmark\": \"%s\", \"type\": \"%s\", \"orc_type\": \"%s\", \"width\": %d, "
+           "\"null_ratio\": %g, \"encoding\": \"%s\", \"codec\": \"%s\", \"batch_size\": %d, "
+           "\"file_bytes\": %llu, \"rows\": %llu, \"bytes\": %llu, \"iterations\": %zu, "
+           "\"seconds\": %.9f, \"rows_per_sec\": %.1f, \"bytes_per_sec\": %.1f}\n",
+           benchmark, bench.type_name.c_str(), bench.orc_type.c_str(), bench.width,
+           bench.null_ratio, bench.encoding.c_str(), bench.codec_name.c_str(), ORC_DEFAULT_BATCH_SIZE,
+           (unsigned long long) bench.file_bytes, (unsigned long long) rows, (unsigned long long) bytes, seconds.size(),
+           median, median > 0 ? rows / median : 0.0, median > 0 ? bytes / median : 0.0);
+
+    fflush(stdout);
+}
+
+/*
+ * benchReaderCreate
+ *    Times creating a reader and a row reader, which reads the file tail
+ *    and metadata. Rows are the number of readers created.
+ */
+static
+void
+benchReaderCreate(const BenchCase &bench, const BenchOptions &options)
+{
+    std::vector<double> seconds;
+
+    for (int it = 0; it < options.iterations; it++)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < ORC_BENCH_READER_CREATIONS; i++)
+        {
+            orc::ReaderOptions readerOptions;
+            orc::RowReaderOptions rowReaderOptions;
+            ORC_UNIQUE_PTR<orc::Reader> reader;
+            ORC_UNIQUE_PTR<orc::RowReader> rowReader;
+
+            (void) orcCreateReader(bench.path, &reader, readerOptions, false);
+            (void) orcCreateRowReader(&reader, &rowReader, rowReaderOptions);
+        }
+
+        seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    printResult(bench, "reader_create", ORC_BENCH_READER_CREATIONS, ORC_BENCH_READER_CREATIONS * bench.file_bytes, seconds);
+}
+
+/*
+ * benchScan
+ *    Times fetching batches and, separately, converting their rows to
+ *    Datums and NULL flags. Columns with a pack kernel are packed a batch
+ *    at a time, as the scan does; others a value at a time. Bytes of a
+ *    fetch are the file size.
+ */
+static
+void
+benchScan(const BenchCase &bench, const BenchOptions &options)
+{
+    std::vector<double> fetch_seconds;
+    std::vector<double> convert_seconds;
+    std::vector<Datum> values(ORC_DEFAULT_BATCH_SIZE);
+    std::vector<char> isnull(ORC_DEFAULT_BATCH_SIZE);
+    OrcFdwPackKind pack_kind = getPackKind(bench.kind);
+    Datum checksum = 0;
+    uint64_t rows = 0;
+    uint64_t bytes = 0;
+
+    for (int it = 0; it < options.iterations; it++)
+    {
+        orc::ReaderOptions readerOptions;
+        orc::RowReaderOptions rowReaderOptions;
+        ORC_UNIQUE_PTR<orc::Reader> reader;
+        ORC_UNIQUE_PTR<orc::RowReader> rowReader;
+        ORC_UNIQUE_PTR<orc::ColumnVectorBatch> batch;
+        std::chrono::steady_clock::duration fetch(0);
+        std::chrono::steady_clock::duration convert(0);
+
+        (void) orcCreateReader(bench.path, &reader, readerOptions, false);
+        (void) orcCreateRowReader(&reader, &rowReader, rowReaderOptions);
+        batch = rowReader->createRowBatch(ORC_DEFAULT_BATCH_SIZE);
+
+        rows = 0;
+        bytes = 0;
+
+        while (true)
+        {
+            auto start = std::chrono::steady_clock::now();
+            bool hasRows = rowReader->next(*batch);
+            auto fetched = std::chrono::steady_clock::now();
+
+            fetch += fetched - start;
+
+            if (!hasRows)
+                break;
+
+            orc::ColumnVectorBatch *col = dynamic_cast<orc::StructVectorBatch *>(batch.get())->fields[0];
+            uint64_t nrows = batch->numElements;
+
+            /* NULL flags are only expanded when the batch has NULLs */
+            if (col->hasNulls)
+            {
+                orcExpandNulls(col->notNull.data(), nrows, isnull.data());
+                bytes += nrows;
+            }
+
+            if (pack_kind != ORC_PACK_NONE)
+            {
+                orcPackDatums(pack_kind, col, nrows, values.data());
+                bytes += nrows * sizeof(Datum);
+            }
+            else
+            {
+                for (uint64_t row = 0; row < nrows; row++)
+                {
+                    if (col->hasNulls && isnull[row])
+                        values[row] = (Datum) 0;
+                    else
+                        values[row] = convertValue(bench.kind, col, row, &bytes);
+                }
+            }
+
+            for (uint64_t row = 0; row < nrows; row++)
+                checksum ^= values[row];
+
+            bench_sink = checksum;
+            orcBenchResetArena();
+
+            convert += std::chrono::steady_clock::now() - fetched;
+            rows += batch->numElements;
+        }
+
+        fetch_seconds.push_back(std::chrono::duration<double>(fetch).count());
+        convert_seconds.push_back(std::chrono::duration<double>(convert).count());
+    }
+
+    printResult(bench, "batch_fetch", rows, bench.file_bytes, fetch_seconds);
+    printResult(bench, "datum_convert", rows, bytes, convert_seconds);
+}
+
+/*
+ * benchCast
+ *    Times casting each batch to the table types that a batch kernel of
+ *    orc_cast.cpp casts the column to. Casts through server functions
+ *    aren't available without a server and are left out.
+ */
+static
+void
+benchCast(const BenchCase &bench, const BenchOptions &options)
+{
+    std::vector<Datum> values(ORC_DEFAULT_BATCH_SIZE);
+    Oid srcOid = getTypeOid(bench.kind);
+
+    for (auto &target : bench_cast_types)
+    {
+        OrcFdwCastKind cast_kind = orcGetCastKind(srcOid, target.typid);
+        std::vector<double> seconds;
+        std::string name = std::string("cast_") + target.name;
+        Datum checksum = 0;
+        uint64_t rows = 0;
+
+        if (cast_kind == ORC_CAST_NONE || cast_kind == ORC_CAST_INT_TO_NUMERIC
+            || cast_kind == ORC_CAST_DATE_TO_TEXT || cast_kind == ORC_CAST_TIMESTAMP_TO_TEXT
+            || cast_kind == ORC_CAST_TEXT_TO_DATE || cast_kind == ORC_CAST_TEXT_TO_TIMESTAMP)
+            continue;
+
+        for (int it = 0; it < options.iterations; it++)
+        {
+            orc::ReaderOptions readerOptions;
+            orc::RowReaderOptions rowReaderOptions;
+            ORC_UNIQUE_PTR<orc::Reader> reader;
+            ORC_UNIQUE_PTR<orc::RowReader> rowReader;
+            ORC_UNIQUE_PTR<orc::ColumnVectorBatch> batch;
+            std::chrono::steady_clock::duration cast(0);
+
+            (void) orcCreateReader(bench.path, &reader, readerOptions, false);
+            (void) orcCreateRowReader(&reader, &rowReader, rowReaderOptions);
+            batch = rowReader->createRowBatch(ORC_DEFAULT_BATCH_SIZE);
+
+            rows = 0;
+
+            while (rowReader->next(*batch))
+            {
+                orc::ColumnVectorBatch *col = dynamic_cast<orc::StructVectorBatch *>(batch.get())->fields[0];
+                auto start = std::chrono::steady_clock::now();
+
+                orcCastColumn(cast_kind, col, batch->numElements, values.data());
+
+                for (uint64_t row = 0; row < batch->numElements; row++)
+                    checksum ^= values[row];
+
+                cast += std::chrono::steady_clock::now() - start;
+                rows += batch->numElements;
+            }
+
+            bench_sink = checksum;
+            seconds.push_back(std::chrono::duration<double>(cast).count());
+        }
+
+        printResult(bench, name.c_str(), rows, rows * sizeof(Datum), seconds);
+    }
+}
+
+/*
+ * benchFilter
+ *    Times applying a runtime filter built from a sample of the column's
+ *    values to each batch; integer types only.
+ */
+static
+void
+benchFilter(const BenchCase &bench, const BenchOptions &options)
+{
+    std::vector<double> seconds;
+    std::vector<OrcRuntimeFilter> filters(1);
+    std::vector<OrcStringFilter> string_filters;
+    std::vector<uint32_t> sel;
+    uint64_t rows = 0;
+
+    if (!isIntegerKind(bench.kind) || bench.filter_values.empty())
+        return;
+
+    orcBuildRuntimeFilter(filters[0], 0, bench.filter_values);
+
+    for (int it = 0; it < options.iterations; it++)
+    {
+        orc::ReaderOptions readerOptions;
+        orc::RowReaderOptions rowReaderOptions;
+        ORC_UNIQUE_PTR<orc::Reader> reader;
+        ORC_UNIQUE_PTR<orc::RowReader> rowReader;
+        ORC_UNIQUE_PTR<orc::ColumnVectorBatch> batch;
+        std::chrono::steady_clock::duration filter(0);
+
+        (void) orcCreateReader(bench.path, &reader, readerOptions, false);
+        (void) orcCreateRowReader(&reader, &rowReader, rowReaderOptions);
+        batch = rowReader->createRowBatch(ORC_DEFAULT_BATCH_SIZE);
+
+        rows = 0;
+
+        while (rowReader->next(*batch))
+        {
+            auto start = std::chrono::steady_clock::now();
+
+            (void) orcApplyRuntimeFilters(filters, string_filters, dynamic_cast<orc::StructVectorBatch *>(batch.get()), sel);
+
+            filter += std::chrono::steady_clock::now() - start;
+            rows += batch->numElements;
+        }
+
+        seconds.push_back(std::chrono::duration<double>(filter).count());
+    }
+
+    printResult(bench, "runtime_filter", rows, rows * sizeof(int64_t), seconds);
+}
+
+int
+main(int argc, char **argv)
+{
+    BenchOptions options;
+
+    if (!parseOptions(argc, argv, options))
+        return 1;
+
+    std::vector<BenchCase> cases = buildCases(options);
+
+    for (auto &bench : cases)
+    {
+        try
+        {
+            fprintf(stderr, "%s\n", bench.path.c_str());
+
+            writeFile(bench, options.rows);
+
+            benchReaderCreate(bench, options);
+            benchScan(bench, options);
+            benchCast(bench, options);
+            benchFilter(bench, options);
+        }
+        catch (std::exception &err)
+        {
+            fprintf(stderr, "%s: %s\n", bench.path.c_str(), err.what());
+        }
+
+        if (!options.keep)
+            remove(bench.path.c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,21 @@
+/*-------------------------------------------------------------------------
+ *
+ * tupdesc.h
+ *    Stub for the benchmark; everything needed is in postgres.h.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    bench/pg_stub/access/tupdesc.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef __ORC_BENCH_ACCESS_TUPDESC_H
+#define __ORC_BENCH_ACCESS_TUPDESC_H
+
+#include "postgres.h"
+
+#endif
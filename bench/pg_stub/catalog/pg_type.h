@@ -0,0 +1,21 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_type.h
+ *    Stub for the benchmark; everything needed is in postgres.h.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    bench/pg_stub/catalog/pg_type.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef __ORC_BENCH_CATALOG_PG_TYPE_H
+#define __ORC_BENCH_CATALOG_PG_TYPE_H
+
+#include "postgres.h"
+
+#endif
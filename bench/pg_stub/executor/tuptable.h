@@ -0,0 +1,21 @@
+/*-------------------------------------------------------------------------
+ *
+ * tuptable.h
+ *    Stub for the benchmark; everything needed is in postgres.h.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    bench/pg_stub/executor/tuptable.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef __ORC_BENCH_EXECUTOR_TUPTABLE_H
+#define __ORC_BENCH_EXECUTOR_TUPTABLE_H
+
+#include "postgres.h"
+
+#endif
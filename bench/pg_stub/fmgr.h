@@ -0,0 +1,21 @@
+/*-------------------------------------------------------------------------
+ *
+ * fmgr.h
+ *    Stub for the benchmark; everything needed is in postgres.h.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    bench/pg_stub/fmgr.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef __ORC_BENCH_FMGR_H
+#define __ORC_BENCH_FMGR_H
+
+#include "postgres.h"
+
+#endif
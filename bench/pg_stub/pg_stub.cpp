@@ -0,0 +1,148 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_stub.cpp
+ *    Stub of the PostgreSQL server API for building ORC FDW sources into
+ *    the benchmark without a server.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    bench/pg_stub/pg_stub.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+/* C++ header files */
+#include <cstdarg>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/* Stub header files */
+#include "postgres.h"
+
+
+/* Size of an arena block; larger allocations get a block of their own */
+#define ORC_BENCH_ARENA_BLOCK_SIZE (1024 * 1024)
+
+
+/* Arena blocks and the free position in the last one */
+static std::vector<char *> arena_blocks;
+static size_t arena_block_used = ORC_BENCH_ARENA_BLOCK_SIZE;
+static size_t arena_block_size = ORC_BENCH_ARENA_BLOCK_SIZE;
+
+/* Message of the error being reported */
+static std::string error_message;
+
+
+/*
+ * palloc
+ *    Allocates from the arena; freed all at once by orcBenchResetArena.
+ */
+void *
+palloc(size_t size)
+{
+    size = (size + 7) & ~((size_t) 7);
+
+    if (arena_block_used + size > arena_block_size)
+    {
+        arena_block_size = Max((size_t) ORC_BENCH_ARENA_BLOCK_SIZE, size);
+        arena_blocks.push_back(static_cast<char *>(malloc(arena_block_size)));
+        arena_block_used = 0;
+
+        if (arena_blocks.back() == NULL)
+            throw std::bad_alloc();
+    }
+
+    arena_block_used += size;
+    return arena_blocks.back() + arena_block_used - size;
+}
+
+/*
+ * orcBenchResetArena
+ *    Frees everything allocated by palloc.
+ */
+void
+orcBenchResetArena(void)
+{
+    for (auto block = arena_blocks.begin(); block != arena_blocks.end(); block++)
+        free(*block);
+
+    arena_blocks.clear();
+    arena_block_used = ORC_BENCH_ARENA_BLOCK_SIZE;
+    arena_block_size = ORC_BENCH_ARENA_BLOCK_SIZE;
+}
+
+/*
+ * cstring_to_text
+ *    Copies a string into a text allocated by palloc.
+ */
+text *
+cstring_to_text(const char *s)
+{
+    size_t len = strlen(s);
+    text *result = (text *) palloc(VARHDRSZ + len);
+
+    SET_VARSIZE(result, VARHDRSZ + len);
+    memcpy(VARDATA(result), s, len);
+
+    return result;
+}
+
+/*
+ * orcBenchNoFunction
+ *    Throws for a server function called through the function manager.
+ */
+Datum
+orcBenchNoFunction(const char *name)
+{
+    throw std::runtime_error(std::string(name) + " is not available in the benchmark");
+}
+
+Numeric
+int64_to_numeric(int64 val)
+{
+    return (Numeric) orcBenchNoFunction("int64_to_numeric");
+}
+
+int
+errmsg(const char *fmt, ...)
+{
+    char buf[1024];
+    va_list args;
+
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+
+    error_message = buf;
+    return 0;
+}
+
+int
+errhint(const char *fmt, ...)
+{
+    return 0;
+}
+
+int
+errcode(int sqlerrcode)
+{
+    return 0;
+}
+
+/*
+ * orcBenchReport
+ *    Throws for errors; other messages go to stderr.
+ */
+void
+orcBenchReport(int elevel)
+{
+    if (elevel >= ERROR)
+        throw std::runtime_error(error_message);
+
+    fprintf(stderr, "%s\n", error_message.c_str());
+}
@@ -0,0 +1,188 @@
+/*-------------------------------------------------------------------------
+ *
+ * postgres.h
+ *    Stub of the PostgreSQL server API for building ORC FDW sources into
+ *    the benchmark without a server.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ *    Only what the linked sources and the benchmark use is defined here.
+ *    Errors are thrown as C++ exceptions, and palloc allocates from an
+ *    arena that the benchmark resets per batch, much like a per-tuple
+ *    memory context.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    bench/pg_stub/postgres.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef __ORC_BENCH_POSTGRES_H
+#define __ORC_BENCH_POSTGRES_H
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Basic types */
+typedef int16_t int16;
+typedef int32_t int32;
+typedef int64_t int64;
+typedef uint32_t uint32;
+typedef uint64_t uint64;
+typedef unsigned int Oid;
+typedef uintptr_t Datum;
+typedef double Cost;
+typedef float float4;
+typedef double float8;
+typedef int32 DateADT;
+typedef int64 Timestamp;
+typedef struct NumericData *Numeric;
+
+#define PG_VERSION_NUM      140000
+#define SIZEOF_DATUM        8
+#define USE_FLOAT8_BYVAL    1
+
+#define InvalidOid ((Oid) 0)
+
+#define INT64CONST(x)   INT64_C(x)
+#define UINT64CONST(x)  UINT64_C(x)
+#define PG_INT64_MIN    INT64_MIN
+#define PG_INT64_MAX    INT64_MAX
+
+#define Min(x, y)       ((x) < (y) ? (x) : (y))
+#define Max(x, y)       ((x) > (y) ? (x) : (y))
+
+/* Opaque server structures referenced by ORC FDW state */
+typedef struct List List;
+typedef struct FmgrInfo FmgrInfo;
+typedef struct ForeignTable ForeignTable;
+typedef struct TupleTableSlot TupleTableSlot;
+typedef struct Tuplestorestate Tuplestorestate;
+typedef struct TupleDescData *TupleDesc;
+typedef struct MemoryContextData *MemoryContext;
+
+/* Datum conversions; Datums are 8 bytes and passed by value */
+#define BoolGetDatum(X)     ((Datum) ((X) ? 1 : 0))
+#define Int16GetDatum(X)    ((Datum) (int16) (X))
+#define Int32GetDatum(X)    ((Datum) (int32) (X))
+#define Int64GetDatum(X)    ((Datum) (int64) (X))
+#define PointerGetDatum(X)  ((Datum) (X))
+#define ObjectIdGetDatum(X) ((Datum) (X))
+#define DateADTGetDatum(X)  Int32GetDatum(X)
+#define TimestampGetDatum(X) Int64GetDatum(X)
+#define NumericGetDatum(X)  PointerGetDatum(X)
+#define CStringGetDatum(X)  PointerGetDatum(X)
+#define DatumGetCString(X)  ((char *) (X))
+
+static inline Datum
+Float4GetDatum(float X)
+{
+    union { float value; int32 retval; } myunion;
+
+    myunion.value = X;
+    return (Datum) myunion.retval;
+}
+
+static inline Datum
+Float8GetDatum(double X)
+{
+    union { double value; int64 retval; } myunion;
+
+    myunion.value = X;
+    return (Datum) myunion.retval;
+}
+
+/* Dates and timestamps */
+#define POSTGRES_EPOCH_JDATE    2451545
+#define UNIX_EPOCH_JDATE        2440588
+#define SECS_PER_DAY            86400
+#define USECS_PER_SEC           INT64CONST(1000000)
+#define USECS_PER_DAY           INT64CONST(86400000000)
+#define TIMESTAMP_END_JULIAN    109203528
+
+/* Type OIDs of the casts in orc_cast.cpp */
+#define BOOLOID         16
+#define INT8OID         20
+#define INT2OID         21
+#define INT4OID         23
+#define TEXTOID         25
+#define FLOAT4OID       700
+#define FLOAT8OID       701
+#define VARCHAROID      1043
+#define DATEOID         1082
+#define TIMESTAMPOID    1114
+#define NUMERICOID      1700
+
+/* Variable length data with a 4 byte header */
+struct varlena
+{
+    char vl_len_[4];
+    char vl_dat[1];
+};
+
+typedef struct varlena bytea;
+typedef struct varlena text;
+
+#define VARHDRSZ                ((int32) sizeof(int32))
+#define VARDATA(PTR)            (((struct varlena *) (PTR))->vl_dat)
+#define SET_VARSIZE(PTR, len)   (*((uint32 *) (PTR)) = (((uint32) (len)) << 2))
+
+text *cstring_to_text(const char *s);
+
+/*
+ * Server functions aren't available; casts calling them through the
+ * function manager or building numerics throw.
+ */
+Datum orcBenchNoFunction(const char *name);
+Numeric int64_to_numeric(int64 val);
+
+#define DirectFunctionCall1(func, arg1) \
+    ((void) (arg1), orcBenchNoFunction(#func))
+#define DirectFunctionCall3(func, arg1, arg2, arg3) \
+    ((void) (arg1), (void) (arg2), (void) (arg3), orcBenchNoFunction(#func))
+
+/* Allocation from the benchmark arena */
+void *palloc(size_t size);
+void orcBenchResetArena(void);
+
+/* Error reporting; ERROR throws std::runtime_error */
+#define DEBUG1      14
+#define INFO        17
+#define WARNING     19
+#define ERROR       21
+
+#define ERRCODE_DATETIME_VALUE_OUT_OF_RANGE 0
+
+int errmsg(const char *fmt, ...);
+int errhint(const char *fmt, ...);
+int errcode(int sqlerrcode);
+void orcBenchReport(int elevel);
+
+#define ereport(elevel, rest) \
+    do { \
+        (void) rest; \
+        orcBenchReport(elevel); \
+    } while (0)
+
+#define elog(elevel, ...) \
+    do { \
+        (void) errmsg(__VA_ARGS__); \
+        orcBenchReport(elevel); \
+    } while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
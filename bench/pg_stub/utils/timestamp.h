@@ -0,0 +1,21 @@
+/*-------------------------------------------------------------------------
+ *
+ * timestamp.h
+ *    Stub for the benchmark; everything needed is in postgres.h.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    bench/pg_stub/utils/timestamp.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef __ORC_BENCH_UTILS_TIMESTAMP_H
+#define __ORC_BENCH_UTILS_TIMESTAMP_H
+
+#include "postgres.h"
+
+#endif
@@ -0,0 +1,21 @@
+/*-------------------------------------------------------------------------
+ *
+ * tuplestore.h
+ *    Stub for the benchmark; everything needed is in postgres.h.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    bench/pg_stub/utils/tuplestore.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef __ORC_BENCH_UTILS_TUPLESTORE_H
+#define __ORC_BENCH_UTILS_TUPLESTORE_H
+
+#include "postgres.h"
+
+#endif
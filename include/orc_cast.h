@@ -0,0 +1,60 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_cast.h
+ *    Casts of ORC column vectors to the types of foreign table columns.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    include/orc_cast.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef __ORC_CAST_H
+#define __ORC_CAST_H
+
+/* Apache ORC header files */
+#include <orc/Vector.hh>
+
+/* PostgreSQL header files */
+extern "C"
+{
+    #include "postgres.h"
+}
+
+
+/*
+ * Cast of a column whose table type differs from the type read from the
+ * ORC file; e.g. after the schema of the files evolved. Batch kernels
+ * cast a whole column vector at a time; others cast a value at a time
+ * through cached functions.
+ */
+typedef enum OrcFdwCastKind
+{
+    ORC_CAST_NONE = 0,
+
+    /* Batch kernels */
+    ORC_CAST_INT_TO_INT4,
+    ORC_CAST_INT_TO_INT8,
+    ORC_CAST_INT_TO_FLOAT8,
+    ORC_CAST_INT_TO_NUMERIC,
+    ORC_CAST_FLOAT4_TO_FLOAT8,
+    ORC_CAST_DATE_TO_TIMESTAMP,
+    ORC_CAST_TIMESTAMP_TO_DATE,
+    ORC_CAST_DATE_TO_TEXT,
+    ORC_CAST_TIMESTAMP_TO_TEXT,
+    ORC_CAST_TEXT_TO_DATE,
+    ORC_CAST_TEXT_TO_TIMESTAMP,
+
+    /* Cast function, or output and input functions, per value */
+    ORC_CAST_FUNC,
+    ORC_CAST_IO
+} OrcFdwCastKind;
+
+OrcFdwCastKind orcGetCastKind(Oid srcOid, Oid targetOid);
+void orcCastColumn(OrcFdwCastKind kind, orc::ColumnVectorBatch *field, uint64_t rows, Datum *values);
+
+#endif
@@ -31,6 +31,18 @@ extern "C"
 typedef struct OrcFdwPlanState OrcFdwPlanState;
 typedef struct OrcFdwExecState OrcFdwExecState;
 
+/* Operations of predicates pushed down to the ORC reader */
+typedef enum OrcPushdownOp
+{
+	ORC_PUSHDOWN_EQ = 0,
+	ORC_PUSHDOWN_IN,
+	ORC_PUSHDOWN_LT,
+	ORC_PUSHDOWN_LE,
+	ORC_PUSHDOWN_GT,
+	ORC_PUSHDOWN_GE,
+	ORC_PUSHDOWN_PREFIX			/* col LIKE 'prefix%' */
+} OrcPushdownOp;
+
 /* Exported functions */
 void
 classifyConditions(PlannerInfo *root,
@@ -44,6 +56,13 @@ is_foreign_expr(PlannerInfo *root,
 				Expr *expr);
 List *
 build_tlist_to_deparse(RelOptInfo *foreignrel);
+char *
+get_param_pushdown_column(RelOptInfo *baserel,
+						  RestrictInfo *rinfo);
+List *
+build_pushdown_list(RelOptInfo *baserel,
+					List *remote_conds,
+					List **pushdown_exprs);
 
 
 #ifdef __cplusplus
@@ -22,10 +22,10 @@
 /* FDW name */
 #define ORC_FDW_NAME "orc_fdw"
 
-/* Internal version - 1.1.0 - xd major, 3d minor */
-#define ORC_FDW_VERSION  "Highgo ORC FDW - 1.1.0"
+/* Internal version - 1.2.0 - xd major, 3d minor */
+#define ORC_FDW_VERSION  "Highgo ORC FDW - 1.2.0"
 #define ORC_FDW_MAJOR_VERSION   1
-#define ORC_FDW_MINOR_VERSION   0100
+#define ORC_FDW_MINOR_VERSION   0200
 
 
 /* DEFAULT COSTS */
@@ -47,4 +47,45 @@
 /* Default ORC read batch size */
 #define ORC_DEFAULT_BATCH_SIZE 128
 
+/* IN lists with more values are applied as a runtime filter */
+#define ORC_RUNTIME_FILTER_MIN_VALUES 32
+
+/* Bloom filter bits per value of a runtime filter */
+#define ORC_RUNTIME_FILTER_BITS_PER_VALUE 10
+
+/* Default number of tables and files tracked by pg_stat_orc_fdw */
+#define ORC_STATS_DEFAULT_MAX 1000
+
+/* Rows buffered in a row batch before it's added to the ORC writer */
+#define ORC_DEFAULT_WRITE_BATCH_SIZE 1024
+
+/* Full batches of a writer waiting for a write worker */
+#define ORC_WRITE_QUEUED_BATCHES 4
+
+/* Maximum of orc_fdw.write_workers */
+#define ORC_MAX_WRITE_WORKERS 64
+
+/* Default and maximum of orc_fdw.reader_pool_size */
+#define ORC_DEFAULT_READER_POOL_SIZE 64
+#define ORC_MAX_READER_POOL_SIZE 1024
+
+/* Percentage of a file sampled by orc_fdw.sample_method */
+#define ORC_DEFAULT_SAMPLE_PERCENT 100.0
+
+/* Rows fetched from the query of orc_export at a time */
+#define ORC_EXPORT_FETCH_SIZE 10000
+
+/* Defaults of ORC writer table options; same as Apache ORC */
+#define ORC_DEFAULT_STRIPE_SIZE (64 * 1024 * 1024)
+#define ORC_DEFAULT_ROW_INDEX_STRIDE 10000
+#define ORC_DEFAULT_BLOOM_FILTER_FPP 0.05
+
+/* Row index stride of sorted files unless set; smaller row groups have
+ * narrower ranges in their statistics */
+#define ORC_SORTED_ROW_INDEX_STRIDE 5000
+
+/* Number of columns of cluster_by */
+#define ORC_MIN_CLUSTER_COLUMNS 2
+#define ORC_MAX_CLUSTER_COLUMNS 3
+
 #endif
@@ -0,0 +1,75 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_filter.h
+ *    Filters applied by ORC FDW to row batches before rows are converted
+ *    to tuples.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    include/orc_filter.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef __ORC_FILTER_H
+#define __ORC_FILTER_H
+
+/* C++ header files */
+#include <string>
+#include <vector>
+
+/* Apache ORC header files */
+#include <orc/Vector.hh>
+
+
+/*
+ * Runtime filter on an integer or date column; a range and a bloom filter
+ * built from a set of values known only at execution time, e.g. keys of
+ * the build side of a join passed in as an array parameter. Filters for
+ * equality and comparison conditions only have a range.
+ */
+struct OrcRuntimeFilter
+{
+    /* Field of the column in row batch */
+    int field_index;
+
+    /* Range of values */
+    int64_t min;
+    int64_t max;
+
+    /* Bloom filter bits and mask for a word index; empty for a range */
+    std::vector<uint64_t> bloom;
+    uint64_t bloom_mask;
+};
+
+/*
+ * Filter on a string column; a LIKE prefix or a comparison with a value.
+ * Strings are compared by bytes, so comparisons are only used for the C
+ * collation.
+ */
+typedef enum OrcStringFilterOp
+{
+    ORC_STRING_PREFIX = 0,
+    ORC_STRING_LT,
+    ORC_STRING_LE,
+    ORC_STRING_GT,
+    ORC_STRING_GE
+} OrcStringFilterOp;
+
+struct OrcStringFilter
+{
+    /* Field of the column in row batch */
+    int field_index;
+
+    OrcStringFilterOp op;
+    std::string value;
+};
+
+void orcBuildRuntimeFilter(OrcRuntimeFilter &filter, int field_index, const std::vector<int64_t> &values);
+void orcBuildRangeFilter(OrcRuntimeFilter &filter, int field_index, int64_t min, int64_t max);
+int64_t orcApplyRuntimeFilters(const std::vector<OrcRuntimeFilter> &filters, const std::vector<OrcStringFilter> &string_filters, orc::StructVectorBatch *batch, std::vector<uint32_t> &sel);
+
+#endif
@@ -0,0 +1,139 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_instrument.h
+ *    Counters collected while scanning an ORC file and reported by
+ *    EXPLAIN ANALYZE.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    include/orc_instrument.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef __ORC_INSTRUMENT_H
+#define __ORC_INSTRUMENT_H
+
+/* C++ header files */
+#include <ctime>
+#include <string>
+#include <vector>
+
+/* Apache ORC header files */
+#include <orc/MemoryPool.hh>
+#include <orc/OrcFile.hh>
+
+
+/*
+ * Scan counters. These are cheap enough to be collected for every scan;
+ * times are taken from a coarse clock around whole batches or rows.
+ */
+struct OrcFdwScanStats
+{
+    /* Executions of the scan, including rescans */
+    uint64_t scans = 0;
+
+    /* Stripes of the file that were read or skipped */
+    uint64_t stripes_read = 0;
+    uint64_t stripes_skipped = 0;
+
+    /* Bytes read from the file and time spent in reads */
+    uint64_t bytes_read = 0;
+    uint64_t io_ns = 0;
+
+    /* Time spent in the row reader, including I/O and decompression */
+    uint64_t next_ns = 0;
+
+    /* Time spent filtering rows and converting them to Datums */
+    uint64_t convert_ns = 0;
+
+    /* Batches fetched and rows in them */
+    uint64_t batches = 0;
+    uint64_t batch_rows = 0;
+
+    /* Rows returned from the scan */
+    uint64_t rows_returned = 0;
+
+    /* Rows dropped by runtime filters, string filters and sampling */
+    uint64_t rows_filtered = 0;
+
+    /* Readers taken from the reader pool with the file footer parsed */
+    uint64_t reader_pool_hits = 0;
+
+    /* First row number of each stripe and the stripe being read; -1 if
+     * no stripe has been read since the row reader was positioned */
+    std::vector<uint64_t> stripe_first_row;
+    int64_t curr_stripe = -1;
+};
+
+/*
+ * Input stream that counts bytes read from the underlying stream and the
+ * time spent reading them. A pooled reader keeps its stream, so the
+ * counters are switched to the scan using the reader; none if NULL.
+ */
+class OrcCountingInputStream : public orc::InputStream
+{
+public:
+    OrcCountingInputStream(ORC_UNIQUE_PTR<orc::InputStream> stream, OrcFdwScanStats *stats);
+
+    uint64_t getLength() const override;
+    uint64_t getNaturalReadSize() const override;
+    void read(void *buf, uint64_t length, uint64_t offset) override;
+    const std::string &getName() const override;
+
+    void setStats(OrcFdwScanStats *stats);
+
+private:
+    ORC_UNIQUE_PTR<orc::InputStream> stream;
+    OrcFdwScanStats *stats;
+};
+
+/*
+ * Memory pool for the ORC reader that keeps track of the peak amount of
+ * memory allocated.
+ */
+class OrcTrackingMemoryPool : public orc::MemoryPool
+{
+public:
+    OrcTrackingMemoryPool();
+
+    char *malloc(uint64_t size) override;
+    void free(char *p) override;
+
+    uint64_t getPeak() const;
+    void resetPeak();
+
+private:
+    uint64_t allocated;
+    uint64_t peak;
+};
+
+/*
+ * orcClockNs
+ *    Coarse monotonic clock; a few nanoseconds to read, so it may be used
+ *    per row. Its resolution is a clock tick, but sums over many short
+ *    intervals still average out to the time spent.
+ */
+static inline
+uint64_t
+orcClockNs(void)
+{
+    struct timespec ts;
+
+#ifdef CLOCK_MONOTONIC_COARSE
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+
+    return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+void orcScanStatsSetStripes(OrcFdwScanStats &stats, ORC_UNIQUE_PTR<orc::Reader> *p_reader);
+void orcScanStatsBatch(OrcFdwScanStats &stats, uint64_t first_row, uint64_t rows);
+void orcScanStatsEnd(OrcFdwScanStats &stats);
+
+#endif
@@ -17,12 +17,16 @@
 #define __ORC_INTERFACE_TYPEDEFS_H
 
 /* C++ header files */
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 /* Apache ORC header files */
 #include <orc/OrcFile.hh>
 #include <orc/Type.hh>
+#include <orc/Writer.hh>
+#include <orc/sargs/SearchArgument.hh>
 
 /* PostgreSQL header files */
 extern "C"
@@ -30,9 +34,16 @@ extern "C"
     #include "postgres.h"
     #include "fmgr.h"
     #include "access/tupdesc.h"
+    #include "executor/tuptable.h"
     #include "foreign/foreign.h"
+    #include "utils/tuplestore.h"
 }
 
+/* ORC FDW header files */
+#include <orc_cast.h>
+#include <orc_kernels.h>
+#include <orc_sample.h>
+
 /* To be used for mapping of ORC to PG data types */
 typedef enum OrcPgTypeKind
 {
@@ -46,9 +57,9 @@ typedef enum OrcPgTypeKind
     STRING = 7,
     BINARY = 8,
     TIMESTAMP = 9,
-    LIST_UNSUPPORTED = 10,       // UNSUPPORTED; ORC Type = LIST
-    MAP_UNSUPPORTED = 11,        // UNSUPPORTED; ORC Type = MAP
-    STRUCT_UNSUPPORTED = 12,     // UNSUPPORTED; ORC Type = STRUCT
+    LIST = 10,
+    MAP = 11,
+    STRUCT = 12,
     UNION_UNSUPPORTED = 13,      // UNSUPPORTED; ORC Type = UNION
     DECIMAL = 14,
     DATE = 15,
@@ -63,21 +74,25 @@ typedef enum OrcPgTypeKind
  * Column meta data in ORC file
  * - column name
  * - index in ORC file
+ * - column id in ORC type tree
  * - column ORC type
  * - max_length
  * - precision
  * - scale
  * - has NULLs?
+ * - children of LIST (element), MAP (key, value) and STRUCT (fields)
  */
 struct OrcFileColInfo
 {
     int index;
+    uint64_t col_id;
     std::string name;
     orc::TypeKind kind;
     int64_t max_length;
     int precision;
     int scale;
     bool hasNull;
+    std::vector<OrcFileColInfo> children;
 };
 
 /* Column information for supported columns in ORC file:
@@ -93,6 +108,7 @@ struct OrcFileColInfo
 struct OrcFdwColInfo
 {
     int index;
+    uint64_t col_id;
     std::string name;
     OrcPgTypeKind kind;
     Oid col_oid;
@@ -105,11 +121,109 @@ struct OrcFdwColInfo
     int precision;
     int scale;
 
-    /* Function for typecasting data from ORC to PG */
+    /* Function for typecasting data from ORC to PG; for casts through
+     * text, the output function, with the input function in
+     * cast_in_func */
     FmgrInfo *cast_func;
     bool is_binary_compatible;
+    OrcFdwCastKind cast_kind;
+    FmgrInfo *cast_in_func;
+    Oid cast_ioparam;
+
+    /* Values and NULL flags of the current batch, packed or cast by a
+     * batch kernel the first time a row of the batch is read */
+    OrcFdwPackKind pack_kind;
+    std::vector<Datum> batch_values;
+    std::vector<char> batch_isnull;
+    bool batch_staged;
+    bool batch_has_nulls;
+
+    /* Element of LIST, key and value of MAP, and fields of STRUCT */
+    std::vector<OrcFdwColInfo> children;
+
+    /* Storage of the element type of a LIST read as an array */
+    int16 typlen;
+    bool typbyval;
+    char typalign;
+
+    /* STRUCT read as a composite type; the field of each attribute of
+     * the type, or -1 if the attribute is NULL */
+    TupleDesc tupdesc;
+    std::vector<int> field_index;
+};
+
+/*
+ * Mappable columns of an ORC file with a case insensitive index of their
+ * names; built by the first planner of a file and kept with its pooled
+ * reader, so planning doesn't depend on the width of the file.
+ */
+struct OrcFdwFileColumns
+{
+    std::vector<OrcFdwColInfo> cols_info;
+
+    /* Column can look up values through bloom filters or stripe
+     * statistics */
+    std::vector<bool> lookup;
+
+    /* Position in cols_info by name folded to lower case */
+    std::unordered_map<std::string, int> positions;
+};
+
+
+/*
+ * Overlap of the minimum and maximum values of a column between stripes.
+ * overlap is the fraction of other stripes whose range overlaps a
+ * stripe's, averaged over stripes; 0 for a file sorted on the column.
+ */
+struct OrcFdwStripeOverlap
+{
+    /* Stripes with statistics for the column */
+    uint64_t stripes;
+    double overlap;
+    uint64_t max_overlapping;
+};
+
+/*
+ * Table options used when writing an ORC file; set to defaults by
+ * orcInitWriteOptions and overridden by table options.
+ */
+struct OrcFdwWriteOptions
+{
+    /* Bytes of encoded data buffered before a stripe is written */
+    uint64_t stripe_size;
+
+    /* Rows in a row group; 0 writes no row index */
+    uint64_t row_index_stride;
+    bool row_index_stride_set;
+
+    orc::CompressionKind compression;
+    orc::CompressionStrategy compression_strategy;
+
+    /* Names of columns to write bloom filters for and their false
+     * positive probability */
+    List *bloom_filter_columns;
+    double bloom_filter_fpp;
+
+    /* Rows of an INSERT are sorted on sort_by columns, or on the z-order
+     * of cluster_by columns, before they're written */
+    List *sort_by;
+    List *cluster_by;
+
+    /* Threads encoding batches; 0 encodes on the backend. Set from
+     * orc_fdw.write_workers rather than a table option */
+    int workers;
 };
 
+/*
+ * Scans that need no column values. Rows come from the row count in the
+ * file footer, so no stripe is read.
+ */
+enum OrcFdwZeroColumns
+{
+    ORC_ZERO_COLUMNS_NONE = 0,  /* columns are read */
+    ORC_ZERO_COLUMNS_ROWS,      /* a row without values per row of the file */
+    ORC_ZERO_COLUMNS_COUNT      /* one row of count(*) for the whole file */
+};
 
 /* ORC FDW - Internal Plan State */
 struct OrcFdwPlanState
@@ -128,20 +242,60 @@ struct OrcFdwPlanState
     List *col_orc_oid;
     List *col_orc_file_index;
 
+    /* Columns of the ORC file; released with the planner's memory */
+    std::shared_ptr<const OrcFdwFileColumns> *file_columns;
+
+    /* ORC column ids to read when struct columns are only used through
+     * some of their fields; NIL reads col_orc_file_index columns */
+    List *col_orc_type_ids;
+
+    /* ORC column names that are sorted or have bloom filters */
+    List *col_orc_lookup;
+
+    /* No column of the table is required by the query */
+    bool zero_columns;
+
+    /* Layout of the ORC file used for costing */
+    uint64_t stripes;
+    uint64_t row_index_stride;
+
+    /* Sampling of the scan; orc_fdw.sample_* when planned */
+    OrcFdwSampleMethod sample_method;
+    double sample_percent;
+    int sample_seed;
+
     bool hasAggregate;
     bool hasJoins;
     char *filename;
+
+    /* Table option; cache rows for rescans */
+    bool rescan_cache;
+
+    /* Table options for INSERT */
+    OrcFdwWriteOptions write_options;
 };
 
+/* ORC FDW header files */
+#include <orc_filter.h>
+#include <orc_instrument.h>
+
 /* ORC FDW - Internal State */
 struct OrcFdwExecState
 {
-	orc::ReaderOptions options;
-	ORC_UNIQUE_PTR<orc::Reader> reader;
+    /* Scan counters; the memory pool and metrics are those of the
+     * pooled reader */
+    OrcFdwScanStats stats;
+    OrcTrackingMemoryPool *memory_pool;
+    orc::ReaderMetrics *metrics;
+
+    /* Reader checked out of the reader pool until the scan ends; the
+     * reader, row reader and batch are those of the pool entry */
+    struct OrcPooledReader *pooled_reader;
+	ORC_UNIQUE_PTR<orc::Reader> *reader;
 
 	orc::RowReaderOptions rowReaderOptions;
-	ORC_UNIQUE_PTR<orc::RowReader> rowReader;
-	ORC_UNIQUE_PTR<orc::ColumnVectorBatch> batch;
+	ORC_UNIQUE_PTR<orc::RowReader> *rowReader;
+	ORC_UNIQUE_PTR<orc::ColumnVectorBatch> *batch;
 
     orc::StructVectorBatch *batch_data;
 
@@ -153,27 +307,75 @@ struct OrcFdwExecState
     /* Columns data */
     std::vector<OrcFdwColInfo> cols_info;
 
+    /* Holds values staged by batch kernels; reset with each batch */
+    MemoryContext batch_cxt;
+
     /* Pathname of the ORC file */
     std::string filename;
 
+    /* Foreign table; counters are reported for it unless EXPLAIN only */
+    Oid relid;
+    bool report_stats;
+
     /* Batch size for fetching */
     int64_t batchsize;
 
-     /* Number of rows in current batch; -1 = no batch fetched */
+     /* Number of rows in current batch that passed runtime filters;
+      * -1 = no batch fetched */
     int64_t curr_batch_total_rows;
 
     /* Batch number and row number in batch */
     int curr_batch_number;
     int64_t curr_batch_row_num;
 
+    /* Rows of current batch that passed runtime filters and position of
+     * the next one to return */
+    std::vector<uint32_t> curr_batch_sel;
+    int64_t curr_batch_sel_pos;
+
+    /* Rows of current batch are those in curr_batch_sel, rather than all */
+    bool curr_batch_has_sel;
+
     /* Current row number */
     int64_t row_num;
 
     /* Total number of rows */
     int64_t total_rows;
 
+    /* Rows are made from total_rows without reading the file */
+    OrcFdwZeroColumns zero_columns;
+
+    /* Rows and row groups kept by sampling */
+    OrcFdwSample sample;
+
     /* Numeric data type defaults */
     int default_numeric_scale;
+
+    /* Pushdown predicates and their value expression states */
+    List *pushdown;
+    List *pushdown_exprs;
+
+    /* Row reader must be recreated with a new search argument */
+    bool pushdown_pending;
+
+    /* Runtime filters built from large IN lists and from equality and
+     * comparison conditions on integer and date columns */
+    std::vector<OrcRuntimeFilter> runtime_filters;
+
+    /* Filters from LIKE prefixes and comparisons on string columns */
+    std::vector<OrcStringFilter> string_filters;
+
+    /* Rows cached for rescans; NULL if rescan_cache is off */
+    Tuplestorestate *rescan_cache;
+    TupleTableSlot *rescan_cache_slot;
+
+    /* Cache holds all rows of the scan; rescans replay the cache */
+    bool rescan_cache_complete;
+    bool rescan_cache_replay;
 };
 
+/* Column name lookup */
+std::string orcFoldColumnName(const char *name);
+const OrcFdwColInfo *orcFindFileColumn(const OrcFdwPlanState *fdw_state, const char *name);
+
 #endif
@@ -0,0 +1,51 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_kernels.h
+ *    Kernels packing ORC column vectors into Datums and NULL flags.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    include/orc_kernels.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef __ORC_KERNELS_H
+#define __ORC_KERNELS_H
+
+/* Apache ORC header files */
+#include <orc/Vector.hh>
+
+/* PostgreSQL header files */
+extern "C"
+{
+    #include "postgres.h"
+}
+
+
+/*
+ * Datum packing of a column read without a cast. Integer, boolean and
+ * date columns are decoded into int64 LongVectorBatch data; float and
+ * double columns into DoubleVectorBatch data.
+ */
+typedef enum OrcFdwPackKind
+{
+    ORC_PACK_NONE = 0,
+    ORC_PACK_INT2,
+    ORC_PACK_INT4,
+    ORC_PACK_INT8,
+    ORC_PACK_BOOL,
+    ORC_PACK_DATE,
+    ORC_PACK_FLOAT4,
+    ORC_PACK_FLOAT8
+} OrcFdwPackKind;
+
+void orcPackDatums(OrcFdwPackKind kind, orc::ColumnVectorBatch *field, uint64_t rows, Datum *values);
+void orcPackDatumRange(OrcFdwPackKind kind, orc::ColumnVectorBatch *field, uint64_t first, uint64_t rows, Datum *values);
+void orcExpandNulls(const char *notNull, uint64_t rows, char *isnull);
+bool orcKernelsUseAvx2(void);
+
+#endif
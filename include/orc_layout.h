@@ -0,0 +1,37 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_layout.h
+ *    Sorting rows before they're written and measuring how well stripes
+ *    of a file can be skipped.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    include/orc_layout.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef __ORC_LAYOUT_H
+#define __ORC_LAYOUT_H
+
+/* ORC FDW header files */
+#include <orc_writer.h>
+
+/* PostgreSQL header files */
+extern "C"
+{
+    #include "executor/tuptable.h"
+}
+
+
+/* Rows of an INSERT being sorted; allocated in the current memory context */
+typedef struct OrcFdwSortState OrcFdwSortState;
+
+OrcFdwSortState *orcBeginSort(TupleDesc tupdesc, const OrcFdwWriteOptions *options);
+void orcSortPutSlot(OrcFdwSortState *state, TupleTableSlot *slot);
+void orcSortFinish(OrcFdwSortState *state, OrcFdwWriter *writer);
+
+#endif
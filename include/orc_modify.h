@@ -0,0 +1,51 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_modify.h
+ *    INSERT into ORC foreign tables.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    include/orc_modify.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef __ORC_MODIFY_H
+#define __ORC_MODIFY_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* PostgreSQL header files */
+#include "postgres.h"
+#include "foreign/fdwapi.h"
+
+
+/* Defines the settings of INSERT; called from _PG_init */
+void orcModifyInit(void);
+
+/* FDW functions */
+int orcIsForeignRelUpdatable(Relation rel);
+List *orcPlanForeignModify(PlannerInfo *root, ModifyTable *plan, Index resultRelation, int subplan_index);
+void orcBeginForeignModify(ModifyTableState *mstate, ResultRelInfo *rinfo, List *fdw_private, int subplan_index, int eflags);
+TupleTableSlot *orcExecForeignInsert(EState *estate, ResultRelInfo *rinfo, TupleTableSlot *slot, TupleTableSlot *planSlot);
+void orcEndForeignModify(EState *estate, ResultRelInfo *rinfo);
+void orcBeginForeignInsert(ModifyTableState *mstate, ResultRelInfo *rinfo);
+void orcEndForeignInsert(EState *estate, ResultRelInfo *rinfo);
+void orcExplainForeignModify(ModifyTableState *mstate, ResultRelInfo *rinfo, List *fdw_private, int subplan_index, struct ExplainState *es);
+
+#if PG_VERSION_NUM >= 140000
+int orcGetForeignModifyBatchSize(ResultRelInfo *rinfo);
+TupleTableSlot **orcExecForeignBatchInsert(EState *estate, ResultRelInfo *rinfo, TupleTableSlot **slots, TupleTableSlot **planSlots, int *numSlots);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,87 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_pool.h
+ *    Per backend pool of ORC file readers reused across scans.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    include/orc_pool.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef __ORC_POOL_H
+#define __ORC_POOL_H
+
+#ifdef __cplusplus
+
+/* system header files */
+#include <sys/stat.h>
+
+/* C++ header files */
+#include <string>
+
+/* ORC FDW header files */
+#include <orc_interface_typedefs.h>
+#include <orc_instrument.h>
+
+/* PostgreSQL header files */
+extern "C"
+{
+    #include "postgres.h"
+}
+
+
+/*
+ * An open ORC file with its parsed footer. The file is identified by its
+ * device, inode, size and modification time, so a file that's replaced or
+ * rewritten isn't read through a stale reader. The memory pool and the
+ * metrics are set in the reader options, so they must outlive the reader.
+ * A scan borrows the reader and keeps its row reader and batch here too,
+ * so that all of them are destroyed and the file closed if it aborts.
+ */
+struct OrcPooledReader
+{
+    std::string filename;
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    struct timespec mtime;
+
+    OrcTrackingMemoryPool memory_pool;
+    orc::ReaderMetrics metrics;
+
+    /* Owned by the reader */
+    OrcCountingInputStream *stream;
+    ORC_UNIQUE_PTR<orc::Reader> reader;
+
+    /* Columns of the file; NULL until the file is planned */
+    std::shared_ptr<const OrcFdwFileColumns> columns;
+
+    /* Of the scan the reader is checked out by; destroyed first */
+    ORC_UNIQUE_PTR<orc::RowReader> row_reader;
+    ORC_UNIQUE_PTR<orc::ColumnVectorBatch> batch;
+
+    /* Checked out by a scan, and the subtransaction that checked it out */
+    bool in_use;
+    SubTransactionId subid;
+};
+
+OrcPooledReader *orcReaderPoolCheckout(const std::string &filename, OrcFdwScanStats *stats, bool *hit);
+void orcReaderPoolCheckin(OrcPooledReader *entry);
+
+extern "C"
+{
+#endif
+
+/* Defines orc_fdw.reader_pool_size; called from _PG_init */
+void orcReaderPoolInit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,82 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_sample.h
+ *    Seeded SYSTEM and BERNOULLI sampling of ORC foreign table scans.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    include/orc_sample.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef __ORC_SAMPLE_H
+#define __ORC_SAMPLE_H
+
+/* Sampling methods; orc_fdw.sample_method */
+typedef enum OrcFdwSampleMethod
+{
+    ORC_SAMPLE_NONE = 0,
+    ORC_SAMPLE_SYSTEM,
+    ORC_SAMPLE_BERNOULLI
+} OrcFdwSampleMethod;
+
+#ifdef __cplusplus
+
+/* C++ header files */
+#include <utility>
+#include <vector>
+
+/* Apache ORC header files */
+#include <orc/OrcFile.hh>
+
+
+/*
+ * Sampling state of a scan. SYSTEM keeps whole row groups, or stripes of
+ * files without a row index, and the scan seeks over the others; ranges
+ * are the rows of kept groups, with adjacent groups merged. BERNOULLI
+ * keeps single rows and reads the whole file. Either keeps a group or
+ * row if the hash of its first row number and the seed is below the
+ * sampled fraction, so a seed always gives the same sample of a file.
+ */
+struct OrcFdwSample
+{
+    OrcFdwSampleMethod method;
+    uint64_t threshold;
+    uint64_t seed;
+
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    size_t curr_range;
+
+    /* The row after the last batch read */
+    uint64_t next_row;
+};
+
+void orcSampleSetup(OrcFdwSample &sample, OrcFdwSampleMethod method, double percent, int seed, ORC_UNIQUE_PTR<orc::Reader> *p_reader);
+void orcSampleRestart(OrcFdwSample &sample);
+bool orcSampleSeek(OrcFdwSample &sample, orc::RowReader *rowReader);
+int64_t orcSampleBatch(OrcFdwSample &sample, uint64_t first_row, uint64_t rows, std::vector<uint32_t> &sel, int64_t nsel, bool has_sel);
+uint64_t orcSampleNextRow(OrcFdwSample &sample, uint64_t row, uint64_t total_rows);
+double orcSampleReadFraction(OrcFdwSampleMethod method, double percent);
+const char *orcSampleMethodName(OrcFdwSampleMethod method);
+
+extern "C"
+{
+#endif
+
+/* Sampling of scans planned now; set with orc_fdw.sample_* */
+extern int orc_sample_method;
+extern double orc_sample_percent;
+extern int orc_sample_seed;
+
+/* Defines orc_fdw.sample_*; called from _PG_init */
+void orcSampleInit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
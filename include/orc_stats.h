@@ -0,0 +1,50 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_stats.h
+ *    Cumulative scan statistics of ORC foreign tables kept in shared
+ *    memory.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    include/orc_stats.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef __ORC_STATS_H
+#define __ORC_STATS_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* PostgreSQL header files */
+#include "postgres.h"
+
+
+/* Counters of a scan added to the table and file entry when it ends */
+typedef struct OrcStatsCounters
+{
+    int64 scans;
+    int64 rows_returned;
+    int64 rows_filtered;
+    int64 stripes_read;
+    int64 stripes_skipped;
+    int64 bytes_read;
+    double io_time;         /* in msec */
+    double decode_time;     /* in msec */
+    int64 metadata_cache_hits;
+} OrcStatsCounters;
+
+void orcStatsInit(void);
+void orcStatsReport(Oid relid, const char *filename, const OrcStatsCounters *counters);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,31 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_workers.h
+ *    Pool of threads encoding ORC data for writers of a backend.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    include/orc_workers.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef __ORC_WORKERS_H
+#define __ORC_WORKERS_H
+
+/* C++ header files */
+#include <functional>
+
+
+/*
+ * Tasks run on threads of the backend that must not call PostgreSQL
+ * functions; they only work on Apache ORC objects. Threads are started
+ * on first use and kept for the life of the backend.
+ */
+void orcWorkersResize(int workers);
+void orcWorkersSubmit(std::function<void()> task);
+
+#endif
@@ -17,16 +17,20 @@
 #define __ORC_WRAPPER_H
 
 /* C++ header files */
+#include <set>
 #include <string>
 #include <vector>
 
 /* ORC FDW header files */
 #include <orc_interface_typedefs.h>
+#include <orc_instrument.h>
 
 bool orcCreateReader(std::string filename, 
                     ORC_UNIQUE_PTR<orc::Reader> *p_reader, 
                     orc::ReaderOptions &options,
-                    bool blnVersionWarn);
+                    bool blnVersionWarn,
+                    OrcFdwScanStats *stats = NULL);
+void orcWarnUnsupportedVersion(const std::string &filename, ORC_UNIQUE_PTR<orc::Reader> *p_reader);
 bool orcCreateRowReader(ORC_UNIQUE_PTR<orc::Reader> *p_reader, 
                     ORC_UNIQUE_PTR<orc::RowReader> *p_rowReader, 
                     orc::RowReaderOptions &rowReaderOptions);
@@ -36,5 +40,9 @@ std::vector<OrcFileColInfo> orcGetColsInfo(std::string file_pathname, ORC_UNIQUE
 std::vector<OrcFileColInfo> orcGetColsInfo(ORC_UNIQUE_PTR<orc::Reader> *p_reader, ORC_UNIQUE_PTR<orc::RowReader> *p_rowReader, orc::StructVectorBatch *root);
 uint64_t orcGetNumberOfRows(ORC_UNIQUE_PTR<orc::Reader> *p_reader);
 int orcGetDefaultDecimalScale(ORC_UNIQUE_PTR<orc::Reader> *p_reader);
+std::set<uint64_t> orcGetBloomFilterColumns(ORC_UNIQUE_PTR<orc::Reader> *p_reader);
+std::vector<bool> orcGetSortedColumns(ORC_UNIQUE_PTR<orc::Reader> *p_reader, const std::vector<uint64_t> &col_ids, const std::vector<orc::TypeKind> &kinds);
+bool orcGetStripeOverlap(ORC_UNIQUE_PTR<orc::Reader> *p_reader, uint64_t col_id, orc::TypeKind kind, OrcFdwStripeOverlap *overlap);
+uint64_t orcGetRowIndexStride(ORC_UNIQUE_PTR<orc::Reader> *p_reader);
 
 #endif
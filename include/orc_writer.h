@@ -0,0 +1,129 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_writer.h
+ *    Writes rows of PostgreSQL tuples to an ORC file.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    include/orc_writer.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef __ORC_WRITER_H
+#define __ORC_WRITER_H
+
+/* C++ header files */
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/* Apache ORC header files */
+#include <orc/OrcFile.hh>
+#include <orc/Writer.hh>
+
+/* ORC FDW header files */
+#include <orc_interface_typedefs.h>
+
+/* PostgreSQL header files */
+extern "C"
+{
+    #include "nodes/parsenodes.h"
+}
+
+
+/*
+ * Column of the written file; attnum is the attribute of the tuple
+ * holding its value, or -1 if the column is always NULL.
+ */
+struct OrcFdwWriteCol
+{
+    int attnum;
+    OrcPgTypeKind kind;
+    int precision;
+    int scale;
+};
+
+/*
+ * Row batch with the variable length values of its columns; the batch
+ * points into var_data once full.
+ */
+struct OrcFdwWriteBatch
+{
+    ORC_UNIQUE_PTR<orc::ColumnVectorBatch> batch;
+    std::vector<std::vector<char>> var_data;
+};
+
+/*
+ * Buffers rows into a row batch and adds the batch to the ORC writer when
+ * full. The ORC writer encodes batches into stripes of stripe_size. Without
+ * a tuple descriptor, rows can only be copied from other files.
+ *
+ * With write workers, full batches are queued and added to the ORC writer
+ * on a worker thread, in order, while the backend fills the next batch.
+ * The worker thread only touches the ORC writer and the queued batches.
+ */
+class OrcFdwWriter
+{
+public:
+    OrcFdwWriter(const std::string &filename, const orc::Type &type, TupleDesc tupdesc, const OrcFdwWriteOptions &options);
+    ~OrcFdwWriter();
+
+    void addRow(Datum *values, bool *isnull);
+    void appendFile(const std::string &filename);
+    void appendReader(ORC_UNIQUE_PTR<orc::Reader> *reader, const std::string &filename);
+    void close();
+
+    const std::string &getFilename() const { return filename; }
+    uint64_t getRowsWritten() const { return rows_written; }
+    uint64_t getRowsCopied() const { return rows_copied; }
+
+private:
+    void setValue(OrcFdwWriteCol &col, orc::ColumnVectorBatch *field, std::vector<char> &var_data, Datum value);
+    void flush();
+    void nextBatch();
+    void encodeBatches();
+    void waitForWorker();
+
+
+    std::string filename;
+    ORC_UNIQUE_PTR<orc::Type> type;
+    ORC_UNIQUE_PTR<orc::OutputStream> out;
+    ORC_UNIQUE_PTR<orc::Writer> writer;
+
+    std::vector<OrcFdwWriteCol> cols;
+
+    /* Memory of values converted for the row being added */
+    MemoryContext row_cxt;
+
+    /* Batch being filled; others are free or queued for the worker */
+    std::vector<OrcFdwWriteBatch> batches;
+    size_t current;
+    orc::StructVectorBatch *batch_data;
+
+    /* Protects the members below, shared with the worker thread */
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<size_t> queued;
+    std::vector<size_t> free_batches;
+    bool encoding;
+    bool cancelled;
+    std::string error;
+    int workers;
+
+    /* Rows in the batch and rows written in total */
+    uint64_t batch_rows;
+    uint64_t rows_written;
+    uint64_t rows_copied;
+};
+
+void orcInitWriteOptions(OrcFdwWriteOptions *options);
+bool orcParseWriteOption(DefElem *def, OrcFdwWriteOptions *options);
+ORC_UNIQUE_PTR<orc::Type> orcGetTypeForTupleDesc(TupleDesc tupdesc);
+
+#endif
@@ -0,0 +1,71 @@
+/* orc_fdw--1.1.0--1.2.0.sql */
+
+-- complain if script is sourced in psql, rather than via ALTER EXTENSION
+\echo Use "ALTER EXTENSION orc_fdw UPDATE TO '1.2.0'" to load this file. \quit
+
+CREATE FUNCTION pg_stat_orc_fdw(
+    OUT dbid oid,
+    OUT relid oid,
+    OUT filename text,
+    OUT scans int8,
+    OUT rows_returned int8,
+    OUT rows_filtered int8,
+    OUT stripes_read int8,
+    OUT stripes_skipped int8,
+    OUT bytes_read int8,
+    OUT io_time float8,
+    OUT decode_time float8,
+    OUT metadata_cache_hits int8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT VOLATILE;
+
+CREATE VIEW pg_stat_orc_fdw AS
+  SELECT * FROM pg_stat_orc_fdw();
+
+CREATE FUNCTION pg_stat_orc_fdw_reset()
+RETURNS void
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+REVOKE ALL ON FUNCTION pg_stat_orc_fdw_reset() FROM PUBLIC;
+
+CREATE FUNCTION orc_file_prunability(
+    filename text,
+    OUT column_name text,
+    OUT stripes int8,
+    OUT overlap float8,
+    OUT max_overlapping_stripes int8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT VOLATILE;
+
+REVOKE ALL ON FUNCTION orc_file_prunability(text) FROM PUBLIC;
+
+CREATE FUNCTION orc_compact(
+    source_dir text,
+    target_file text,
+    options text[] DEFAULT '{}',
+    OUT filename text,
+    OUT rows int8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT VOLATILE;
+
+REVOKE ALL ON FUNCTION orc_compact(text, text, text[]) FROM PUBLIC;
+
+CREATE FUNCTION orc_export(
+    query text,
+    path text,
+    options jsonb DEFAULT '{}',
+    OUT filename text,
+    OUT rows int8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C STRICT VOLATILE;
+
+REVOKE ALL ON FUNCTION orc_export(text, text, jsonb) FROM PUBLIC;
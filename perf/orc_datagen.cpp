@@ -0,0 +1,397 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_datagen.cpp
+ *    Generates a star schema of ORC files for the ORC FDW performance
+ *    suite.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ *    Writes a sales fact table and customer, product, store and date
+ *    dimensions. The fact table is written in three variants:
+ *    - sales_sorted: rows sorted on customer_id
+ *    - sales_unsorted: rows in random order
+ *    - sales_bloom: rows in random order with bloom filters on
+ *      customer_id and product_id
+ *
+ *    Values are generated from a fixed seed, so files of the same scale
+ *    are identical across runs.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    perf/orc_datagen.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+/* C++ header files */
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+/* Apache ORC header files */
+#include <orc/OrcFile.hh>
+#include <orc/Writer.hh>
+
+
+/* Rows written per batch */
+#define DATAGEN_BATCH_SIZE 8192
+
+/* Fact rows and customers at scale 1 */
+#define DATAGEN_SALES_PER_SCALE 20000000
+#define DATAGEN_CUSTOMERS_PER_SCALE 100000
+
+/* Sizes of the fixed dimensions */
+#define DATAGEN_PRODUCTS 20000
+#define DATAGEN_STORES 1000
+#define DATAGEN_DAYS 3650
+
+/* 2015-01-01 in days since the UNIX epoch */
+#define DATAGEN_FIRST_DAY 16436
+
+
+/* Options given on the command line */
+struct DatagenOptions
+{
+    double scale = 1.0;
+    std::string dir = ".";
+    orc::CompressionKind codec = orc::CompressionKind_ZSTD;
+};
+
+/*
+ * Writes rows of a table a batch at a time; values are set by column
+ * and the batch is written once full.
+ */
+class TableWriter
+{
+public:
+    TableWriter(const std::string &path, const std::string &schema, const orc::WriterOptions &options)
+        : type(orc::Type::buildTypeFromString(schema)),
+          out(orc::writeLocalFile(path)),
+          writer(orc::createWriter(*type, out.get(), options)),
+          batch(writer->createRowBatch(DATAGEN_BATCH_SIZE)),
+          root(dynamic_cast<orc::StructVectorBatch *>(batch.get())),
+          strings(root->fields.size(), std::vector<std::string>(DATAGEN_BATCH_SIZE)),
+          row(0)
+    {
+    }
+
+    void setLong(int col, int64_t value)
+    {
+        dynamic_cast<orc::LongVectorBatch *>(root->fields[col])->data[row] = value;
+    }
+
+    void setDouble(int col, double value)
+    {
+        dynamic_cast<orc::DoubleVectorBatch *>(root->fields[col])->data[row] = value;
+    }
+
+    void setString(int col, const std::string &value)
+    {
+        orc::StringVectorBatch *s = dynamic_cast<orc::StringVectorBatch *>(root->fields[col]);
+
+        strings[col][row] = value;
+        s->data[row] = const_cast<char *>(strings[col][row].data());
+        s->length[row] = (int64_t) value.size();
+    }
+
+    void endRow()
+    {
+        if (++row == DATAGEN_BATCH_SIZE)
+            flush();
+    }
+
+    void close()
+    {
+        flush();
+        writer->close();
+    }
+
+private:
+    void flush()
+    {
+        if (row == 0)
+            return;
+
+        for (auto field : root->fields)
+            field->numElements = row;
+
+        root->numElements = row;
+        writer->add(*batch);
+        row = 0;
+    }
+
+    ORC_UNIQUE_PTR<orc::Type> type;
+    ORC_UNIQUE_PTR<orc::OutputStream> out;
+    ORC_UNIQUE_PTR<orc::Writer> writer;
+    ORC_UNIQUE_PTR<orc::ColumnVectorBatch> batch;
+    orc::StructVectorBatch *root;
+    std::vector<std::vector<std::string>> strings;
+    uint64_t row;
+};
+
+
+/* Declare the functions to use within this file */
+static bool parseOptions(int argc, char **argv, DatagenOptions &options);
+static orc::WriterOptions writerOptions(const DatagenOptions &options);
+static std::string padded(const char *prefix, uint64_t id);
+static void writeDates(const DatagenOptions &options);
+static void writeCustomers(const DatagenOptions &options, uint64_t customers);
+static void writeProducts(const DatagenOptions &options);
+static void writeStores(const DatagenOptions &options);
+static void writeSales(const DatagenOptions &options, const char *name, uint64_t rows, uint64_t customers, bool sorted, bool bloom);
+
+
+static const char *regions[] = {"AFRICA", "AMERICA", "ASIA", "EUROPE", "MIDDLE EAST"};
+static const char *segments[] = {"AUTOMOBILE", "BUILDING", "FURNITURE", "HOUSEHOLD", "MACHINERY"};
+
+
+/*
+ * parseOptions
+ *    Returns false and prints usage for unknown options.
+ */
+static
+bool
+parseOptions(int argc, char **argv, DatagenOptions &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+
+        if (arg == "--scale" && hasValue)
+            options.scale = std::stod(argv[++i]);
+        else if (arg == "--dir" && hasValue)
+            options.dir = argv[++i];
+        else if (arg == "--codec" && hasValue)
+        {
+            std::string codec = argv[++i];
+
+            if (codec == "none")
+                options.codec = orc::CompressionKind_NONE;
+            else if (codec == "zlib")
+                options.codec = orc::CompressionKind_ZLIB;
+            else if (codec == "snappy")
+                options.codec = orc::CompressionKind_SNAPPY;
+            else if (codec == "lz4")
+                options.codec = orc::CompressionKind_LZ4;
+            else if (codec == "zstd")
+                options.codec = orc::CompressionKind_ZSTD;
+            else
+                return false;
+        }
+        else
+        {
+            fprintf(stderr,
+                    "Usage: %s [--scale N] [--dir DIR] [--codec none|zlib|snappy|lz4|zstd]\n"
+                    "\n"
+                    "Scale 1 writes %d fact rows per variant.\n",
+                    argv[0], DATAGEN_SALES_PER_SCALE);
+            return false;
+        }
+    }
+
+    return (options.scale > 0);
+}
+
+static
+orc::WriterOptions
+writerOptions(const DatagenOptions &options)
+{
+    orc::WriterOptions writer_options;
+
+    writer_options.setCompression(options.codec);
+    return writer_options;
+}
+
+/*
+ * padded
+ *    Returns a name like Customer#000000042.
+ */
+static
+std::string
+padded(const char *prefix, uint64_t id)
+{
+    char buf[64];
+
+    snprintf(buf, sizeof(buf), "%s#%09llu", prefix, (unsigned long long) id);
+    return std::string(buf);
+}
+
+static
+void
+writeDates(const DatagenOptions &options)
+{
+    TableWriter table(options.dir + "/date_dim.orc",
+                      "struct<date_id:int,d:date,year:int,month:int,day_of_week:int>",
+                      writerOptions(options));
+
+    for (int64_t i = 0; i < DATAGEN_DAYS; i++)
+    {
+        int64_t day = DATAGEN_FIRST_DAY + i;
+
+        /* Civil date from days since epoch */
+        int64_t z = day + 719468;
+        int64_t era = z / 146097;
+        int64_t doe = z - era * 146097;
+        int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        int64_t mp = (5 * doy + 2) / 153;
+        int64_t month = mp < 10 ? mp + 3 : mp - 9;
+        int64_t year = yoe + era * 400 + (month <= 2);
+
+        table.setLong(0, i);
+        table.setLong(1, day);
+        table.setLong(2, year);
+        table.setLong(3, month);
+        table.setLong(4, (day + 4) % 7);
+        table.endRow();
+    }
+
+    table.close();
+}
+
+static
+void
+writeCustomers(const DatagenOptions &options, uint64_t customers)
+{
+    std::mt19937_64 rng(1);
+    TableWriter table(options.dir + "/customer.orc",
+                      "struct<customer_id:int,name:string,region:string,segment:string>",
+                      writerOptions(options));
+
+    for (uint64_t i = 0; i < customers; i++)
+    {
+        table.setLong(0, i);
+        table.setString(1, padded("Customer", i));
+        table.setString(2, regions[rng() % 5]);
+        table.setString(3, segments[rng() % 5]);
+        table.endRow();
+    }
+
+    table.close();
+}
+
+static
+void
+writeProducts(const DatagenOptions &options)
+{
+    std::mt19937_64 rng(2);
+    TableWriter table(options.dir + "/product.orc",
+                      "struct<product_id:int,name:string,category:int,price:double>",
+                      writerOptions(options));
+
+    for (uint64_t i = 0; i < DATAGEN_PRODUCTS; i++)
+    {
+        table.setLong(0, i);
+        table.setString(1, padded("Product", i));
+        table.setLong(2, rng() % 50);
+        table.setDouble(3, 1.0 + (rng() % 100000) / 100.0);
+        table.endRow();
+    }
+
+    table.close();
+}
+
+static
+void
+writeStores(const DatagenOptions &options)
+{
+    std::mt19937_64 rng(3);
+    TableWriter table(options.dir + "/store.orc",
+                      "struct<store_id:int,city:string,state:string>",
+                      writerOptions(options));
+
+    for (uint64_t i = 0; i < DATAGEN_STORES; i++)
+    {
+        table.setLong(0, i);
+        table.setString(1, padded("City", rng() % 300));
+        table.setString(2, padded("State", rng() % 50));
+        table.endRow();
+    }
+
+    table.close();
+}
+
+/*
+ * writeSales
+ *    Writes a variant of the fact table. Sorted variants spread customers
+ *    evenly over the file in order; others pick them at random. Column
+ *    ids start at 1 for the first field.
+ */
+static
+void
+writeSales(const DatagenOptions &options, const char *name, uint64_t rows, uint64_t customers, bool sorted, bool bloom)
+{
+    std::mt19937_64 rng(4);
+    orc::WriterOptions writer_options = writerOptions(options);
+
+    if (bloom)
+    {
+        writer_options.setColumnsUseBloomFilter(std::set<uint64_t>{3, 4});
+        writer_options.setBloomFilterFPP(0.01);
+    }
+
+    TableWriter table(options.dir + "/" + name + ".orc",
+                      "struct<sale_id:bigint,date_id:int,customer_id:int,product_id:int,store_id:int,"
+                      "quantity:int,amount:double,comment:string>",
+                      writer_options);
+
+    for (uint64_t i = 0; i < rows; i++)
+    {
+        uint64_t r = rng();
+        int64_t quantity = 1 + (int64_t) (r % 20);
+
+        table.setLong(0, i);
+        table.setLong(1, (r >> 8) % DATAGEN_DAYS);
+        table.setLong(2, sorted ? (int64_t) (i * customers / rows) : (int64_t) ((r >> 20) % customers));
+        table.setLong(3, (r >> 40) % DATAGEN_PRODUCTS);
+        table.setLong(4, (r >> 54) % DATAGEN_STORES);
+        table.setLong(5, quantity);
+        table.setDouble(6, quantity * (1.0 + (rng() % 100000) / 100.0));
+        table.setString(7, (r % 16 == 0) ? "returned" : "ok");
+        table.endRow();
+    }
+
+    table.close();
+}
+
+int
+main(int argc, char **argv)
+{
+    DatagenOptions options;
+
+    if (!parseOptions(argc, argv, options))
+        return 1;
+
+    uint64_t rows = (uint64_t) (options.scale * DATAGEN_SALES_PER_SCALE);
+    uint64_t customers = std::max((uint64_t) 1, (uint64_t) (options.scale * DATAGEN_CUSTOMERS_PER_SCALE));
+
+    try
+    {
+        fprintf(stderr, "writing dimensions\n");
+        writeDates(options);
+        writeCustomers(options, customers);
+        writeProducts(options);
+        writeStores(options);
+
+        fprintf(stderr, "writing %llu rows of sales_sorted\n", (unsigned long long) rows);
+        writeSales(options, "sales_sorted", rows, customers, true, false);
+
+        fprintf(stderr, "writing %llu rows of sales_unsorted\n", (unsigned long long) rows);
+        writeSales(options, "sales_unsorted", rows, customers, false, false);
+
+        fprintf(stderr, "writing %llu rows of sales_bloom\n", (unsigned long long) rows);
+        writeSales(options, "sales_bloom", rows, customers, false, true);
+    }
+    catch (std::exception &err)
+    {
+        fprintf(stderr, "orc_datagen: %s\n", err.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,4 @@
+-- Full scan of all rows and one column
+SELECT  count(*)
+        , sum(amount)
+FROM    orc_perf.{{sales}}
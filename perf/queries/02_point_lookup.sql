@@ -0,0 +1,4 @@
+-- Selective equality filter; pushed down to the ORC reader
+SELECT  *
+FROM    orc_perf.{{sales}}
+WHERE   customer_id = 4242
@@ -0,0 +1,5 @@
+-- Selective IN filter; pushed down to the ORC reader
+SELECT  sale_id
+        , amount
+FROM    orc_perf.{{sales}}
+WHERE   customer_id IN (17, 4242, 9001, 23456, 31337, 50000, 65535, 77777, 88888, 99999)
@@ -0,0 +1,4 @@
+-- Range filter on an unsorted column
+SELECT  count(*)
+FROM    orc_perf.{{sales}}
+WHERE   date_id BETWEEN 100 AND 130
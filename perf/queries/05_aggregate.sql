@@ -0,0 +1,7 @@
+-- Grouped aggregate over all rows
+SELECT  store_id
+        , count(*)
+        , sum(quantity)
+        , avg(amount)
+FROM    orc_perf.{{sales}}
+GROUP BY store_id
@@ -0,0 +1,12 @@
+-- Fact table joined with dimensions and filtered on them
+SELECT  c.region
+        , p.category
+        , d.year
+        , sum(s.amount)
+FROM    orc_perf.{{sales}} s
+        JOIN orc_perf.customer c ON c.customer_id = s.customer_id
+        JOIN orc_perf.product p ON p.product_id = s.product_id
+        JOIN orc_perf.date_dim d ON d.date_id = s.date_id
+WHERE   c.segment = 'BUILDING'
+        AND d.year = 2018
+GROUP BY c.region, p.category, d.year
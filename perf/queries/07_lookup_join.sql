@@ -0,0 +1,8 @@
+-- Few outer rows looking up the fact table; nested loop with parameters
+SELECT  c.name
+        , count(*)
+        , sum(s.amount)
+FROM    orc_perf.customer c
+        JOIN orc_perf.{{sales}} s ON s.customer_id = c.customer_id
+WHERE   c.name IN ('Customer#000004242', 'Customer#000031337')
+GROUP BY c.name
@@ -0,0 +1,4 @@
+-- First rows only
+SELECT  *
+FROM    orc_perf.{{sales}}
+LIMIT   100
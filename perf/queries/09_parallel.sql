@@ -0,0 +1,7 @@
+-- Aggregate with parallel workers allowed
+-- SET max_parallel_workers_per_gather = 4;
+-- SET parallel_setup_cost = 0;
+SELECT  count(*)
+        , sum(amount)
+FROM    orc_perf.{{sales}}
+WHERE   quantity > 10
@@ -0,0 +1,6 @@
+-- Scan of a small dimension table with string columns
+SELECT  region
+        , segment
+        , count(*)
+FROM    orc_perf.customer
+GROUP BY region, segment
@@ -0,0 +1,6 @@
+-- Export of a fact table into a new ORC file with encoding on the backend
+-- SET orc_fdw.write_workers = 0
+INSERT
+INTO    orc_perf.sales_export
+SELECT  *
+FROM    orc_perf.sales_unsorted
@@ -0,0 +1,6 @@
+-- Export of a fact table into a new ORC file with 8 write workers
+-- SET orc_fdw.write_workers = 8
+INSERT
+INTO    orc_perf.sales_export
+SELECT  *
+FROM    orc_perf.sales_unsorted
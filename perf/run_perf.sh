@@ -0,0 +1,134 @@
+#!/bin/bash
+#-------------------------------------------------------------------------
+#
+# run_perf.sh
+#    Runs the ORC FDW performance suite and compares the results with a
+#    saved baseline.
+#
+# 2020, Hamid Quddus Akhtar.
+#
+#    Each query in queries/ runs a number of times through EXPLAIN
+#    ANALYZE. Queries on {{sales}} run once for each fact table variant.
+#    Lines starting with "-- SET" are run before the query. Median times
+#    and counters are written to results/ and checked against
+#    baseline.csv; a median above the baseline by more than the tolerance
+#    is a regression and makes the script exit with 1.
+#
+#    Connection settings come from the usual libpq environment variables.
+#
+# Copyright (c) 2020, Highgo Software Inc.
+#
+# IDENTIFICATION
+#    perf/run_perf.sh
+#
+#-------------------------------------------------------------------------
+
+set -e
+
+PERF_DIR="$(cd "$(dirname "$0")" && pwd)"
+PSQL="${PSQL:-psql}"
+DATA_DIR=/tmp/orc_perf
+RUNS=5
+TOLERANCE=0.10
+SAVE_BASELINE=0
+VARIANTS="sales_sorted sales_unsorted sales_bloom"
+
+usage()
+{
+    echo "Usage: $0 [--data-dir DIR] [--runs N] [--tolerance FRACTION] [--save-baseline]" >&2
+    exit 2
+}
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --data-dir) [ $# -gt 1 ] || usage; DATA_DIR="$2"; shift 2 ;;
+        --runs) [ $# -gt 1 ] || usage; RUNS="$2"; shift 2 ;;
+        --tolerance) [ $# -gt 1 ] || usage; TOLERANCE="$2"; shift 2 ;;
+        --save-baseline) SAVE_BASELINE=1; shift ;;
+        *) usage ;;
+    esac
+done
+
+if [ ! -f "$DATA_DIR/sales_sorted.orc" ]; then
+    echo "$0: no data in $DATA_DIR; run \"make data\" first" >&2
+    exit 2
+fi
+
+mkdir -p "$PERF_DIR/results"
+STAMP="$(date +%Y%m%d_%H%M%S)"
+RAW="$PERF_DIR/results/$STAMP.raw.csv"
+RESULT="$PERF_DIR/results/$STAMP.csv"
+
+# Export queries insert into an empty file kept apart from the imported ones
+mkdir -p "$DATA_DIR/export"
+: > "$DATA_DIR/export/sales_export.orc"
+
+"$PSQL" -X -q -v ON_ERROR_STOP=1 -v perf_data_dir="$DATA_DIR" -v perf_export_file="$DATA_DIR/export/sales_export.orc" \
+    -f "$PERF_DIR/sql/setup.sql" >/dev/null
+
+echo "query,variant,run,execution_ms,rows,stripes_read,stripes_skipped,bytes_read,rows_removed" > "$RAW"
+
+for file in "$PERF_DIR"/queries/*.sql; do
+    name="$(basename "$file" .sql)"
+    settings="$(grep '^-- SET ' "$file" | sed 's/^-- //')"
+    query="$(grep -v '^--' "$file" | tr '\n' ' ' | sed 's/;[[:space:]]*$//')"
+
+    variants="-"
+    if grep -q '{{sales}}' "$file"; then
+        variants="$VARIANTS"
+    fi
+
+    for variant in $variants; do
+        sql="${query//\{\{sales\}\}/$variant}"
+
+        for run in $(seq 1 "$RUNS"); do
+            row="$(printf '%s\nSELECT * FROM orc_perf.explain($perf$%s$perf$);\n' "$settings" "$sql" \
+                   | "$PSQL" -X -q -A -t -F, -v ON_ERROR_STOP=1)"
+            echo "$name,$variant,$run,$row" >> "$RAW"
+        done
+
+        echo "$name $variant done" >&2
+    done
+done
+
+# Median time per query and variant; counters don't vary between runs
+tail -n +2 "$RAW" | sort -t, -k1,1 -k2,2 -k4,4g | awk -F, -v OFS=, '
+    function emit() {
+        if (n > 0)
+            print key, times[int((n + 1) / 2)], counters
+    }
+    BEGIN { print "query,variant,median_ms,rows,stripes_read,stripes_skipped,bytes_read,rows_removed" }
+    $1 "," $2 != key { emit(); key = $1 "," $2; n = 0 }
+    { times[++n] = $4; counters = $5 "," $6 "," $7 "," $8 "," $9 }
+    END { emit() }' > "$RESULT"
+
+echo "results written to $RESULT" >&2
+
+if [ "$SAVE_BASELINE" = 1 ]; then
+    cp "$RESULT" "$PERF_DIR/baseline.csv"
+    echo "baseline saved to $PERF_DIR/baseline.csv" >&2
+    exit 0
+fi
+
+if [ ! -f "$PERF_DIR/baseline.csv" ]; then
+    echo "no baseline to compare with; run with --save-baseline first" >&2
+    exit 0
+fi
+
+# Compare times and bytes read with the baseline
+awk -F, -v tol="$TOLERANCE" '
+    NR == FNR { if (FNR > 1) { ms[$1 "," $2] = $3; bytes[$1 "," $2] = $7 } next }
+    FNR == 1 { printf "%-24s %-16s %12s %12s %8s\n", "query", "variant", "baseline_ms", "median_ms", "change"; next }
+    {
+        key = $1 "," $2
+        if (!(key in ms)) {
+            printf "%-24s %-16s %12s %12.3f %8s\n", $1, $2, "-", $3, "new"
+            next
+        }
+        change = (ms[key] > 0) ? ($3 / ms[key] - 1) * 100 : 0
+        flag = ""
+        if ($3 > ms[key] * (1 + tol)) { flag = "  REGRESSION"; failed = 1 }
+        if ($7 > bytes[key] * (1 + tol)) { flag = flag "  MORE BYTES READ (" bytes[key] " -> " $7 ")"; failed = 1 }
+        printf "%-24s %-16s %12.3f %12.3f %+7.1f%%%s\n", $1, $2, ms[key], $3, change, flag
+    }
+    END { exit failed }' "$PERF_DIR/baseline.csv" "$RESULT"
@@ -0,0 +1,87 @@
+/*-------------------------------------------------------------------------
+ *
+ * setup.sql
+ *    Creates foreign tables for the performance suite and a function
+ *    that runs a query under EXPLAIN ANALYZE and returns its counters.
+ *
+ *    REQUIRES:
+ *      perf_data_dir psql variable set to the folder with ORC files
+ *      written by orc_datagen, and perf_export_file to an empty file
+ *      outside of it.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    perf/sql/setup.sql
+ *
+ *-------------------------------------------------------------------------
+ */
+
+CREATE EXTENSION IF NOT EXISTS orc_fdw;
+
+DROP SERVER IF EXISTS orc_perf_srv CASCADE;
+CREATE SERVER orc_perf_srv FOREIGN DATA WRAPPER orc_fdw;
+
+DROP SCHEMA IF EXISTS orc_perf CASCADE;
+CREATE SCHEMA orc_perf;
+
+/* One foreign table for each file */
+IMPORT
+FOREIGN SCHEMA :"perf_data_dir"
+FROM    SERVER orc_perf_srv
+INTO    orc_perf;
+
+/* Target of export queries */
+CREATE FOREIGN TABLE orc_perf.sales_export
+(
+    sale_id         BIGINT
+    , date_id       INT
+    , customer_id   INT
+    , product_id    INT
+    , store_id      INT
+    , quantity      INT
+    , amount        FLOAT8
+    , comment       TEXT
+)
+SERVER orc_perf_srv
+OPTIONS (filename :'perf_export_file', compression 'zstd');
+
+/*
+ * Execution time, rows and ORC counters summed over all scans of the
+ * plan. Writes are rolled back so that every run starts from the same
+ * files.
+ */
+CREATE FUNCTION orc_perf.explain(query text)
+RETURNS TABLE
+(
+    execution_ms        float8
+    , rows              int8
+    , stripes_read      int8
+    , stripes_skipped   int8
+    , bytes_read        int8
+    , rows_removed      int8
+)
+LANGUAGE plpgsql
+AS $$
+DECLARE
+    plan jsonb;
+BEGIN
+    BEGIN
+        EXECUTE 'EXPLAIN (ANALYZE, TIMING OFF, FORMAT JSON) ' || query INTO plan;
+        RAISE SQLSTATE 'OPERF';
+    EXCEPTION
+        WHEN SQLSTATE 'OPERF' THEN
+            NULL;
+    END;
+
+    RETURN QUERY
+    SELECT  (plan->0->>'Execution Time')::float8
+            , (plan->0->'Plan'->>'Actual Rows')::int8
+            , (SELECT COALESCE(sum(v::text::int8), 0)::int8 FROM jsonb_path_query(plan, 'strict $.**."ORC Stripes Read"') v)
+            , (SELECT COALESCE(sum(v::text::int8), 0)::int8 FROM jsonb_path_query(plan, 'strict $.**."ORC Stripes Skipped"') v)
+            , (SELECT COALESCE(sum(v::text::int8), 0)::int8 FROM jsonb_path_query(plan, 'strict $.**."ORC Bytes Read"') v)
+            , (SELECT COALESCE(sum(v::text::int8), 0)::int8 FROM jsonb_path_query(plan, 'strict $.**."Rows Removed by ORC Filter"') v);
+END;
+$$;
@@ -53,11 +53,27 @@ SERVER orc_srv OPTIONS
     FILENAME :'file_myfile'
 );
 
-/* SELECT data from the foreign table; get error for y */
+/* SELECT data from the foreign table; y is cast to text */
 SELECT  *
 FROM    myfile_t
 LIMIT   5;
 
+/* Create a foreign table with a type that y can't be read as */
+CREATE FOREIGN TABLE myfile_d
+(
+    x       INT
+    , y     DATE
+)
+SERVER orc_srv OPTIONS
+(
+    FILENAME :'file_myfile'
+);
+
+/* SELECT data from the foreign table; get error for y */
+SELECT  *
+FROM    myfile_d
+LIMIT   5;
+
 /* Create a foreign table table with some unmatched columns */
 CREATE FOREIGN TABLE orc11
 (
@@ -77,6 +93,7 @@ LIMIT   5;
 
 /* Cleanup */
 DROP FOREIGN TABLE orc11;
+DROP FOREIGN TABLE myfile_d;
 DROP FOREIGN TABLE myfile_t;
 DROP FOREIGN TABLE myfile;
 DROP SERVER orc_srv;
@@ -0,0 +1,460 @@
+/*-------------------------------------------------------------------------
+ *
+ * insert.sql
+ *    Test INSERT and COPY FROM into ORC files
+ *
+ *    REQUIRES:
+ *      ORC_FDW_DIR variable to be set in the shell which is initiating
+ *      the regression.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    sql/insert.sql
+ *
+ *-------------------------------------------------------------------------
+ */
+
+\set orc_insert_file    `echo ${ORC_FDW_DIR}/results/orc_insert.orc`
+\set orc_sorted_file    `echo ${ORC_FDW_DIR}/results/orc_sorted.orc`
+\set orc_clustered_file `echo ${ORC_FDW_DIR}/results/orc_clustered.orc`
+\set orc_compact_dir    `echo ${ORC_FDW_DIR}/results/compact`
+\set orc_part_1_file    `echo ${ORC_FDW_DIR}/results/compact/part_1.orc`
+\set orc_part_2_file    `echo ${ORC_FDW_DIR}/results/compact/part_2.orc`
+\set orc_compacted_file `echo ${ORC_FDW_DIR}/results/orc_compacted.orc`
+\set orc_export_file    `echo ${ORC_FDW_DIR}/results/orc_export.orc`
+\set orc_export_0_file  `echo ${ORC_FDW_DIR}/results/orc_export_0.orc`
+\set orc_export_1_file  `echo ${ORC_FDW_DIR}/results/orc_export_1.orc`
+\set orc_cast_file      `echo ${ORC_FDW_DIR}/results/orc_cast.orc`
+\set orc_decimal_file   `echo ${ORC_FDW_DIR}/results/orc_decimal.orc`
+\set orc_mixed_file     `echo ${ORC_FDW_DIR}/results/orc_mixed.orc`
+
+/* An empty file takes the columns of the table on the first INSERT */
+\! rm -f ${ORC_FDW_DIR}/results/orc_insert.orc*; touch ${ORC_FDW_DIR}/results/orc_insert.orc
+\! rm -f ${ORC_FDW_DIR}/results/orc_sorted.orc*; touch ${ORC_FDW_DIR}/results/orc_sorted.orc
+\! rm -f ${ORC_FDW_DIR}/results/orc_clustered.orc*; touch ${ORC_FDW_DIR}/results/orc_clustered.orc
+\! rm -rf ${ORC_FDW_DIR}/results/compact ${ORC_FDW_DIR}/results/orc_compacted.orc*; mkdir ${ORC_FDW_DIR}/results/compact
+\! touch ${ORC_FDW_DIR}/results/compact/part_1.orc ${ORC_FDW_DIR}/results/compact/part_2.orc
+\! rm -f ${ORC_FDW_DIR}/results/orc_export*.orc* ${ORC_FDW_DIR}/results/orc_cast.orc*
+\! rm -f ${ORC_FDW_DIR}/results/orc_decimal.orc*; touch ${ORC_FDW_DIR}/results/orc_decimal.orc
+\! rm -f ${ORC_FDW_DIR}/results/orc_mixed.orc*
+
+/* Create extension */
+CREATE EXTENSION orc_fdw;
+
+/* Create server */
+CREATE SERVER orc_srv FOREIGN DATA WRAPPER orc_fdw;
+
+CREATE FOREIGN TABLE orc_insert
+(
+    a       INT
+    , b     TEXT
+    , c     FLOAT8
+    , d     DATE
+    , e     NUMERIC(10, 2)
+    , f     TIMESTAMP
+    , g     BOOL
+    , h     BIGINT
+)
+SERVER orc_srv
+OPTIONS (filename :'orc_insert_file', stripe_size '1MB', compression 'zlib', bloom_filter_columns 'a');
+
+INSERT
+INTO    orc_insert
+SELECT  i
+        , 'row ' || i
+        , i / 4.0
+        , DATE '2020-01-01' + i
+        , i * 1.25
+        , TIMESTAMP '2020-01-01 00:00:00' + i * INTERVAL '1 hour'
+        , i % 2 = 0
+        , i * 1000000000::BIGINT
+FROM    generate_series(1, 1000) i;
+
+SELECT  count(*)
+        , sum(a)
+        , min(b)
+        , max(b)
+        , sum(c)
+        , to_char(min(d), 'YYYY-MM-DD') AS min_d
+        , to_char(max(d), 'YYYY-MM-DD') AS max_d
+        , sum(e)
+        , to_char(max(f), 'YYYY-MM-DD HH24:MI:SS') AS max_f
+        , count(*) FILTER (WHERE g) AS g
+        , sum(h)
+FROM    orc_insert;
+
+/* A second INSERT keeps the existing rows */
+INSERT
+INTO    orc_insert
+VALUES  (1001, 'row 1001', 250.25, '2022-09-28', 1251.25, '2020-02-11 17:00:00', false, -1);
+
+SELECT  a
+        , b
+        , c
+        , to_char(d, 'YYYY-MM-DD') AS d
+        , e
+        , to_char(f, 'YYYY-MM-DD HH24:MI:SS') AS f
+        , g
+        , h
+FROM    orc_insert
+WHERE   a > 999
+ORDER BY a;
+
+/* COPY FROM */
+COPY orc_insert FROM STDIN (FORMAT csv);
+1002,row 1002,250.5,2022-09-29,1252.50,2020-02-11 18:00:00,t,2
+1003,row 1003,250.75,2022-09-30,1253.75,2020-02-11 19:00:00,f,3
+\.
+
+SELECT  count(a)
+        , max(a)
+FROM    orc_insert;
+
+/* Rows are written to the file when the transaction commits */
+BEGIN;
+INSERT
+INTO    orc_insert
+VALUES  (1004, 'row 1004', 251, '2022-10-01', 1255.00, '2020-02-11 20:00:00', true, 4);
+
+SELECT  count(a)
+FROM    orc_insert;
+ROLLBACK;
+
+SELECT  count(a)
+FROM    orc_insert;
+
+BEGIN;
+INSERT
+INTO    orc_insert
+VALUES  (1005, 'row 1005', 251.25, '2022-10-02', 1256.25, '2020-02-11 21:00:00', false, 5);
+
+SAVEPOINT s1;
+INSERT
+INTO    orc_insert
+VALUES  (1006, 'row 1006', 251.5, '2022-10-03', 1257.50, '2020-02-11 22:00:00', true, 6);
+ROLLBACK TO SAVEPOINT s1;
+COMMIT;
+
+SELECT  count(a)
+        , max(a)
+FROM    orc_insert;
+
+/* Sorted on write; small stripes so that the file has many */
+CREATE FOREIGN TABLE orc_sorted
+(
+    a       INT
+    , b     TEXT
+    , c     INT
+)
+SERVER orc_srv
+OPTIONS (filename :'orc_sorted_file', stripe_size '1kB', sort_by 'a');
+
+INSERT
+INTO    orc_sorted
+SELECT  i
+        , md5(i::text)
+        , (i * 7919) % 10000
+FROM    generate_series(1, 10000) i
+ORDER BY md5(i::text);
+
+SELECT  a
+FROM    orc_sorted
+LIMIT   3;
+
+SELECT  column_name
+        , stripes > 1 AS many_stripes
+        , overlap = 0 AS no_overlap
+        , max_overlapping_stripes = 0 AS no_max_overlap
+FROM    orc_file_prunability(:'orc_sorted_file');
+
+/* Clustered in z-order of two columns */
+CREATE FOREIGN TABLE orc_clustered
+(
+    x       INT
+    , y     INT
+    , z     TEXT
+)
+SERVER orc_srv
+OPTIONS (filename :'orc_clustered_file', stripe_size '1kB', cluster_by 'x, y');
+
+INSERT
+INTO    orc_clustered
+SELECT  i % 100
+        , i / 100
+        , md5(i::text)
+FROM    generate_series(0, 9999) i;
+
+SELECT  count(*)
+        , sum(x)
+        , sum(y)
+FROM    orc_clustered;
+
+SELECT  column_name
+        , stripes > 1 AS many_stripes
+        , overlap < 1 AS some_stripes_skipped
+FROM    orc_file_prunability(:'orc_clustered_file');
+
+/* Small files merged into one */
+CREATE FOREIGN TABLE orc_part_1
+(
+    a       INT
+    , b     TEXT
+)
+SERVER orc_srv
+OPTIONS (filename :'orc_part_1_file');
+
+CREATE FOREIGN TABLE orc_part_2
+(
+    a       INT
+    , b     TEXT
+)
+SERVER orc_srv
+OPTIONS (filename :'orc_part_2_file', compression 'zstd');
+
+INSERT
+INTO    orc_part_1
+SELECT  i
+        , 'row ' || i
+FROM    generate_series(1, 100) i;
+
+INSERT
+INTO    orc_part_2
+SELECT  i
+        , 'row ' || i
+FROM    generate_series(101, 250) i;
+
+SELECT  regexp_replace(filename, '.*/', '') AS filename
+        , rows
+FROM    orc_compact(:'orc_compact_dir', :'orc_compacted_file', '{stripe_size=128MB,compression=snappy}');
+
+CREATE FOREIGN TABLE orc_compacted
+(
+    a       INT
+    , b     TEXT
+)
+SERVER orc_srv
+OPTIONS (filename :'orc_compacted_file');
+
+SELECT  count(*)
+        , min(a)
+        , max(a)
+        , max(b)
+FROM    orc_compacted;
+
+/* Query results exported to one file and to two files split on a column */
+SELECT  regexp_replace(filename, '.*/', '') AS filename
+        , rows
+FROM    orc_export('SELECT i AS id, i % 3 AS grp, ''item '' || i AS label, i * 1.5::float8 AS price
+                    FROM generate_series(1, 1000) i',
+                   :'orc_export_file',
+                   '{"compression": "zstd", "fetch_size": 300}');
+
+SELECT  count(*)
+        , sum(rows)
+FROM    orc_export('SELECT i AS id, i % 3 AS grp FROM generate_series(1, 1000) i',
+                   :'orc_export_file',
+                   '{"parallel": 2, "split_by": "grp", "stripe_size": "1MB"}');
+
+CREATE FOREIGN TABLE orc_export
+(
+    id          INT
+    , grp       INT
+    , label     TEXT
+    , price     FLOAT8
+)
+SERVER orc_srv
+OPTIONS (filename :'orc_export_file');
+
+SELECT  count(*)
+        , sum(id)
+        , count(DISTINCT grp)
+        , max(label)
+        , sum(price)
+FROM    orc_export;
+
+CREATE FOREIGN TABLE orc_export_0
+(
+    id          INT
+    , grp       INT
+)
+SERVER orc_srv
+OPTIONS (filename :'orc_export_0_file');
+
+CREATE FOREIGN TABLE orc_export_1
+(
+    id          INT
+    , grp       INT
+)
+SERVER orc_srv
+OPTIONS (filename :'orc_export_1_file');
+
+/* Each value of the split column is in one file */
+SELECT  grp
+        , count(*)
+FROM    (SELECT grp FROM orc_export_0 UNION ALL SELECT grp FROM orc_export_1) t
+GROUP BY grp
+ORDER BY grp;
+
+SELECT  count(*)
+FROM    (SELECT DISTINCT grp FROM orc_export_0 INTERSECT SELECT DISTINCT grp FROM orc_export_1) t;
+
+/* Columns read as other types than written; cast a batch at a time */
+CREATE FOREIGN TABLE orc_insert_wide
+(
+    a       BIGINT
+    , b     TEXT
+    , c     FLOAT8
+    , d     TIMESTAMP
+    , e     NUMERIC(10, 2)
+    , f     DATE
+    , g     BOOL
+    , h     NUMERIC
+)
+SERVER orc_srv
+OPTIONS (filename :'orc_insert_file');
+
+SELECT  a
+        , to_char(d, 'YYYY-MM-DD HH24:MI:SS') AS d
+        , to_char(f, 'YYYY-MM-DD') AS f
+        , h
+FROM    orc_insert_wide
+WHERE   a BETWEEN 1000 AND 1002
+ORDER BY a;
+
+SELECT  count(*)
+FROM    orc_insert n
+        JOIN orc_insert_wide w ON n.a = w.a
+WHERE   n.d = w.d
+        AND n.f::date = w.f
+        AND n.h = w.h;
+
+SET datestyle = 'ISO, YMD';
+
+CREATE FOREIGN TABLE orc_insert_text
+(
+    a       INT
+    , d     TEXT
+    , f     VARCHAR
+)
+SERVER orc_srv
+OPTIONS (filename :'orc_insert_file');
+
+SELECT  a
+        , d
+        , f
+FROM    orc_insert_text
+WHERE   a BETWEEN 1000 AND 1002
+ORDER BY a;
+
+SELECT  regexp_replace(filename, '.*/', '') AS filename
+        , rows
+FROM    orc_export('SELECT i AS id, (DATE ''2020-01-01'' + i)::text AS d,
+                           (TIMESTAMP ''2020-01-01'' + i * INTERVAL ''1 minute'')::text AS t
+                    FROM generate_series(1, 100) i',
+                   :'orc_cast_file');
+
+CREATE FOREIGN TABLE orc_cast
+(
+    id      BIGINT
+    , d     DATE
+    , t     TIMESTAMP
+)
+SERVER orc_srv
+OPTIONS (filename :'orc_cast_file');
+
+SELECT  count(*)
+        , sum(id)
+        , min(d)
+        , max(d)
+        , min(t)
+        , max(t)
+FROM    orc_cast;
+
+RESET datestyle;
+
+/* Values below one fit decimal(p, p) */
+CREATE FOREIGN TABLE orc_decimal
+(
+    a       NUMERIC(2, 2)
+    , b     NUMERIC(20, 20)
+)
+SERVER orc_srv
+OPTIONS (filename :'orc_decimal_file');
+
+INSERT
+INTO    orc_decimal
+VALUES  (0.05, 0.00000000000000000001)
+        , (-0.99, -0.12345678901234567890)
+        , (0, 0);
+
+SELECT  a
+        , b
+FROM    orc_decimal
+ORDER BY a;
+
+/* Columns map to the fields of a file ignoring case */
+SELECT  regexp_replace(filename, '.*/', '') AS filename
+        , rows
+FROM    orc_export('SELECT i AS "Id", ''item '' || i AS "Label" FROM generate_series(1, 2) i',
+                   :'orc_mixed_file');
+
+CREATE FOREIGN TABLE orc_mixed
+(
+    id      INT
+    , label TEXT
+)
+SERVER orc_srv
+OPTIONS (filename :'orc_mixed_file');
+
+INSERT
+INTO    orc_mixed
+VALUES  (3, 'item 3');
+
+SELECT  id
+        , label
+FROM    orc_mixed
+ORDER BY id;
+
+/* Error checking */
+SELECT  *
+FROM    orc_export('SELECT 1 AS a, 2 AS a', :'orc_export_file');
+
+SELECT  *
+FROM    orc_export('SELECT 1 AS a', :'orc_export_file', '{"parallel": 0}');
+
+SELECT  *
+FROM    orc_export('SELECT 1 AS a', :'orc_export_file', '{"split_by": "b"}');
+
+SELECT  *
+FROM    orc_export('SELECT 1 AS a', :'orc_export_file');
+
+SELECT  *
+FROM    orc_compact(:'orc_compact_dir', :'orc_compacted_file', '{level=9}');
+
+ALTER FOREIGN TABLE orc_clustered OPTIONS (ADD sort_by 'x');
+
+INSERT
+INTO    orc_clustered
+VALUES  (1, 1, 'a');
+
+ALTER FOREIGN TABLE orc_clustered OPTIONS (DROP sort_by);
+
+ALTER FOREIGN TABLE orc_clustered OPTIONS (SET cluster_by 'x');
+
+ALTER FOREIGN TABLE orc_insert OPTIONS (SET compression 'lzma');
+
+ALTER FOREIGN TABLE orc_insert OPTIONS (ADD bloom_filter_fpp '1.5');
+
+UPDATE  orc_insert
+SET     a = -10
+WHERE   a = 1;
+
+/* Cleanup */
+DROP EXTENSION orc_fdw CASCADE;
+
+\! rm -f ${ORC_FDW_DIR}/results/orc_insert.orc ${ORC_FDW_DIR}/results/orc_sorted.orc ${ORC_FDW_DIR}/results/orc_clustered.orc
+\! rm -rf ${ORC_FDW_DIR}/results/compact ${ORC_FDW_DIR}/results/orc_compacted.orc
+\! rm -f ${ORC_FDW_DIR}/results/orc_export*.orc ${ORC_FDW_DIR}/results/orc_cast.orc ${ORC_FDW_DIR}/results/orc_decimal.orc ${ORC_FDW_DIR}/results/orc_mixed.orc
@@ -77,5 +77,66 @@ WHERE	mf1.x IN
 	)
 LIMIT	30;
 
+/* Inner side cached for rescans */
+\set file_myfile   `echo ${ORC_FDW_DIR}/sample/data/myfile.orc`
+
+CREATE FOREIGN TABLE myfile_cached
+(
+    x       INT
+    , y     INT
+)
+SERVER orc_srv OPTIONS
+(
+    FILENAME :'file_myfile'
+    , RESCAN_CACHE 'true'
+);
+
+SET enable_hashjoin = off;
+SET enable_mergejoin = off;
+SET enable_material = off;
+
+SELECT  count(*)
+        , min(mf2.y)
+        , max(mf2.y)
+FROM    myfile mf1 INNER JOIN myfile_cached mf2
+        ON mf1.y = mf2.x + 0
+WHERE   mf1.x < 20
+        AND mf2.x < 100;
+
+/* The file is read once however often the inner side is rescanned */
+CREATE FUNCTION orc_explain_inner(query text)
+RETURNS SETOF text
+LANGUAGE plpgsql
+AS $$
+DECLARE
+    plan jsonb;
+BEGIN
+    EXECUTE 'EXPLAIN (ANALYZE, COSTS OFF, TIMING OFF, SUMMARY OFF, FORMAT JSON) ' || query INTO plan;
+    RETURN QUERY
+    SELECT  key || ': ' || value
+    FROM    jsonb_path_query(plan, 'strict $.**?(@."Alias" == "mf2")') node
+            , jsonb_each_text(node)
+    WHERE   key IN ('Actual Loops', 'ORC Stripes Read')
+    ORDER BY key;
+END;
+$$;
+
+SELECT  orc_explain_inner('SELECT count(*) FROM myfile mf1 INNER JOIN myfile_cached mf2
+                            ON mf1.y = mf2.x + 0 WHERE mf1.x < 20 AND mf2.x < 100') AS counter;
+
+ALTER FOREIGN TABLE myfile_cached OPTIONS (SET RESCAN_CACHE 'false');
+
+SELECT  orc_explain_inner('SELECT count(*) FROM myfile mf1 INNER JOIN myfile_cached mf2
+                            ON mf1.y = mf2.x + 0 WHERE mf1.x < 20 AND mf2.x < 100') AS counter;
+
+DROP FUNCTION orc_explain_inner(text);
+
+RESET enable_hashjoin;
+RESET enable_mergejoin;
+RESET enable_material;
+
+/* Invalid value for rescan_cache */
+ALTER FOREIGN TABLE myfile_cached OPTIONS (SET RESCAN_CACHE 'maybe');
+
 /* Cleanup */
 DROP EXTENSION orc_fdw CASCADE;
@@ -57,6 +57,11 @@ SELECT  x
 FROM    myfile
 WHERE   y < 10;
 
+/* count(*) of the whole file is read from the footer */
+EXPLAIN VERBOSE
+SELECT  count(*)
+FROM    myfile;
+
 EXPLAIN VERBOSE
 SELECT  y
 FROM    myfile
@@ -129,11 +134,77 @@ SERVER orc_srv OPTIONS
     , INVALID_OPTION 'error'
 );
 
-/* Unsupported features */
-INSERT
-INTO    myfile
-VALUES  (19, 1039);
+/* Scan counters of EXPLAIN ANALYZE */
+CREATE FUNCTION orc_explain_counters(query text)
+RETURNS SETOF text
+LANGUAGE plpgsql
+AS $$
+DECLARE
+    plan json;
+BEGIN
+    EXECUTE 'EXPLAIN (ANALYZE, TIMING OFF, FORMAT JSON) ' || query INTO plan;
+    RETURN QUERY
+    SELECT  key || ': ' || value
+    FROM    json_each_text(plan->0->'Plan')
+    WHERE   key IN ('ORC Stripes Read', 'ORC Stripes Skipped', 'ORC Batches', 'Rows Removed by ORC Filter');
+END;
+$$;
+
+SELECT  orc_explain_counters('SELECT * FROM myfile WHERE x < 100') AS counter;
+
+DROP FUNCTION orc_explain_counters(text);
+
+/* Reader pool; files are closed when scans end with the pool off */
+SET orc_fdw.reader_pool_size = 0;
+
+SELECT  count(*)
+FROM    myfile;
+
+RESET orc_fdw.reader_pool_size;
+
+SELECT  count(*)
+FROM    myfile;
+
+/* Rows without columns; no stripes are read */
+SELECT  count(*)
+FROM    myfile
+WHERE   random() >= 0;
+
+SELECT  EXISTS (SELECT 1 FROM myfile);
 
+/* Sampling; TABLESAMPLE isn't allowed on foreign tables */
+SET orc_fdw.sample_method = 'bernoulli';
+SET orc_fdw.sample_percent = 10;
+SET orc_fdw.sample_seed = 42;
+
+EXPLAIN (COSTS OFF)
+SELECT  x
+FROM    myfile;
+
+SELECT  count(*) BETWEEN 800 AND 1200 AS ok
+FROM    myfile;
+
+SELECT  (SELECT count(*) FROM myfile) = (SELECT count(x) FROM myfile) AS same_rows;
+
+SELECT  (SELECT sum(x) FROM myfile) = (SELECT sum(x) FROM myfile) AS repeatable;
+
+SET orc_fdw.sample_method = 'system';
+SET orc_fdw.sample_percent = 0;
+
+SELECT  count(*)
+        , count(x)
+FROM    myfile;
+
+SET orc_fdw.sample_percent = 100;
+
+SELECT  count(x)
+FROM    myfile;
+
+RESET orc_fdw.sample_method;
+RESET orc_fdw.sample_percent;
+RESET orc_fdw.sample_seed;
+
+/* Unsupported features */
 UPDATE  myfile
 SET     x = -10
 WHERE   x = 1;
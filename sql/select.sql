@@ -18,6 +18,12 @@
  */
 
 \set orc_sample_dir     `echo ${ORC_FDW_DIR}/sample/data`
+\set orc_file_11        `echo ${ORC_FDW_DIR}/sample/data/orc_file_11_format.orc`
+\set orc_nulls_file     `echo ${ORC_FDW_DIR}/results/orc_nulls.orc`
+\set orc_runs_file      `echo ${ORC_FDW_DIR}/results/orc_runs.orc`
+
+/* Files read below are written with orc_export */
+\! rm -f ${ORC_FDW_DIR}/results/orc_nulls.orc* ${ORC_FDW_DIR}/results/orc_runs.orc*
 
 /* Create extension */
 CREATE EXTENSION orc_fdw;
@@ -40,6 +46,32 @@ SELECT  *
 FROM    myfile
 WHERE   x IN (3, 9, 390);
 
+SELECT  *
+FROM    myfile
+WHERE   x = 390;
+
+SELECT  *
+FROM    myfile
+WHERE   x = ANY(ARRAY[17, NULL, 9999]);
+
+/* Parameterized point lookup */
+PREPARE myfile_lookup(int) AS
+SELECT  *
+FROM    myfile
+WHERE   x = $1;
+
+EXECUTE myfile_lookup(25);
+EXECUTE myfile_lookup(-1);
+
+DEALLOCATE myfile_lookup;
+
+/* Keys from a subquery are applied as a runtime filter */
+SELECT  count(*)
+        , min(x)
+        , max(x)
+FROM    myfile
+WHERE   x = ANY(ARRAY(SELECT g * 7 FROM generate_series(0, 99) g));
+
 SELECT  count(*)
 FROM    myfile;
 
@@ -84,5 +116,166 @@ SELECT  boolean1
 FROM    orc_file_11_format
 LIMIT   2;
 
+/* Nested columns; lists of structs and maps are read as jsonb */
+SELECT  string1
+        , list
+        , map
+FROM    orc_file_11_format
+LIMIT   2;
+
+/* Structs may be read as a composite type of the same field names */
+CREATE TYPE orc_middle AS (list JSONB);
+
+CREATE FOREIGN TABLE orc_file_11_middle
+(
+    string1     TEXT
+    , middle    orc_middle
+)
+SERVER orc_srv
+OPTIONS (filename :'orc_file_11');
+
+SELECT  string1
+        , (middle).list
+        , jsonb_array_length((middle).list) AS items
+FROM    orc_file_11_middle
+LIMIT   2;
+
+/* Only the selected fields of a struct are read */
+SELECT  string1
+        , (middle).list -> 0 ->> 'string1' AS first
+FROM    orc_file_11_middle
+WHERE   (middle).list IS NOT NULL
+LIMIT   2;
+
+/* Attributes are matched to fields ignoring case */
+CREATE TYPE orc_middle_upper AS ("LIST" JSONB);
+
+CREATE FOREIGN TABLE orc_file_11_middle_upper
+(
+    string1     TEXT
+    , middle    orc_middle_upper
+)
+SERVER orc_srv
+OPTIONS (filename :'orc_file_11');
+
+SELECT  string1
+        , jsonb_array_length((middle)."LIST") AS items
+FROM    orc_file_11_middle_upper
+LIMIT   2;
+
+/* NULLs are read from the null bitmaps of the file */
+SELECT  regexp_replace(filename, '.*/', '') AS filename
+        , rows
+FROM    orc_export('SELECT i AS id, CASE WHEN i % 3 <> 0 THEN i END AS n,
+                           CASE WHEN i % 3 <> 0 THEN ''row '' || i END AS s,
+                           CASE WHEN i % 3 <> 0 THEN DATE ''2020-01-01'' + i END AS d
+                    FROM generate_series(1, 100) i',
+                   :'orc_nulls_file');
+
+CREATE FOREIGN TABLE orc_nulls
+(
+    id      INT
+    , n     INT
+    , s     TEXT
+    , d     DATE
+)
+SERVER orc_srv
+OPTIONS (filename :'orc_nulls_file');
+
+SELECT  count(*)
+        , count(n) AS n
+        , count(s) AS s
+        , count(d) AS d
+        , sum(n)
+        , count(*) FILTER (WHERE n IS NULL) AS n_null
+FROM    orc_nulls;
+
+SELECT  id
+        , n
+        , s
+        , to_char(d, 'YYYY-MM-DD') AS d
+FROM    orc_nulls
+WHERE   id BETWEEN 2 AND 4
+ORDER BY id;
+
+/* id has no NULLs in the file */
+SELECT  count(*)
+FROM    orc_nulls
+WHERE   id IS NULL;
+
+/* LIKE prefixes and comparisons drop rows a batch at a time */
+SELECT  count(*)
+        , min(id)
+        , max(id)
+FROM    orc_nulls
+WHERE   s LIKE 'row 1%';
+
+SELECT  id
+        , s
+FROM    orc_nulls
+WHERE   s >= 'row 97' COLLATE "C"
+        AND id < 100
+ORDER BY id;
+
+SELECT  count(*)
+FROM    orc_nulls
+WHERE   d > DATE '2020-03-01'
+        AND id <= 70;
+
+/* Equality conditions drop runs of repeated keys at once */
+SELECT  regexp_replace(filename, '.*/', '') AS filename
+        , rows
+FROM    orc_export('SELECT i, CASE WHEN i <= 95 THEN i / 10 END AS k
+                    FROM generate_series(1, 100) i',
+                   :'orc_runs_file');
+
+CREATE FOREIGN TABLE orc_runs
+(
+    i       INT
+    , k     INT
+)
+SERVER orc_srv
+OPTIONS (filename :'orc_runs_file');
+
+SELECT  k
+        , count(*)
+        , min(i)
+        , max(i)
+FROM    orc_runs
+WHERE   k = 3
+GROUP BY k;
+
+SELECT  i
+FROM    orc_runs
+WHERE   k = 9
+ORDER BY i;
+
+/* Rows of other keys are removed before reaching PostgreSQL */
+CREATE FUNCTION orc_explain_filtered(query text)
+RETURNS SETOF text
+LANGUAGE plpgsql
+AS $$
+DECLARE
+    plan json;
+BEGIN
+    EXECUTE 'EXPLAIN (ANALYZE, COSTS OFF, TIMING OFF, SUMMARY OFF, FORMAT JSON) ' || query INTO plan;
+    RETURN QUERY
+    SELECT  key || ': ' || value
+    FROM    json_each_text(plan->0->'Plan')
+    WHERE   key IN ('Actual Rows', 'Rows Removed by ORC Filter');
+END;
+$$;
+
+SELECT  orc_explain_filtered('SELECT i FROM orc_runs WHERE k = 3') AS counter;
+
+SELECT  orc_explain_filtered('SELECT i FROM orc_runs WHERE k = 9') AS counter;
+
+DROP FUNCTION orc_explain_filtered(text);
+
 /* Cleanup */
 DROP EXTENSION orc_fdw CASCADE;
+
+DROP TYPE orc_middle;
+DROP TYPE orc_middle_upper;
+
+\! rm -f ${ORC_FDW_DIR}/results/orc_nulls.orc ${ORC_FDW_DIR}/results/orc_runs.orc
@@ -0,0 +1,67 @@
+/*-------------------------------------------------------------------------
+ *
+ * stats.sql
+ *    Test cumulative scan statistics of pg_stat_orc_fdw
+ *
+ *    REQUIRES:
+ *      ORC_FDW_DIR variable to be set in the shell which is initiating
+ *      the regression.
+ *
+ *    Counters are only collected if orc_fdw is in shared_preload_libraries;
+ *    expected/stats_1.out is the output of a server without it.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    sql/stats.sql
+ *
+ *-------------------------------------------------------------------------
+ */
+
+\set file_myfile        `echo ${ORC_FDW_DIR}/sample/data/myfile.orc`
+
+/* Create extension */
+CREATE EXTENSION orc_fdw;
+
+/* Create server */
+CREATE SERVER orc_srv FOREIGN DATA WRAPPER orc_fdw;
+
+CREATE FOREIGN TABLE myfile
+(
+    x       INT
+    , y     INT
+)
+SERVER orc_srv OPTIONS
+(
+    FILENAME :'file_myfile'
+);
+
+/* Counters of the table in this database; zero if there are none */
+CREATE VIEW myfile_stats AS
+SELECT  coalesce(sum(scans), 0) AS scans
+        , coalesce(sum(rows_returned), 0) AS rows_returned
+        , coalesce(sum(rows_filtered), 0) AS rows_filtered
+FROM    pg_stat_orc_fdw
+WHERE   dbid = (SELECT oid FROM pg_database WHERE datname = current_database())
+AND     relid = 'myfile'::regclass;
+
+SELECT  pg_stat_orc_fdw_reset();
+
+/* Rows of x >= 100 are dropped by the runtime filter of the scan */
+SELECT  count(y)
+FROM    myfile
+WHERE   x < 100;
+
+SELECT  *
+FROM    myfile_stats;
+
+SELECT  pg_stat_orc_fdw_reset();
+
+SELECT  *
+FROM    myfile_stats;
+
+/* Cleanup */
+DROP VIEW myfile_stats;
+DROP EXTENSION orc_fdw CASCADE;
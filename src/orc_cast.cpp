@@ -0,0 +1,277 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_cast.cpp
+ *    Casts of ORC column vectors to the types of foreign table columns.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ *    Kernels cover widenings and date, timestamp and text conversions
+ *    that files see as their schema evolves. A kernel fills the Datums
+ *    of a whole column vector in one loop over the ORC data; NULL rows
+ *    are left as zero. Other casts go through fmgr a value at a time.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    src/orc_cast.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+/* C++ header files */
+#include <string>
+
+/* ORC FDW header files */
+#include <orc_cast.h>
+
+/* PostgreSQL and FDW header files */
+extern "C"
+{
+    #include "orc_fdw.h"
+    #include "catalog/pg_type.h"
+    #include "utils/builtins.h"
+    #include "utils/date.h"
+    #include "utils/numeric.h"
+    #include "utils/timestamp.h"
+}
+
+
+/* Declare the functions to use within this file */
+static inline bool isIntType(Oid typid);
+static inline bool isTextType(Oid typid);
+static inline Timestamp getTimestamp(orc::TimestampVectorBatch *field, uint64_t row);
+
+
+static inline
+bool
+isIntType(Oid typid)
+{
+    return (typid == INT2OID || typid == INT4OID || typid == INT8OID);
+}
+
+static inline
+bool
+isTextType(Oid typid)
+{
+    return (typid == TEXTOID || typid == VARCHAROID);
+}
+
+/*
+ * getTimestamp
+ *    Returns a timestamp from seconds since the UNIX epoch and nanoseconds.
+ */
+static inline
+Timestamp
+getTimestamp(orc::TimestampVectorBatch *field, uint64_t row)
+{
+    return field->data[row] * USECS_PER_SEC + field->nanoseconds[row] / 1000
+            - (int64_t) (POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE) * USECS_PER_DAY;
+}
+
+/*
+ * orcGetCastKind
+ *    Returns the batch kernel casting values of srcOid, as read from the
+ *    ORC file, to targetOid; ORC_CAST_NONE if there is none.
+ */
+OrcFdwCastKind
+orcGetCastKind(Oid srcOid, Oid targetOid)
+{
+    if (isIntType(srcOid))
+    {
+        if (targetOid == INT4OID && srcOid == INT2OID)
+            return ORC_CAST_INT_TO_INT4;
+        if (targetOid == INT8OID)
+            return ORC_CAST_INT_TO_INT8;
+        if (targetOid == FLOAT8OID)
+            return ORC_CAST_INT_TO_FLOAT8;
+        if (targetOid == NUMERICOID)
+            return ORC_CAST_INT_TO_NUMERIC;
+    }
+    else if (srcOid == FLOAT4OID && targetOid == FLOAT8OID)
+        return ORC_CAST_FLOAT4_TO_FLOAT8;
+    else if (srcOid == DATEOID)
+    {
+        if (targetOid == TIMESTAMPOID)
+            return ORC_CAST_DATE_TO_TIMESTAMP;
+        if (isTextType(targetOid))
+            return ORC_CAST_DATE_TO_TEXT;
+    }
+    else if (srcOid == TIMESTAMPOID)
+    {
+        if (targetOid == DATEOID)
+            return ORC_CAST_TIMESTAMP_TO_DATE;
+        if (isTextType(targetOid))
+            return ORC_CAST_TIMESTAMP_TO_TEXT;
+    }
+    else if (isTextType(srcOid))
+    {
+        if (targetOid == DATEOID)
+            return ORC_CAST_TEXT_TO_DATE;
+        if (targetOid == TIMESTAMPOID)
+            return ORC_CAST_TEXT_TO_TIMESTAMP;
+    }
+
+    return ORC_CAST_NONE;
+}
+
+/*
+ * orcCastColumn
+ *    Casts the first rows of a column vector into values with a batch
+ *    kernel. Values that aren't passed by value are allocated in the
+ *    current memory context.
+ */
+void
+orcCastColumn(OrcFdwCastKind kind, orc::ColumnVectorBatch *field, uint64_t rows, Datum *values)
+{
+    const char *notNull = field->hasNulls ? field->notNull.data() : NULL;
+    uint64_t row;
+
+    memset(values, 0, sizeof(Datum) * rows);
+
+    switch (kind)
+    {
+        case ORC_CAST_INT_TO_INT4:
+        {
+            const int64_t *data = static_cast<orc::LongVectorBatch *>(field)->data.data();
+
+            for (row = 0; row < rows; row++)
+                values[row] = Int32GetDatum((int32) data[row]);
+            break;
+        }
+        case ORC_CAST_INT_TO_INT8:
+        {
+            const int64_t *data = static_cast<orc::LongVectorBatch *>(field)->data.data();
+
+            for (row = 0; row < rows; row++)
+                values[row] = Int64GetDatum(data[row]);
+            break;
+        }
+        case ORC_CAST_INT_TO_FLOAT8:
+        {
+            const int64_t *data = static_cast<orc::LongVectorBatch *>(field)->data.data();
+
+            for (row = 0; row < rows; row++)
+                values[row] = Float8GetDatum((float8) data[row]);
+            break;
+        }
+        case ORC_CAST_INT_TO_NUMERIC:
+        {
+            const int64_t *data = static_cast<orc::LongVectorBatch *>(field)->data.data();
+
+            for (row = 0; row < rows; row++)
+            {
+                if (notNull != NULL && !notNull[row])
+                    continue;
+#if PG_VERSION_NUM >= 140000
+                values[row] = NumericGetDatum(int64_to_numeric(data[row]));
+#else
+                values[row] = DirectFunctionCall1(int8_numeric, Int64GetDatum(data[row]));
+#endif
+            }
+            break;
+        }
+        case ORC_CAST_FLOAT4_TO_FLOAT8:
+        {
+            const double *data = static_cast<orc::DoubleVectorBatch *>(field)->data.data();
+
+            /* Floats are widened to doubles in the vector already */
+            for (row = 0; row < rows; row++)
+                values[row] = Float8GetDatum(data[row]);
+            break;
+        }
+        case ORC_CAST_DATE_TO_TIMESTAMP:
+        {
+            const int64_t *data = static_cast<orc::LongVectorBatch *>(field)->data.data();
+
+            for (row = 0; row < rows; row++)
+            {
+                DateADT date = (DateADT) (data[row] + (UNIX_EPOCH_JDATE - POSTGRES_EPOCH_JDATE));
+
+                if (notNull != NULL && !notNull[row])
+                    continue;
+
+                /* Same range check as date2timestamp */
+                if (date >= (TIMESTAMP_END_JULIAN - POSTGRES_EPOCH_JDATE))
+                {
+                    ereport(ERROR,
+                            (errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+                             errmsg("%s: date out of range for timestamp", ORC_FDW_NAME)));
+                }
+
+                values[row] = TimestampGetDatum((Timestamp) date * USECS_PER_DAY);
+            }
+            break;
+        }
+        case ORC_CAST_TIMESTAMP_TO_DATE:
+        {
+            orc::TimestampVectorBatch *ts = static_cast<orc::TimestampVectorBatch *>(field);
+
+            for (row = 0; row < rows; row++)
+            {
+                Timestamp value = getTimestamp(ts, row);
+                int64_t days = value / USECS_PER_DAY;
+
+                /* Round down before the epoch */
+                if (value % USECS_PER_DAY < 0)
+                    days--;
+
+                values[row] = DateADTGetDatum((DateADT) days);
+            }
+            break;
+        }
+        case ORC_CAST_DATE_TO_TEXT:
+        {
+            const int64_t *data = static_cast<orc::LongVectorBatch *>(field)->data.data();
+
+            for (row = 0; row < rows; row++)
+            {
+                DateADT date = (DateADT) (data[row] + (UNIX_EPOCH_JDATE - POSTGRES_EPOCH_JDATE));
+
+                if (notNull != NULL && !notNull[row])
+                    continue;
+
+                values[row] = PointerGetDatum(cstring_to_text(DatumGetCString(DirectFunctionCall1(date_out, DateADTGetDatum(date)))));
+            }
+            break;
+        }
+        case ORC_CAST_TIMESTAMP_TO_TEXT:
+        {
+            orc::TimestampVectorBatch *ts = static_cast<orc::TimestampVectorBatch *>(field);
+
+            for (row = 0; row < rows; row++)
+            {
+                if (notNull != NULL && !notNull[row])
+                    continue;
+
+                values[row] = PointerGetDatum(cstring_to_text(DatumGetCString(DirectFunctionCall1(timestamp_out, TimestampGetDatum(getTimestamp(ts, row))))));
+            }
+            break;
+        }
+        case ORC_CAST_TEXT_TO_DATE:
+        case ORC_CAST_TEXT_TO_TIMESTAMP:
+        {
+            orc::StringVectorBatch *s = static_cast<orc::StringVectorBatch *>(field);
+            std::string buf;
+
+            for (row = 0; row < rows; row++)
+            {
+                if (notNull != NULL && !notNull[row])
+                    continue;
+
+                /* Input functions need a terminated string */
+                buf.assign(s->data[row], s->length[row]);
+
+                if (kind == ORC_CAST_TEXT_TO_DATE)
+                    values[row] = DirectFunctionCall1(date_in, CStringGetDatum(buf.c_str()));
+                else
+                    values[row] = DirectFunctionCall3(timestamp_in, CStringGetDatum(buf.c_str()), ObjectIdGetDatum(InvalidOid), Int32GetDatum(-1));
+            }
+            break;
+        }
+        default:
+        {
+            ereport(ERROR, (errmsg("%s: no batch kernel for cast %d", ORC_FDW_NAME, (int) kind)));
+            break;
+        }
+    }
+}
@@ -27,18 +27,32 @@
 extern "C"
 {
 	#include "postgres.h"
+	#include "access/stratnum.h"
+	#include "catalog/pg_am.h"
+	#include "catalog/pg_type.h"
+	#include "commands/defrem.h"
 	#include "nodes/nodeFuncs.h"
 	#include "nodes/plannodes.h"
+	#include "optimizer/clauses.h"
 	#include "optimizer/optimizer.h"
 	#include "optimizer/prep.h"
 	#include "optimizer/tlist.h"
 	#include "utils/builtins.h"
+	#include "utils/fmgroids.h"
+	#include "utils/lsyscache.h"
+	#include "utils/pg_locale.h"
 	#include "utils/rel.h"
 
     #include "nodes/print.h"
 }
 
 static bool foreign_expr_walker(Node *node, RelOptInfo *baserel);
+static Var *get_pushdown_var(Node *node, RelOptInfo *baserel);
+static bool is_pushdown_value(Node *node, RelOptInfo *baserel);
+static bool is_pushdown_type(Oid coltype, Oid valtype);
+static int get_pushdown_strategy(Oid opno, Oid coltype, bool commute);
+static char *get_orc_column_name(RelOptInfo *baserel, Var *var);
+static List *get_pushdown_pred(RelOptInfo *baserel, Expr *clause, Expr **value);
 
 /*
  * Classify input condition as remote or local. Remote conditions
@@ -84,7 +98,10 @@ is_foreign_expr(PlannerInfo *root, RelOptInfo *baserel, Expr *expr)
 }
 
 /*
- * Returns true if expression is safe to execute remotely.
+ * Returns true if expression is safe to execute remotely. Remote, for ORC,
+ * means that the ORC reader can use the condition to skip stripes and row
+ * groups through column statistics and bloom filters. The condition is
+ * always rechecked locally as pruning is not exact.
  */
 static bool
 foreign_expr_walker(Node *node,
@@ -96,28 +113,22 @@ foreign_expr_walker(Node *node,
 
 	switch (nodeTag(node))
 	{
-		case T_Var:
+		/* col = value and value = col */
+		case T_OpExpr:
+		/* col IN (...) and col = ANY(array) */
+		case T_ScalarArrayOpExpr:
 		{
-			Var		   *var = (Var *) node;
-
-			if (bms_is_member(var->varno, baserel->relids) &&
-				var->varlevelsup == 0)
-			{
-				if (var->varattno < 0 &&
-					var->varattno != SelfItemPointerAttributeNumber)
-					return false;
-			}
+			Expr	   *value = NULL;
 
-			break;
+			return (get_pushdown_pred(baserel, (Expr *) node, &value) != NIL);
 		}
 		/* Not handling these in the current version */
+		case T_Var:
 		case T_Const:
 		case T_Param:
 		case T_SubscriptingRef:
 		case T_FuncExpr:
-		case T_OpExpr:
 		case T_DistinctExpr:
-		case T_ScalarArrayOpExpr:
 		case T_RelabelType:
 		case T_BoolExpr:
 		case T_NullTest:
@@ -141,6 +152,344 @@ foreign_expr_walker(Node *node,
 	return true;
 }
 
+/*
+ * Returns the Var if node is a user column of the foreign table; a binary
+ * compatible relabel over the Var is looked through.
+ */
+static Var *
+get_pushdown_var(Node *node, RelOptInfo *baserel)
+{
+	Var		   *var;
+
+	if (node != NULL && IsA(node, RelabelType))
+		node = (Node *) ((RelabelType *) node)->arg;
+
+	if (node == NULL || !IsA(node, Var))
+		return NULL;
+
+	var = (Var *) node;
+
+	if (!bms_is_member(var->varno, baserel->relids) ||
+		var->varlevelsup != 0 ||
+		var->varattno <= 0)
+		return NULL;
+
+	return var;
+}
+
+/*
+ * Returns true if the node provides a value that can be evaluated once
+ * at the start of a scan; i.e. a constant, a query parameter or, for join
+ * clauses of parameterized paths, an expression over outer relations that
+ * the planner replaces with a parameter. baserel is the scanned relation;
+ * Vars of it make the value depend on the row, as in a = b + 1.
+ */
+static bool
+is_pushdown_value(Node *node, RelOptInfo *baserel)
+{
+	List	   *vars;
+	ListCell   *lc;
+
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Const) || IsA(node, Param))
+		return true;
+
+	if (contain_volatile_functions(node) || contain_subplans(node))
+		return false;
+
+	/* Must not depend on the row being scanned */
+	vars = pull_var_clause(node, PVC_RECURSE_AGGREGATES |
+						   PVC_RECURSE_WINDOWFUNCS |
+						   PVC_INCLUDE_PLACEHOLDERS);
+	foreach(lc, vars)
+	{
+		Node	   *v = (Node *) lfirst(lc);
+
+		if (!IsA(v, Var))
+			return false;
+
+		/* pull_var_clause returns Vars of all relations; only outer ones
+		 * are replaced by parameters */
+		if (bms_is_member(((Var *) v)->varno, baserel->relids) &&
+			((Var *) v)->varlevelsup == 0)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Returns true if a value of valtype can be compared against ORC
+ * statistics and bloom filters of a column mapped to coltype.
+ */
+static bool
+is_pushdown_type(Oid coltype, Oid valtype)
+{
+	switch (coltype)
+	{
+		case BOOLOID:
+			return (valtype == BOOLOID);
+
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+			return (valtype == INT2OID || valtype == INT4OID || valtype == INT8OID);
+
+		case FLOAT4OID:
+		case FLOAT8OID:
+			return (valtype == FLOAT4OID || valtype == FLOAT8OID);
+
+		case TEXTOID:
+		case VARCHAROID:
+			return (valtype == TEXTOID || valtype == VARCHAROID);
+
+		case DATEOID:
+			return (valtype == DATEOID);
+
+		default:
+			return false;
+	}
+}
+
+/*
+ * Returns the btree strategy of the operator in the default btree operator
+ * family of the column type, or 0 if it doesn't belong to it. commute must
+ * be true if the column is on the right side of the operator.
+ */
+static int
+get_pushdown_strategy(Oid opno, Oid coltype, bool commute)
+{
+	Oid			opclass;
+
+	if (commute)
+		opno = get_commutator(opno);
+
+	if (!OidIsValid(opno))
+		return 0;
+
+	opclass = GetDefaultOpClass(coltype, BTREE_AM_OID);
+	if (!OidIsValid(opclass))
+		return 0;
+
+	return get_op_opfamily_strategy(opno, get_opclass_family(opclass));
+}
+
+/*
+ * Returns the name of the ORC column mapped to the Var or NULL if there
+ * is none. ORC column names are matched case insensitively, same as the
+ * target list.
+ */
+static char *
+get_orc_column_name(RelOptInfo *baserel, Var *var)
+{
+	OrcFdwPlanState *fdw_state = (OrcFdwPlanState *) baserel->fdw_private;
+	const OrcFdwColInfo *col;
+	char	   *attname;
+
+	if (fdw_state == NULL)
+		return NULL;
+
+	attname = get_attname(fdw_state->foreigntableid, var->varattno, true);
+	if (attname == NULL)
+		return NULL;
+
+	col = orcFindFileColumn(fdw_state, attname);
+	if (col == NULL)
+		return NULL;
+
+	/* The column must be read as is to use ORC statistics */
+	if (col->col_oid != var->vartype)
+		return NULL;
+
+	return (char *) col->name.c_str();
+}
+
+/*
+ * Returns the pushdown predicate for a clause, or NIL if the clause can't
+ * be pushed down. The predicate is a list of ORC column name, operation
+ * and column type. value is set to the expression that provides the value
+ * to compare with, which is evaluated at execution time.
+ *
+ * ORC string statistics and bloom filters compare bytes. Equality and LIKE
+ * prefixes match by bytes under any deterministic collation, but ranges
+ * of strings are only ordered by bytes under the C collation.
+ */
+static List *
+get_pushdown_pred(RelOptInfo *baserel, Expr *clause, Expr **value)
+{
+	Var		   *var = NULL;
+	Node	   *val = NULL;
+	Oid			opno = InvalidOid;
+	Oid			inputcollid = InvalidOid;
+	Oid			valtype;
+	bool		commute = false;
+	OrcPushdownOp op;
+	char	   *orcname;
+
+	if (IsA(clause, OpExpr))
+	{
+		OpExpr	   *expr = (OpExpr *) clause;
+
+		if (list_length(expr->args) != 2)
+			return NIL;
+
+		var = get_pushdown_var((Node *) linitial(expr->args), baserel);
+		val = (Node *) lsecond(expr->args);
+
+		if (var == NULL)
+		{
+			var = get_pushdown_var((Node *) lsecond(expr->args), baserel);
+			val = (Node *) linitial(expr->args);
+			commute = true;
+		}
+
+		if (var == NULL)
+			return NIL;
+
+		opno = expr->opno;
+		inputcollid = expr->inputcollid;
+		valtype = exprType(val);
+
+		/* The pattern of LIKE must be on the right */
+		if (get_opcode(opno) == F_TEXTLIKE)
+		{
+			if (commute)
+				return NIL;
+
+			op = ORC_PUSHDOWN_PREFIX;
+		}
+		else
+		{
+			switch (get_pushdown_strategy(opno, var->vartype, commute))
+			{
+				case BTEqualStrategyNumber:
+					op = ORC_PUSHDOWN_EQ;
+					break;
+				case BTLessStrategyNumber:
+					op = ORC_PUSHDOWN_LT;
+					break;
+				case BTLessEqualStrategyNumber:
+					op = ORC_PUSHDOWN_LE;
+					break;
+				case BTGreaterStrategyNumber:
+					op = ORC_PUSHDOWN_GT;
+					break;
+				case BTGreaterEqualStrategyNumber:
+					op = ORC_PUSHDOWN_GE;
+					break;
+				default:
+					return NIL;
+			}
+		}
+	}
+	else if (IsA(clause, ScalarArrayOpExpr))
+	{
+		ScalarArrayOpExpr *expr = (ScalarArrayOpExpr *) clause;
+
+		/* Only col = ANY(...) can be used for pruning */
+		if (!expr->useOr || list_length(expr->args) != 2)
+			return NIL;
+
+		var = get_pushdown_var((Node *) linitial(expr->args), baserel);
+		val = (Node *) lsecond(expr->args);
+
+		opno = expr->opno;
+		inputcollid = expr->inputcollid;
+		op = ORC_PUSHDOWN_IN;
+		valtype = get_element_type(exprType(val));
+
+		if (var == NULL || get_pushdown_strategy(opno, var->vartype, false) != BTEqualStrategyNumber)
+			return NIL;
+	}
+	else
+	{
+		return NIL;
+	}
+
+	if (var == NULL || !is_pushdown_value(val, baserel))
+		return NIL;
+
+	if (!is_pushdown_type(var->vartype, valtype))
+		return NIL;
+
+	/* ORC compares strings by bytes, so equality must be bytewise too */
+	if (OidIsValid(inputcollid) && !get_collation_isdeterministic(inputcollid))
+		return NIL;
+
+	if (op == ORC_PUSHDOWN_PREFIX && var->vartype != TEXTOID && var->vartype != VARCHAROID)
+		return NIL;
+
+	if (op >= ORC_PUSHDOWN_LT && op <= ORC_PUSHDOWN_GE &&
+		(var->vartype == TEXTOID || var->vartype == VARCHAROID) &&
+		!lc_collate_is_c(inputcollid))
+		return NIL;
+
+	orcname = get_orc_column_name(baserel, var);
+	if (orcname == NULL)
+		return NIL;
+
+	*value = (Expr *) val;
+
+	return list_make3(makeString(pstrdup(orcname)),
+					  makeInteger(op),
+					  makeInteger((int) var->vartype));
+}
+
+/*
+ * Returns the ORC column name if a join clause can be pushed down to the
+ * ORC reader of a parameterized path; NULL otherwise.
+ */
+char *
+get_param_pushdown_column(RelOptInfo *baserel, RestrictInfo *rinfo)
+{
+	Expr	   *value = NULL;
+	List	   *pred;
+
+	/* Outer values can't be evaluated if volatile */
+	if (contain_volatile_functions((Node *) rinfo->clause))
+		return NULL;
+
+	pred = get_pushdown_pred(baserel, rinfo->clause, &value);
+	if (pred == NIL)
+		return NULL;
+
+	/* Lookups are by value */
+	if (intVal(lsecond(pred)) != ORC_PUSHDOWN_EQ && intVal(lsecond(pred)) != ORC_PUSHDOWN_IN)
+		return NULL;
+
+	return strVal(linitial(pred));
+}
+
+/*
+ * Returns a list of pushdown predicates for remote conditions. The
+ * expressions that provide values for the predicates are appended to
+ * pushdown_exprs in the same order; these go into fdw_exprs so that the
+ * executor evaluates any parameters for us.
+ */
+List *
+build_pushdown_list(RelOptInfo *baserel, List *remote_conds, List **pushdown_exprs)
+{
+	List	   *pushdown = NIL;
+	ListCell   *lc;
+
+	foreach(lc, remote_conds)
+	{
+		RestrictInfo *ri = lfirst_node(RestrictInfo, lc);
+		Expr	   *value = NULL;
+		List	   *pred = get_pushdown_pred(baserel, ri->clause, &value);
+
+		if (pred == NIL)
+			continue;
+
+		pushdown = lappend(pushdown, pred);
+		*pushdown_exprs = lappend(*pushdown_exprs, value);
+	}
+
+	return pushdown;
+}
+
 /*
  * Returns a target list containing columns that need to be read from the
  * ORC file.
@@ -154,7 +503,8 @@ build_tlist_to_deparse(RelOptInfo *foreignrel)
 
 	/*
 	 * Get columns specified in foreignrel->reltarget->exprs and those
-	 * required for evaluating the local conditions.
+	 * required for evaluating the conditions. Remote conditions are
+	 * rechecked locally as well, so we need their columns too.
 	 */
 	tlist = add_to_flat_tlist(tlist, pull_var_clause((Node *) foreignrel->reltarget->exprs, PVC_RECURSE_PLACEHOLDERS));
 
@@ -164,5 +514,11 @@ build_tlist_to_deparse(RelOptInfo *foreignrel)
 		tlist = add_to_flat_tlist(tlist, pull_var_clause((Node *) rinfo->clause, PVC_RECURSE_PLACEHOLDERS));
 	}
 
+	foreach(lc, fpinfo->remote_conds)
+	{
+		RestrictInfo *rinfo = lfirst_node(RestrictInfo, lc);
+		tlist = add_to_flat_tlist(tlist, pull_var_clause((Node *) rinfo->clause, PVC_RECURSE_PLACEHOLDERS));
+	}
+
 	return tlist;
 }
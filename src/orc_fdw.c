@@ -33,6 +33,10 @@
 /* ORC FDW specific includes */
 #include <orc_fdw.h>
 #include <orc_interface.h>
+#include <orc_modify.h>
+#include <orc_pool.h>
+#include <orc_sample.h>
+#include <orc_stats.h>
 
 
 /* Magic */
@@ -51,16 +55,9 @@ PG_FUNCTION_INFO_V1(orc_fdw_version);
 List *orcImportForeignSchema(ImportForeignSchemaStmt *stmt, Oid serverOid);
 bool orcAnalyzeForeignTable(Relation relation, AcquireSampleRowsFunc *func, BlockNumber *totalpages);
 bool orcIsForeignScanParallelSafe(PlannerInfo *root, RelOptInfo *rel, RangeTblEntry *rte);
-int orcIsForeignRelUpdatable(Relation rel);
 void orcAddForeignUpdateTargets(Query *parsetree, RangeTblEntry *target_rte, Relation target_relation);
-List *orcPlanForeignModify(PlannerInfo *root, ModifyTable *plan, Index resultRelation, int subplan_index);
-void orcBeginForeignModify(ModifyTableState *mstate, ResultRelInfo *rinfo, List *fdw_private, int subplan_index, int eflags);
-TupleTableSlot *orcExecForeignInsert(EState *estate, ResultRelInfo *rinfo, TupleTableSlot *slot, TupleTableSlot *planSlot);
 TupleTableSlot *orcExecForeignUpdate(EState *estate, ResultRelInfo *rinfo, TupleTableSlot *slot, TupleTableSlot *planSlot);
 TupleTableSlot *orcExecForeignDelete(EState *estate, ResultRelInfo *rinfo, TupleTableSlot *slot, TupleTableSlot *planSlot);
-void orcEndForiegnModify(EState *estate, ResultRelInfo *rinfo);
-void orcExplainForeignModify(ModifyTableState *mstate, ResultRelInfo *rinfo, List *fdw_private, int subplan_index, struct ExplainState *es);
-void orcEndForeignModify(EState *estate, ResultRelInfo *rinfo);
 
 /* FDW routines */
 
@@ -71,6 +68,14 @@ void orcEndForeignModify(EState *estate, ResultRelInfo *rinfo);
 void
 _PG_init(void)
 {
+    /* Shared memory for pg_stat_orc_fdw */
+    orcStatsInit();
+
+    orcModifyInit();
+
+    orcReaderPoolInit();
+
+    orcSampleInit();
 }
 
 /*
@@ -108,6 +113,12 @@ orc_fdw_handler(PG_FUNCTION_ARGS)
 	fdwroutine->ExecForeignDelete = orcExecForeignDelete;
 	fdwroutine->EndForeignModify = orcEndForeignModify;
 	fdwroutine->ExplainForeignModify = orcExplainForeignModify;
+	fdwroutine->BeginForeignInsert = orcBeginForeignInsert;
+	fdwroutine->EndForeignInsert = orcEndForeignInsert;
+#if PG_VERSION_NUM >= 140000
+	fdwroutine->GetForeignModifyBatchSize = orcGetForeignModifyBatchSize;
+	fdwroutine->ExecForeignBatchInsert = orcExecForeignBatchInsert;
+#endif
 
 	fdwroutine->GetForeignJoinPaths = orcGetForeignJoinPaths;
 
@@ -285,43 +296,10 @@ orcIsForeignScanParallelSafe(PlannerInfo *root, RelOptInfo *rel, RangeTblEntry *
     return false;
 }
 
-int
-orcIsForeignRelUpdatable(Relation rel)
-{
-    ereport(INFO, (errmsg("%s: INSERT, UPDATE and DELETE %s", ORC_FDW_NAME, ORC_MSG_UNSUPPORTED)));
-
-    /* Not supporting this at the moment */
-    return 0;
-}
-
 void
 orcAddForeignUpdateTargets(Query *parsetree, RangeTblEntry *target_rte, Relation target_relation)
 {
-    ereport(ERROR, (errmsg("%s: INSERT, UPDATE and DELETE %s", ORC_FDW_NAME, ORC_MSG_UNSUPPORTED)));
-}
-
-List *
-orcPlanForeignModify(PlannerInfo *root, ModifyTable *plan, Index resultRelation, int subplan_index)
-{
-    ereport(ERROR, (errmsg("%s: INSERT, UPDATE and DELETE %s", ORC_FDW_NAME, ORC_MSG_UNSUPPORTED)));
-
-    /* Not supporting this at the moment */
-    return NULL;
-}
-
-void
-orcBeginForeignModify(ModifyTableState *mstate, ResultRelInfo *rinfo, List *fdw_private, int subplan_index, int eflags)
-{
-    ereport(ERROR, (errmsg("%s: INSERT, UPDATE and DELETE %s", ORC_FDW_NAME, ORC_MSG_UNSUPPORTED)));
-}
-
-TupleTableSlot *
-orcExecForeignInsert(EState *estate, ResultRelInfo *rinfo, TupleTableSlot *slot, TupleTableSlot *planSlot)
-{
-    ereport(ERROR, (errmsg("%s: INSERT %s", ORC_FDW_NAME, ORC_MSG_UNSUPPORTED)));
-
-    /* Not supporting this at the moment */
-    return NULL;
+    ereport(ERROR, (errmsg("%s: UPDATE and DELETE %s", ORC_FDW_NAME, ORC_MSG_UNSUPPORTED)));
 }
 
 TupleTableSlot *
@@ -341,24 +319,3 @@ orcExecForeignDelete(EState *estate, ResultRelInfo *rinfo, TupleTableSlot *slot,
     /* Not supporting this at the moment */
     return NULL;
 }
-
-void
-orcEndForiegnModify(EState *estate, ResultRelInfo *rinfo)
-{
-    /* Not supporting this at the moment */
-    ereport(ERROR, (errmsg("%s: INSERT, UPDATE and DELETE %s", ORC_FDW_NAME, ORC_MSG_UNSUPPORTED)));
-}
-
-void
-orcExplainForeignModify(ModifyTableState *mstate, ResultRelInfo *rinfo, List *fdw_private, int subplan_index, struct ExplainState *es)
-{
-    /* Not supporting this at the moment */
-    ereport(ERROR, (errmsg("%s: INSERT, UPDATE and DELETE %s", ORC_FDW_NAME, ORC_MSG_UNSUPPORTED)));
-}
-
-void
-orcEndForeignModify(EState *estate, ResultRelInfo *rinfo)
-{
-    /* Not supporting this at the moment */
-    ereport(ERROR, (errmsg("%s: INSERT, UPDATE and DELETE %s", ORC_FDW_NAME, ORC_MSG_UNSUPPORTED)));
-}
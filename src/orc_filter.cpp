@@ -0,0 +1,274 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_filter.cpp
+ *    Filters applied by ORC FDW to row batches before rows are converted
+ *    to tuples.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ *    Filters work on a whole row batch at a time and produce a selection
+ *    vector of rows that may qualify. These only drop rows that can't
+ *    match; the executor still checks the quals for the remaining rows.
+ *    Sorted and low cardinality columns decode into runs of a repeated
+ *    value; a filter is evaluated once per run and keeps or drops the
+ *    whole run.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    src/orc_filter.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+/* ORC FDW header files */
+#include <orc_filter.h>
+
+/* PostgreSQL and FDW header files */
+extern "C"
+{
+    #include "c.h"
+    #include "orc_fdw.h"
+}
+
+
+/* Declare the functions to use within this file */
+static inline uint64_t hashRuntimeFilterValue(int64_t value);
+static inline bool runtimeFilterMightContain(const OrcRuntimeFilter &filter, int64_t value);
+static inline bool stringFilterMatches(const OrcStringFilter &filter, const char *data, int64_t length);
+static int64_t applyStringFilter(const OrcStringFilter &filter, orc::StringVectorBatch *col, std::vector<uint32_t> &sel, int64_t nsel);
+
+
+/*
+ * hashRuntimeFilterValue
+ *    64 bit finalizer of MurmurHash3; good enough spread for bloom bits.
+ */
+static inline
+uint64_t
+hashRuntimeFilterValue(int64_t value)
+{
+    uint64_t h = (uint64_t) value;
+
+    h ^= h >> 33;
+    h *= UINT64CONST(0xff51afd7ed558ccd);
+    h ^= h >> 33;
+    h *= UINT64CONST(0xc4ceb9fe1a85ec53);
+    h ^= h >> 33;
+
+    return h;
+}
+
+/*
+ * runtimeFilterMightContain
+ *    Blocked bloom filter probe; all bits of a value are in a single word
+ *    so that a probe touches one cache line.
+ */
+static inline
+bool
+runtimeFilterMightContain(const OrcRuntimeFilter &filter, int64_t value)
+{
+    uint64_t h = hashRuntimeFilterValue(value);
+    uint64_t word = filter.bloom[(h >> 32) & filter.bloom_mask];
+    uint64_t bits = (UINT64CONST(1) << (h & 63))
+                    | (UINT64CONST(1) << ((h >> 6) & 63))
+                    | (UINT64CONST(1) << ((h >> 12) & 63));
+
+    return ((word & bits) == bits);
+}
+
+/*
+ * stringFilterMatches
+ *    Compares a string with the value of the filter by bytes.
+ */
+static inline
+bool
+stringFilterMatches(const OrcStringFilter &filter, const char *data, int64_t length)
+{
+    int64_t vlen = (int64_t) filter.value.size();
+    int cmp;
+
+    if (filter.op == ORC_STRING_PREFIX)
+        return (length >= vlen && memcmp(data, filter.value.data(), vlen) == 0);
+
+    cmp = memcmp(data, filter.value.data(), Min(length, vlen));
+
+    if (cmp == 0)
+        cmp = (length > vlen) - (length < vlen);
+
+    switch (filter.op)
+    {
+        case ORC_STRING_LT:
+            return (cmp < 0);
+        case ORC_STRING_LE:
+            return (cmp <= 0);
+        case ORC_STRING_GT:
+            return (cmp > 0);
+        case ORC_STRING_GE:
+            return (cmp >= 0);
+        default:
+            return true;
+    }
+}
+
+/*
+ * applyStringFilter
+ *    Compacts sel to the rows whose string passes the filter and returns
+ *    their count. Dictionary encoded strings point into the dictionary,
+ *    so a row with the same string as the row before reuses its outcome.
+ */
+static
+int64_t
+applyStringFilter(const OrcStringFilter &filter, orc::StringVectorBatch *col, std::vector<uint32_t> &sel, int64_t nsel)
+{
+    char * const *data = col->data.data();
+    const int64_t *length = col->length.data();
+    const char *notNull = col->hasNulls ? col->notNull.data() : NULL;
+    const char *prev_data = NULL;
+    int64_t prev_length = -1;
+    bool prev_keep = false;
+    int64_t k = 0;
+
+    for (int64_t i = 0; i < nsel; i++)
+    {
+        uint32_t row = sel[i];
+        bool keep;
+
+        if (notNull != NULL && !notNull[row])
+            keep = false;
+        else if (data[row] == prev_data && length[row] == prev_length)
+            keep = prev_keep;
+        else
+        {
+            keep = stringFilterMatches(filter, data[row], length[row]);
+
+            prev_data = data[row];
+            prev_length = length[row];
+            prev_keep = keep;
+        }
+
+        sel[k] = row;
+        k += keep;
+    }
+
+    return k;
+}
+
+/*
+ * orcBuildRuntimeFilter
+ *    Builds the range and bloom filter for a set of values.
+ */
+void
+orcBuildRuntimeFilter(OrcRuntimeFilter &filter, int field_index, const std::vector<int64_t> &values)
+{
+    uint64_t words = 1;
+
+    filter.field_index = field_index;
+    filter.min = PG_INT64_MAX;
+    filter.max = PG_INT64_MIN;
+
+    /* Size the filter to a power of 2 words */
+    while (words * 64 < values.size() * ORC_RUNTIME_FILTER_BITS_PER_VALUE)
+        words <<= 1;
+
+    filter.bloom.assign(words, 0);
+    filter.bloom_mask = words - 1;
+
+    for (auto value = values.begin(); value != values.end(); value++)
+    {
+        uint64_t h = hashRuntimeFilterValue(*value);
+
+        filter.bloom[(h >> 32) & filter.bloom_mask] |= (UINT64CONST(1) << (h & 63))
+                                                        | (UINT64CONST(1) << ((h >> 6) & 63))
+                                                        | (UINT64CONST(1) << ((h >> 12) & 63));
+
+        filter.min = Min(filter.min, *value);
+        filter.max = Max(filter.max, *value);
+    }
+}
+
+/*
+ * orcBuildRangeFilter
+ *    Builds a filter for a range of values, without a bloom filter.
+ */
+void
+orcBuildRangeFilter(OrcRuntimeFilter &filter, int field_index, int64_t min, int64_t max)
+{
+    filter.field_index = field_index;
+    filter.min = min;
+    filter.max = max;
+    filter.bloom.clear();
+    filter.bloom_mask = 0;
+}
+
+/*
+ * orcApplyRuntimeFilters
+ *    Fills sel with rows of the batch that pass all filters and returns
+ *    their count. NULLs never pass as these filters come from equality,
+ *    comparison and LIKE conditions. Selected rows with the same value,
+ *    or NULL, next to each other form a run that is checked once.
+ */
+int64_t
+orcApplyRuntimeFilters(const std::vector<OrcRuntimeFilter> &filters, const std::vector<OrcStringFilter> &string_filters, orc::StructVectorBatch *batch, std::vector<uint32_t> &sel)
+{
+    int64_t nrows = (int64_t) batch->numElements;
+    int64_t nsel = nrows;
+
+    sel.resize(nrows);
+
+    for (int64_t i = 0; i < nrows; i++)
+        sel[i] = (uint32_t) i;
+
+    for (auto filter = filters.begin(); filter != filters.end() && nsel > 0; filter++)
+    {
+        orc::LongVectorBatch *col = dynamic_cast<orc::LongVectorBatch *>(batch->fields[filter->field_index]);
+        const int64_t *data = col->data.data();
+        const char *notNull = col->hasNulls ? col->notNull.data() : NULL;
+        int64_t k = 0;
+        int64_t i = 0;
+
+        while (i < nsel)
+        {
+            uint32_t row = sel[i];
+            int64_t value = data[row];
+            bool isnull = (notNull != NULL && !notNull[row]);
+            int64_t end = i + 1;
+            bool keep;
+
+            /* Extend the run while the value repeats */
+            if (notNull == NULL)
+            {
+                while (end < nsel && data[sel[end]] == value)
+                    end++;
+            }
+            else
+            {
+                while (end < nsel && data[sel[end]] == value && !notNull[sel[end]] == isnull)
+                    end++;
+            }
+
+            keep = !isnull
+                    && (value >= filter->min && value <= filter->max)
+                    && (filter->bloom.empty() || runtimeFilterMightContain(*filter, value));
+
+            /* Keep or drop the whole run; kept rows move down in place */
+            if (keep)
+            {
+                for (; i < end; i++)
+                    sel[k++] = sel[i];
+            }
+
+            i = end;
+        }
+
+        nsel = k;
+    }
+
+    for (auto filter = string_filters.begin(); filter != string_filters.end() && nsel > 0; filter++)
+    {
+        orc::StringVectorBatch *col = dynamic_cast<orc::StringVectorBatch *>(batch->fields[filter->field_index]);
+
+        nsel = applyStringFilter(*filter, col, sel, nsel);
+    }
+
+    return nsel;
+}
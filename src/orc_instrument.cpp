@@ -0,0 +1,192 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_instrument.cpp
+ *    Counters collected while scanning an ORC file and reported by
+ *    EXPLAIN ANALYZE.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ *    Bytes and time spent in I/O are counted by wrapping the file input
+ *    stream, and memory by the memory pool given to the ORC reader. The
+ *    remaining counters are updated by the scan per batch.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    src/orc_instrument.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+/* C++ header files */
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+/* ORC FDW header files */
+#include <orc_instrument.h>
+
+
+/* Size of the header storing allocation size; keeps 16 byte alignment */
+#define ORC_MEMORY_POOL_HEADER_SIZE 16
+
+
+/*
+ * OrcCountingInputStream
+ *    Takes ownership of the underlying stream.
+ */
+OrcCountingInputStream::OrcCountingInputStream(ORC_UNIQUE_PTR<orc::InputStream> stream, OrcFdwScanStats *stats)
+    : stream(std::move(stream)), stats(stats)
+{
+}
+
+uint64_t
+OrcCountingInputStream::getLength() const
+{
+    return stream->getLength();
+}
+
+uint64_t
+OrcCountingInputStream::getNaturalReadSize() const
+{
+    return stream->getNaturalReadSize();
+}
+
+void
+OrcCountingInputStream::read(void *buf, uint64_t length, uint64_t offset)
+{
+    uint64_t start = orcClockNs();
+
+    stream->read(buf, length, offset);
+
+    if (stats != NULL)
+    {
+        stats->io_ns += orcClockNs() - start;
+        stats->bytes_read += length;
+    }
+}
+
+const std::string &
+OrcCountingInputStream::getName() const
+{
+    return stream->getName();
+}
+
+void
+OrcCountingInputStream::setStats(OrcFdwScanStats *stats)
+{
+    this->stats = stats;
+}
+
+/*
+ * OrcTrackingMemoryPool
+ *    Each allocation is prefixed with its size so that free can account
+ *    for it.
+ */
+OrcTrackingMemoryPool::OrcTrackingMemoryPool()
+    : allocated(0), peak(0)
+{
+}
+
+char *
+OrcTrackingMemoryPool::malloc(uint64_t size)
+{
+    char *p = static_cast<char *>(std::malloc(size + ORC_MEMORY_POOL_HEADER_SIZE));
+
+    if (p == NULL)
+        throw std::bad_alloc();
+
+    *reinterpret_cast<uint64_t *>(p) = size;
+
+    allocated += size;
+    peak = std::max(peak, allocated);
+
+    return p + ORC_MEMORY_POOL_HEADER_SIZE;
+}
+
+void
+OrcTrackingMemoryPool::free(char *p)
+{
+    if (p == NULL)
+        return;
+
+    p -= ORC_MEMORY_POOL_HEADER_SIZE;
+    allocated -= *reinterpret_cast<uint64_t *>(p);
+
+    std::free(p);
+}
+
+uint64_t
+OrcTrackingMemoryPool::getPeak() const
+{
+    return peak;
+}
+
+/*
+ * resetPeak
+ *    Starts counting the peak from memory allocated now; for a new scan
+ *    using a pooled reader.
+ */
+void
+OrcTrackingMemoryPool::resetPeak()
+{
+    peak = allocated;
+}
+
+/*
+ * orcScanStatsSetStripes
+ *    Notes where stripes of the file start.
+ */
+void
+orcScanStatsSetStripes(OrcFdwScanStats &stats, ORC_UNIQUE_PTR<orc::Reader> *p_reader)
+{
+    uint64_t nstripes = (*p_reader)->getNumberOfStripes();
+    uint64_t first_row = 0;
+
+    stats.stripe_first_row.resize(nstripes);
+
+    for (uint64_t i = 0; i < nstripes; i++)
+    {
+        stats.stripe_first_row[i] = first_row;
+        first_row += (*p_reader)->getStripe(i)->getNumberOfRows();
+    }
+}
+
+/*
+ * orcScanStatsBatch
+ *    Counts a batch starting at first_row in the file. The row reader only
+ *    moves forward, so stripes between the previous batch and this one
+ *    were skipped by the search argument.
+ */
+void
+orcScanStatsBatch(OrcFdwScanStats &stats, uint64_t first_row, uint64_t rows)
+{
+    auto it = std::upper_bound(stats.stripe_first_row.begin(), stats.stripe_first_row.end(), first_row);
+    int64_t stripe = (int64_t) (it - stats.stripe_first_row.begin()) - 1;
+
+    stats.batches++;
+    stats.batch_rows += rows;
+
+    if (stripe > stats.curr_stripe)
+    {
+        stats.stripes_read++;
+        stats.stripes_skipped += stripe - stats.curr_stripe - 1;
+        stats.curr_stripe = stripe;
+    }
+}
+
+/*
+ * orcScanStatsEnd
+ *    Counts stripes after the last batch as skipped once the row reader
+ *    has reached the end of the file.
+ */
+void
+orcScanStatsEnd(OrcFdwScanStats &stats)
+{
+    int64_t nstripes = (int64_t) stats.stripe_first_row.size();
+
+    if (stats.curr_stripe < nstripes - 1)
+        stats.stripes_skipped += nstripes - stats.curr_stripe - 1;
+
+    stats.curr_stripe = nstripes - 1;
+}
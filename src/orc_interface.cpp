@@ -21,54 +21,176 @@
 
 /* C++ header files */
 #include <sstream>
+#include <unordered_map>
 #include <vector>
 #include <bits/stdc++.h>
 
 /* ORC FDW header files */
+#include <orc_filter.h>
 #include <orc_wrapper.h>
 #include <orc_interface.h>
 #include <orc_deparse.h>
 #include <orc_interface_typedefs.h>
+#include <orc_pool.h>
+#include <orc_sample.h>
+#include <orc_stats.h>
+#include <orc_writer.h>
 
 /* PostgreSQL header files */
 extern "C"
 {
     #include "orc_fdw.h"
     #include "fmgr.h"
+    #include "funcapi.h"
+    #include "miscadmin.h"
+    #include "access/htup_details.h"
     #include "access/table.h"
     #include "catalog/pg_type.h"
     #include "commands/defrem.h"
     #include "commands/explain.h"
+    #include "executor/executor.h"
+    #include "nodes/nodeFuncs.h"
     #include "optimizer/cost.h"
     #include "optimizer/optimizer.h"
     #include "optimizer/pathnode.h"
+    #include "optimizer/paths.h"
     #include "optimizer/planmain.h"
     #include "optimizer/restrictinfo.h"
     #include "parser/parse_coerce.h"
+    #include "utils/array.h"
     #include "utils/builtins.h"
     #include "utils/date.h"
+    #include "utils/fmgroids.h"
+    #include "utils/jsonb.h"
     #include "utils/lsyscache.h"
     #include "utils/memutils.h"
     #include "utils/numeric.h"
     #include "utils/palloc.h"
     #include "utils/rel.h"
     #include "utils/timestamp.h"
+    #include "utils/tuplestore.h"
+    #include "utils/typcache.h"
 
     #include "nodes/print.h"
 }
 
+/* fmgroids.h names functions with their argument types since PG 14 */
+#if PG_VERSION_NUM < 140000
+#define F_COUNT_ 2803
+#endif
+
+/*
+ * Indexes of FDW-private information stored in fdw_private list of a
+ * ForeignScan plan node.
+ */
+enum OrcFdwScanPrivateIndex
+{
+    /* Pathname of the ORC file */
+    OrcFdwScanPrivateFilename,
+
+    /* Integer list of ORC column indexes to read */
+    OrcFdwScanPrivateColIndex,
+
+    /* Integer flag; true if row reader must be limited to columns */
+    OrcFdwScanPrivateSetRowReader,
+
+    /* List of pushdown predicates; values are in fdw_exprs */
+    OrcFdwScanPrivatePushdown,
+
+    /* Integer flag; true if rows are cached for rescans */
+    OrcFdwScanPrivateRescanCache,
+
+    /* Integer list of ORC column ids to read; NIL reads the columns
+     * of OrcFdwScanPrivateColIndex */
+    OrcFdwScanPrivateTypeIds,
+
+    /* Column names of the scan tuple, matched to ORC columns by name;
+     * NIL if the scan tuple is the table row */
+    OrcFdwScanPrivateAttrNames,
+
+    /* Oid list of the types of the scan tuple's columns */
+    OrcFdwScanPrivateAttrTypes,
+
+    /* Integer OrcFdwZeroColumns; rows without reading the file */
+    OrcFdwScanPrivateZeroColumns,
+
+    /* Sampling method, percentage and seed */
+    OrcFdwScanPrivateSample
+};
+
+/*
+ * Columns of a scan used through field selection; a path lists the names
+ * of the fields selected, starting with a field of the column.
+ */
+typedef struct
+{
+    Index relid;
+    int sublevels_up;
+    Bitmapset *whole_attrs;     /* columns used other than by field */
+    List *field_attrs;          /* attribute number of each path */
+    List *field_paths;          /* field names selected from the column */
+} OrcFdwFieldSelectContext;
+
+/* Callback argument for ec_member_matches_foreign */
+typedef struct
+{
+    Expr *current;          /* current expr, or NULL if not yet found */
+    List *already_used;     /* expressions already dealt with */
+} ec_member_foreign_arg;
+
 /* Declare the functions to use within this file */
 static std::vector<OrcFdwColInfo> getMappedColsFromFile(std::string file_pathname);
 static std::vector<OrcFdwColInfo> getMappedColsFromReader(ORC_UNIQUE_PTR<orc::Reader> *p_reader, ORC_UNIQUE_PTR<orc::RowReader> *p_rowReader, orc::StructVectorBatch *root);
 static std::vector<OrcFdwColInfo> map2PGColsList(orc::StructVectorBatch *root, std::vector<OrcFileColInfo> orc_col_list);
+static bool mapColInfo(orc::StructVectorBatch *root, const OrcFileColInfo &file_col, OrcFdwColInfo &col);
 static bool getColMetaData(orc::StructVectorBatch *root, OrcFdwColInfo &col);
 static OrcPgTypeKind getColType(int orcKind);
-static void setCastingFunc(OrcFdwColInfo &col, Oid targetOid);
-static bool getColumnNameList(RelOptInfo *baserel, OrcFdwPlanState *fdw_state, List *tlist);
-static Datum getDatumForData(OrcFdwExecState *fdw_estate, int row_in_batch, int orc_index, Oid targetOid);
-static OrcFdwExecState* orcInitExecState(OrcFdwExecState **fdw_estate, char *filename, List *col_orc_file_index, RangeTblEntry *rte, List *fdw_scan_tlist, bool blnShouldSetRowReader);
+static void setCastingFunc(OrcFdwColInfo &col, Oid targetOid, const char *attname);
+static void setCompositeType(OrcFdwColInfo &col, Oid typid);
+static bool getColumnNameList(PlannerInfo *root, RelOptInfo *baserel, OrcFdwPlanState *fdw_state, List *tlist);
+static bool getFieldSelects(Node *node, OrcFdwFieldSelectContext *context);
+static List *getFieldPaths(OrcFdwFieldSelectContext *context, AttrNumber attnum);
+static List *getSelectedTypeIds(OrcFdwPlanState *fdw_state, List *cols_name_reqd, List *cols_paths_reqd);
+static int getFieldTypeId(List *fields, List *path);
+static List *getStructFieldList(const OrcFdwColInfo &col);
+static Datum getDatumForData(OrcFdwExecState *fdw_estate, int row_in_batch, int orc_index, bool *isnull);
+static inline bool isStagedColumn(const OrcFdwColInfo &col);
+static void stageColumn(OrcFdwExecState *fdw_estate, OrcFdwColInfo &col, orc::ColumnVectorBatch *field);
+static Datum getColumnDatum(OrcFdwExecState *fdw_estate, const OrcFdwColInfo &col, orc::ColumnVectorBatch *field, int64_t row);
+static Datum getArrayDatum(OrcFdwExecState *fdw_estate, const OrcFdwColInfo &col, orc::ColumnVectorBatch *field, int64_t row);
+static Datum getCompositeDatum(OrcFdwExecState *fdw_estate, const OrcFdwColInfo &col, orc::ColumnVectorBatch *field, int64_t row);
+static JsonbValue *pushJsonbColumn(OrcFdwExecState *fdw_estate, JsonbParseState **state, const OrcFdwColInfo &col, orc::ColumnVectorBatch *field, int64_t row, JsonbIteratorToken token);
+static JsonbValue *pushJsonbScalar(JsonbParseState **state, JsonbValue *v, JsonbIteratorToken token);
+static void getJsonbScalar(OrcFdwExecState *fdw_estate, const OrcFdwColInfo &col, orc::ColumnVectorBatch *field, int64_t row, JsonbValue *v);
+static OrcFdwExecState* orcInitExecState(OrcFdwExecState **fdw_estate, char *filename, List *col_orc_file_index, List *col_orc_type_ids, List *attr_names, List *attr_types, bool blnShouldSetRowReader, OrcFdwZeroColumns zero_columns);
+static void getScanAttrs(Oid foreigntableid, List *fdw_scan_tlist, List **attr_names, List **attr_types);
+static orc::PredicateDataType getPushdownType(Oid coltype);
+static orc::Literal getPushdownLiteral(Datum value, Oid valtype);
+static int64_t getPushdownLong(Datum value, Oid valtype);
+static int getBatchField(OrcFdwExecState *fdw_estate, const std::string &orcname);
+static void addRuntimeFilter(OrcFdwExecState *fdw_estate, const std::string &orcname, const std::vector<int64_t> &values);
+static void addRangeFilter(OrcFdwExecState *fdw_estate, const std::string &orcname, OrcPushdownOp op, int64_t value);
+static void addStringFilter(OrcFdwExecState *fdw_estate, const std::string &orcname, OrcStringFilterOp op, const std::string &value);
+static std::string getLikePrefix(Datum pattern);
+static bool setSearchArgument(OrcFdwExecState *fdw_estate, ExprContext *econtext);
+static void resetRowReader(OrcFdwExecState *fdw_estate, ExprContext *econtext);
+static bool rescanFromCache(OrcFdwExecState *fdw_estate, ForeignScanState *node);
+static uint64_t getDecodeNs(OrcFdwExecState *fdw_estate);
+static void explainScanStats(OrcFdwExecState *fdw_estate, ExplainState *es);
+static void reportScanStats(OrcFdwExecState *fdw_estate);
 static TupleTableSlot *fillSlot(OrcFdwExecState *fdw_estate, TupleTableSlot *slot);
+static TupleTableSlot *nextFooterRow(OrcFdwExecState *fdw_estate, TupleTableSlot *slot);
+static bool isFooterCount(PlannerInfo *root, RelOptInfo *input_rel, RelOptInfo *output_rel);
+static ForeignScan *getFooterCountPlan(OrcFdwPlanState *fdw_state, List *tlist, Plan *outer_plan);
+static List *getSamplePrivate(OrcFdwPlanState *fdw_state);
 static Datum shouldReturnTuple(OrcFdwExecState *fdw_estate, List *node, Node *exprNode);
+static bool isLookupColumn(OrcFdwPlanState *fdw_state, const char *orcname);
+static bool ec_member_matches_foreign(PlannerInfo *root, RelOptInfo *rel, EquivalenceClass *ec, EquivalenceMember *em, void *arg);
+static void addParamPaths(PlannerInfo *root, RelOptInfo *baserel, OrcFdwPlanState *fdw_private);
+static bool hasNullFreeTest(RelOptInfo *baserel, OrcFdwPlanState *fdw_state);
+static std::shared_ptr<const OrcFdwFileColumns> getFileColumns(ORC_UNIQUE_PTR<orc::Reader> *p_reader);
+static std::shared_ptr<const OrcFdwFileColumns> *keepFileColumns(const std::shared_ptr<const OrcFdwFileColumns> &columns);
+static void releaseFileColumns(void *arg);
 static void checkTypeMatch(Oid srcOid, Oid targetOid, const char *attname);
 
 
@@ -116,30 +238,54 @@ map2PGColsList(orc::StructVectorBatch *root, std::vector<OrcFileColInfo> orc_col
     {
         OrcFdwColInfo col;
 
-        col.kind = getColType(orc_col_list[col_index].kind);
-
         /* Skip unsupported columns */
-        if (col.kind == OrcPgTypeKind::UNSUPPORTED_TYPE)
+        if (!mapColInfo(root, orc_col_list[col_index], col))
             continue;
 
-        /* Initialize with known value and set remaining as invalid 
-         * to be set later. */
-        col.name = orc_col_list[col_index].name;
-        col.index = orc_col_list[col_index].index;
-        col.max_length = orc_col_list[col_index].max_length;
-        col.hasNull = orc_col_list[col_index].hasNull;
-        col.precision = orc_col_list[col_index].precision;
-        col.scale = orc_col_list[col_index].scale;
-
-        /* Fill in and adjust values in the structure */
-        (void) getColMetaData(root, col);
-
         fdw_col_list.push_back(col);
     }
 
     return fdw_col_list;
 }
 
+/*
+ * mapColInfo
+ *    Fills in column meta data for an ORC column and the types nested in
+ *    it. Returns false if the column or a nested type is unsupported.
+ */
+static
+bool
+mapColInfo(orc::StructVectorBatch *root, const OrcFileColInfo &file_col, OrcFdwColInfo &col)
+{
+    col.kind = getColType(file_col.kind);
+
+    if (col.kind == OrcPgTypeKind::UNSUPPORTED_TYPE)
+        return false;
+
+    /* Initialize with known value and set remaining as invalid 
+     * to be set later. */
+    col.name = file_col.name;
+    col.index = file_col.index;
+    col.col_id = file_col.col_id;
+    col.max_length = file_col.max_length;
+    col.hasNull = file_col.hasNull;
+    col.precision = file_col.precision;
+    col.scale = file_col.scale;
+
+    for (auto child = file_col.children.begin(); child != file_col.children.end(); child++)
+    {
+        OrcFdwColInfo child_col;
+
+        if (!mapColInfo(root, *child, child_col))
+            return false;
+
+        col.children.push_back(child_col);
+    }
+
+    /* Fill in and adjust values in the structure */
+    return getColMetaData(root, col);
+}
+
 /*
  * getColType
  *    Map ORC types to ORC FDW internal types
@@ -151,10 +297,7 @@ getColType(int orcKind)
     OrcPgTypeKind type = (OrcPgTypeKind)orcKind;
 
     /* Let's map the unsupported types to a common type */
-    if (type == OrcPgTypeKind::LIST_UNSUPPORTED
-        || type == OrcPgTypeKind::MAP_UNSUPPORTED
-        || type == OrcPgTypeKind::STRUCT_UNSUPPORTED
-        || type == OrcPgTypeKind::UNION_UNSUPPORTED)
+    if (type == OrcPgTypeKind::UNION_UNSUPPORTED)
     {
         type = OrcPgTypeKind::UNSUPPORTED_TYPE;
     }
@@ -176,12 +319,20 @@ getColMetaData(orc::StructVectorBatch *root, OrcFdwColInfo &col)
      * these later if required. */
     col.cast_func = NULL;
     col.is_binary_compatible = true;
+    col.cast_kind = ORC_CAST_NONE;
+    col.cast_in_func = NULL;
+    col.cast_ioparam = InvalidOid;
+    col.pack_kind = ORC_PACK_NONE;
+    col.batch_staged = false;
+    col.batch_has_nulls = false;
+    col.tupdesc = NULL;
 
     switch(col.kind)
     {
         case OrcPgTypeKind::BOOLEAN:
         {
             col.col_oid = BOOLOID;
+            col.pack_kind = ORC_PACK_BOOL;
             col.size = sizeof(bool);
             break;
         }
@@ -189,30 +340,35 @@ getColMetaData(orc::StructVectorBatch *root, OrcFdwColInfo &col)
         case OrcPgTypeKind::SHORT:
         {
             col.col_oid = INT2OID;
+            col.pack_kind = ORC_PACK_INT2;
             col.size = sizeof(int16_t);
             break;
         }
         case OrcPgTypeKind::INT:
         {
             col.col_oid = INT4OID;
+            col.pack_kind = ORC_PACK_INT4;
             col.size = sizeof(int32_t);
             break;
         }
         case OrcPgTypeKind::LONG:
         {
             col.col_oid = INT8OID;
+            col.pack_kind = ORC_PACK_INT8;
             col.size = sizeof(int64_t);
             break;
         }
         case OrcPgTypeKind::FLOAT:
         {
             col.col_oid = FLOAT4OID;
+            col.pack_kind = ORC_PACK_FLOAT4;
             col.size = sizeof(float4);
             break;
         }
         case OrcPgTypeKind::DOUBLE:
         {
             col.col_oid = FLOAT8OID;
+            col.pack_kind = ORC_PACK_FLOAT8;
             col.size = sizeof(float8);
             break;
         }
@@ -260,13 +416,36 @@ getColMetaData(orc::StructVectorBatch *root, OrcFdwColInfo &col)
         case OrcPgTypeKind::DATE:
         {
             col.col_oid = DATEOID;
+            col.pack_kind = ORC_PACK_DATE;
             col.size = sizeof(int32_t);
             break;
         }
 
-        case OrcPgTypeKind::LIST_UNSUPPORTED:
-        case OrcPgTypeKind::MAP_UNSUPPORTED:
-        case OrcPgTypeKind::STRUCT_UNSUPPORTED:
+        /* Lists of simple types are arrays; other lists are jsonb */
+        case OrcPgTypeKind::LIST:
+        {
+            OrcFdwColInfo &elem = col.children[0];
+
+            col.col_oid = JSONBOID;
+
+            if (elem.kind != OrcPgTypeKind::LIST && elem.kind != OrcPgTypeKind::MAP && elem.kind != OrcPgTypeKind::STRUCT
+                && OidIsValid(get_array_type(elem.col_oid)))
+            {
+                col.col_oid = get_array_type(elem.col_oid);
+                get_typlenbyvalalign(elem.col_oid, &elem.typlen, &elem.typbyval, &elem.typalign);
+            }
+
+            break;
+        }
+        /* Structs are read as jsonb, or as a composite type that the
+         * table column is declared with; see setCompositeType */
+        case OrcPgTypeKind::MAP:
+        case OrcPgTypeKind::STRUCT:
+        {
+            col.col_oid = JSONBOID;
+            break;
+        }
+
         case OrcPgTypeKind::UNION_UNSUPPORTED:
         case OrcPgTypeKind::UNSUPPORTED_TYPE:
         default:
@@ -279,56 +458,127 @@ getColMetaData(orc::StructVectorBatch *root, OrcFdwColInfo &col)
 
 /*
  * setCastingFunc
- *    At the moment, all types are binary coercible so an explicit casting
- *    function is not required. However, we may need this later when add
- *    other more complex data types. Throws an error if no casting function
- *    is found.
+ *    Sets how values read from the ORC file are cast to the type of the
+ *    table column. Binary coercible types need no cast, common widenings
+ *    and date, timestamp and text conversions use a batch kernel, and
+ *    other casts allowed on assignment go through fmgr for each value.
+ *    Throws an error if there is no such cast.
  */
 static
 void
-setCastingFunc(OrcFdwColInfo &col, Oid targetOid)
+setCastingFunc(OrcFdwColInfo &col, Oid targetOid, const char *attname)
 {
+    Oid funcid = InvalidOid;
+    CoercionPathType c_path;
+    MemoryContext oldcxt;
+
+    col.cast_kind = ORC_CAST_NONE;
 
     /* Find a casting function; not required for binary coercible ones */
-    if (IsBinaryCoercible(col.col_oid, targetOid))
+    if (col.col_oid == InvalidOid || targetOid == InvalidOid
+        || IsBinaryCoercible(col.col_oid, targetOid))
     {
         return;
     }
 
-    /* If the target is valid, let's find casting function */
-    if (targetOid != InvalidOid)
+    col.is_binary_compatible = false;
+
+    /* Casts of whole column vectors */
+    col.cast_kind = orcGetCastKind(col.col_oid, targetOid);
+
+    if (col.cast_kind != ORC_CAST_NONE)
+        return;
+
+    c_path = find_coercion_pathway(targetOid, col.col_oid, COERCION_ASSIGNMENT, &funcid);
+    oldcxt = MemoryContextSwitchTo(CurTransactionContext);
+
+    switch (c_path)
+    {
+        /* Set the casting function */
+        case COERCION_PATH_FUNC:
+        {
+            col.cast_kind = ORC_CAST_FUNC;
+            col.cast_func = (FmgrInfo *) palloc0(sizeof(FmgrInfo));
+            fmgr_info(funcid, col.cast_func);
+            break;
+        }
+        /* No explicit casting required */
+        case COERCION_PATH_RELABELTYPE:
+        {
+            break;
+        }
+        /* Output the value as text and read it as the target type */
+        case COERCION_PATH_COERCEVIAIO:
+        {
+            Oid outfunc;
+            Oid infunc;
+            bool isvarlena;
+
+            getTypeOutputInfo(col.col_oid, &outfunc, &isvarlena);
+            getTypeInputInfo(targetOid, &infunc, &col.cast_ioparam);
+
+            col.cast_kind = ORC_CAST_IO;
+            col.cast_func = (FmgrInfo *) palloc0(sizeof(FmgrInfo));
+            col.cast_in_func = (FmgrInfo *) palloc0(sizeof(FmgrInfo));
+            fmgr_info(outfunc, col.cast_func);
+            fmgr_info(infunc, col.cast_in_func);
+            break;
+        }
+        /* No casting function found; let's throw an error */
+        case COERCION_PATH_ARRAYCOERCE:
+        case COERCION_PATH_NONE:
+        default:
+        {
+            ereport(ERROR, (errmsg("%s: Unable to read data for column %s with data type mismatch against ORC file.", ORC_FDW_NAME, attname)));
+            break;
+        }
+    }
+
+    MemoryContextSwitchTo(oldcxt);
+}
+
+/*
+ * setCompositeType
+ *    Reads a STRUCT column as the composite type of the table column.
+ *    Fields map to attributes of the same name, ignoring case as for
+ *    table columns; attributes without a field are NULL. Nested structs
+ *    may be composite types as well.
+ */
+static
+void
+setCompositeType(OrcFdwColInfo &col, Oid typid)
+{
+    MemoryContext oldcxt = MemoryContextSwitchTo(CurTransactionContext);
+
+    col.tupdesc = lookup_rowtype_tupdesc_copy(typid, -1);
+    MemoryContextSwitchTo(oldcxt);
+
+    col.col_oid = typid;
+    col.field_index.assign(col.tupdesc->natts, -1);
+
+    for (int attnum = 0; attnum < col.tupdesc->natts; attnum++)
     {
-        Oid funcid = InvalidOid;
-        CoercionPathType c_path = find_coercion_pathway(targetOid, col.col_oid, COERCION_EXPLICIT, &funcid);
+        Form_pg_attribute attr = TupleDescAttr(col.tupdesc, attnum);
+        std::string attname;
+
+        if (attr->attisdropped)
+            continue;
 
-        switch (c_path)
+        attname = orcFoldColumnName(NameStr(attr->attname));
+
+        for (uint i = 0; i < col.children.size(); i++)
         {
-            /* Set the casting function */
-            case COERCION_PATH_FUNC:
-            {
-                MemoryContext oldcxt = MemoryContextSwitchTo(CurTransactionContext);
-                col.cast_func = (FmgrInfo *) palloc0(sizeof(FmgrInfo));
-                fmgr_info(funcid, col.cast_func);
-                MemoryContextSwitchTo(oldcxt);
-                break;
-            }
-            /* No explicit casting required */
-            case COERCION_PATH_RELABELTYPE:
-            {
-                break;
-            }
-            case COERCION_PATH_COERCEVIAIO:
-            {
-                break;
-            }
-            /* No casting function found; let's throw an error */
-            case COERCION_PATH_ARRAYCOERCE:
-            case COERCION_PATH_NONE:
-            default:
-            {
-                ereport(ERROR, (errmsg("%s: No casting function from %d oid to %d oid.", ORC_FDW_NAME, col.col_oid, targetOid)));
-                break;
-            }
+            OrcFdwColInfo &field = col.children[i];
+
+            if (orcFoldColumnName(field.name.c_str()) != attname)
+                continue;
+
+            if (field.kind == OrcPgTypeKind::STRUCT && type_is_rowtype(attr->atttypid))
+                setCompositeType(field, attr->atttypid);
+
+            checkTypeMatch(field.col_oid, attr->atttypid, NameStr(attr->attname));
+            col.field_index[attnum] = i;
+            break;
         }
     }
 }
@@ -456,10 +706,18 @@ bool getTableOptions(List *options_list, OrcFdwPlanState *fdw_state)
                 hasFilename = true;
             }
         }
-        else
+        else if (strcmp(def->defname, "rescan_cache") == 0)
         {
-            /* Currently, we only support filename as an option. So throw
-             * an error otherwise */
+            /* Validates the value as well */
+            bool rescan_cache = defGetBoolean(def);
+
+            if (fdw_state != NULL)
+                fdw_state->rescan_cache = rescan_cache;
+        }
+        else if (!orcParseWriteOption(def, (fdw_state != NULL) ? &fdw_state->write_options : NULL))
+        {
+            /* Other than filename, rescan_cache and writer options, no
+             * options are supported. So throw an error otherwise */
             ereport(ERROR,
                     (errcode(ERRCODE_FDW_INVALID_OPTION_NAME),
                      errmsg("%s: invalid option specified \"%s\"",
@@ -478,9 +736,10 @@ bool getTableOptions(List *options_list, OrcFdwPlanState *fdw_state)
  */
 static
 bool
-getColumnNameList(RelOptInfo *baserel, OrcFdwPlanState *fdw_state, List *tlist)
+getColumnNameList(PlannerInfo *root, RelOptInfo *baserel, OrcFdwPlanState *fdw_state, List *tlist)
 {
     List *cols_name_reqd = NIL;
+    List *cols_paths_reqd = NIL;
     List *cols_oid_reqd = NIL;
     List *cols_index_reqd = NIL;
     ListCell *lc;
@@ -488,20 +747,32 @@ getColumnNameList(RelOptInfo *baserel, OrcFdwPlanState *fdw_state, List *tlist)
     TupleDesc tupleDesc;
     AttrNumber attnum;
     Bitmapset *attrs_used = NULL;
+    OrcFdwFieldSelectContext context;
     bool has_wholerow = false;
     int numattrs = 0;
     int i;
 
+    context.relid = baserel->relid;
+    context.sublevels_up = 0;
+    context.whole_attrs = NULL;
+    context.field_attrs = NIL;
+    context.field_paths = NIL;
+
     /* Get all attributes needed for joins or final output */
     pull_varattnos((Node *) baserel->reltarget->exprs, baserel->relid,
                     &attrs_used);
 
+    /* The target only lists columns, so look for field selection in the
+     * query itself */
+    (void) query_tree_walker(root->parse, (bool (*)()) getFieldSelects, (void *) &context, 0);
+
     /* Pull in all attributes used in restriction clauses */
     foreach(lc, baserel->baserestrictinfo)
     {
         RestrictInfo *ri = (RestrictInfo *) lfirst(lc);
         pull_varattnos((Node *) ri->clause, baserel->relid,
                         &attrs_used);
+        (void) getFieldSelects((Node *) ri->clause, &context);
     }
 
     /* Let's convert attribute numbers to column names */
@@ -536,6 +807,7 @@ getColumnNameList(RelOptInfo *baserel, OrcFdwPlanState *fdw_state, List *tlist)
             /* Add to columns list */
             attname = pstrdup(NameStr(attr->attname));
             cols_name_reqd = lappend(cols_name_reqd, makeString(attname));
+            cols_paths_reqd = lappend(cols_paths_reqd, getFieldPaths(&context, attnum));
         }
     }
 
@@ -549,27 +821,31 @@ getColumnNameList(RelOptInfo *baserel, OrcFdwPlanState *fdw_state, List *tlist)
     table_close(rel, AccessShareLock);
 
     /* Handling of whole row; nothing to filter column names */
-    if (has_wholerow || numattrs == list_length(cols_name_reqd))
+    if (has_wholerow)
+    {
+        return false;
+    }
+
+    /* Say, count(*) or EXISTS; rows are made without reading columns */
+    fdw_state->zero_columns = (cols_name_reqd == NIL);
+
+    /* Struct columns used only through some of their fields are read
+     * down to those fields */
+    fdw_state->col_orc_type_ids = getSelectedTypeIds(fdw_state, cols_name_reqd, cols_paths_reqd);
+
+    if (numattrs == list_length(cols_name_reqd))
     {
         return false;
     }
 
     foreach(lc, cols_name_reqd)
     {
-        ListCell *lc_name;
-        ListCell *lc_oid;
-        ListCell *lc_index;
+        const OrcFdwColInfo *col = orcFindFileColumn(fdw_state, strVal(lfirst(lc)));
 
-        forthree(lc_name, fdw_state->col_orc_name,
-            lc_oid, fdw_state->col_orc_oid,
-            lc_index, fdw_state->col_orc_file_index)
+        if (col != NULL)
         {
-
-            if (pg_strcasecmp(strVal(lfirst(lc)), strVal(lfirst(lc_name))) == 0)
-            {
-                cols_oid_reqd = lappend_int(cols_oid_reqd, lfirst_oid(lc_oid));
-                cols_index_reqd = lappend_int(cols_index_reqd, lfirst_int(lc_index));
-            }
+            cols_oid_reqd = lappend_int(cols_oid_reqd, col->col_oid);
+            cols_index_reqd = lappend_int(cols_index_reqd, col->index);
         }
     }
 
@@ -584,6 +860,226 @@ getColumnNameList(RelOptInfo *baserel, OrcFdwPlanState *fdw_state, List *tlist)
     return true;
 }
 
+/*
+ * getFieldSelects
+ *    Collects the field paths selected from columns of the scanned
+ *    relation, and the columns used other than through a field. Columns
+ *    not seen here, say of a child relation, are read whole.
+ */
+static
+bool
+getFieldSelects(Node *node, OrcFdwFieldSelectContext *context)
+{
+    if (node == NULL)
+        return false;
+
+    if (IsA(node, FieldSelect))
+    {
+        Node *arg = node;
+        List *path = NIL;
+
+        /* Walk down nested field selections to the column */
+        while (IsA(arg, FieldSelect))
+        {
+            FieldSelect *fselect = (FieldSelect *) arg;
+            Node *rowarg = (Node *) fselect->arg;
+            TupleDesc tupdesc;
+
+            tupdesc = lookup_rowtype_tupdesc_domain(exprType(rowarg), exprTypmod(rowarg), false);
+            path = lcons(makeString(pstrdup(NameStr(TupleDescAttr(tupdesc, fselect->fieldnum - 1)->attname))), path);
+            ReleaseTupleDesc(tupdesc);
+
+            arg = rowarg;
+        }
+
+        if (IsA(arg, Var))
+        {
+            Var *var = (Var *) arg;
+
+            if (var->varno == context->relid && (int) var->varlevelsup == context->sublevels_up && var->varattno > 0)
+            {
+                context->field_attrs = lappend_int(context->field_attrs, var->varattno);
+                context->field_paths = lappend(context->field_paths, path);
+                return false;
+            }
+        }
+
+        list_free_deep(path);
+    }
+    else if (IsA(node, Var))
+    {
+        Var *var = (Var *) node;
+
+        if (var->varno == context->relid && (int) var->varlevelsup == context->sublevels_up && var->varattno > 0)
+            context->whole_attrs = bms_add_member(context->whole_attrs, var->varattno);
+
+        return false;
+    }
+    else if (IsA(node, Query))
+    {
+        bool result;
+
+        /* Columns may be referenced from sublinks and lateral items */
+        context->sublevels_up++;
+        result = query_tree_walker((Query *) node, (bool (*)()) getFieldSelects, (void *) context, 0);
+        context->sublevels_up--;
+
+        return result;
+    }
+
+    return expression_tree_walker(node, (bool (*)()) getFieldSelects, (void *) context);
+}
+
+/*
+ * getFieldPaths
+ *    Returns the field paths selected from a column, or NIL if the whole
+ *    column is needed.
+ */
+static
+List *
+getFieldPaths(OrcFdwFieldSelectContext *context, AttrNumber attnum)
+{
+    List *paths = NIL;
+    ListCell *lc_attr;
+    ListCell *lc_path;
+
+    if (bms_is_member(attnum, context->whole_attrs))
+        return NIL;
+
+    forboth(lc_attr, context->field_attrs, lc_path, context->field_paths)
+    {
+        if (lfirst_int(lc_attr) == attnum)
+            paths = lappend(paths, lfirst(lc_path));
+    }
+
+    return paths;
+}
+
+/*
+ * getSelectedTypeIds
+ *    Returns the ORC column ids of the required columns, with only the
+ *    selected fields of struct columns used through field selection.
+ *    Returns NIL if all required columns are read whole.
+ */
+static
+List *
+getSelectedTypeIds(OrcFdwPlanState *fdw_state, List *cols_name_reqd, List *cols_paths_reqd)
+{
+    List *type_ids = NIL;
+    bool has_fields = false;
+    ListCell *lc;
+    ListCell *lc_paths;
+
+    forboth(lc, cols_name_reqd, lc_paths, cols_paths_reqd)
+    {
+        List *paths = (List *) lfirst(lc_paths);
+        const OrcFdwColInfo *col = orcFindFileColumn(fdw_state, strVal(lfirst(lc)));
+        List *fields;
+        ListCell *lc_path;
+
+        if (col == NULL)
+            continue;
+
+        fields = (paths != NIL) ? getStructFieldList(*col) : NIL;
+
+        if (paths == NIL || fields == NIL)
+        {
+            type_ids = lappend_int(type_ids, (int) col->col_id);
+            continue;
+        }
+
+        /* Fields missing from the file are NULL; nothing to read */
+        foreach(lc_path, paths)
+        {
+            int type_id = getFieldTypeId(fields, (List *) lfirst(lc_path));
+
+            if (type_id >= 0)
+                type_ids = list_append_unique_int(type_ids, type_id);
+        }
+
+        has_fields = true;
+    }
+
+    if (!has_fields)
+    {
+        list_free(type_ids);
+        return NIL;
+    }
+
+    return type_ids;
+}
+
+/*
+ * getFieldTypeId
+ *    Returns the ORC column id of a field path in a struct, or -1 if the
+ *    struct has no such field. Names are matched ignoring case, as in
+ *    setCompositeType.
+ */
+static
+int
+getFieldTypeId(List *fields, List *path)
+{
+    int type_id = -1;
+    int depth = 0;
+    ListCell *lc_path;
+
+    foreach(lc_path, path)
+    {
+        const char *name = strVal(lfirst(lc_path));
+        List *subfields = NIL;
+        ListCell *lc;
+
+        type_id = -1;
+
+        foreach(lc, fields)
+        {
+            List *field = (List *) lfirst(lc);
+
+            if (pg_strcasecmp(strVal(linitial(field)), name) == 0)
+            {
+                type_id = intVal(lsecond(field));
+                subfields = (List *) lthird(field);
+                break;
+            }
+        }
+
+        if (type_id < 0)
+            return -1;
+
+        /* Selecting into a field that isn't a struct reads it whole */
+        if (++depth < list_length(path) && subfields == NIL)
+            return type_id;
+
+        fields = subfields;
+    }
+
+    return type_id;
+}
+
+/*
+ * getStructFieldList
+ *    Returns the fields of a STRUCT column as (field name, column id,
+ *    fields) lists, or NIL for other columns.
+ */
+static
+List *
+getStructFieldList(const OrcFdwColInfo &col)
+{
+    List *fields = NIL;
+
+    if (col.kind != OrcPgTypeKind::STRUCT)
+        return NIL;
+
+    for (auto field = col.children.begin(); field != col.children.end(); field++)
+    {
+        fields = lappend(fields, list_make3(makeString(pstrdup((*field).name.c_str())),
+                                            makeInteger((int) (*field).col_id),
+                                            getStructFieldList(*field)));
+    }
+
+    return fields;
+}
+
 /*
  * orcInitExecState
  *    Initializes executation state with table details and ORC FDW
@@ -591,12 +1087,15 @@ getColumnNameList(RelOptInfo *baserel, OrcFdwPlanState *fdw_state, List *tlist)
  */
 static
 OrcFdwExecState *
-orcInitExecState(OrcFdwExecState **fdw_estate, char *filename, List *col_orc_file_index, RangeTblEntry *rte, List *fdw_scan_tlist, bool blnShouldSetRowReader)
+orcInitExecState(OrcFdwExecState **fdw_estate, char *filename, List *col_orc_file_index, List *col_orc_type_ids, List *attr_names, List *attr_types, bool blnShouldSetRowReader, OrcFdwZeroColumns zero_columns)
 {
     int attnum = 0;
     uint i;
     ListCell *lc;
+    ListCell *lc_type;
     std::list<uint64_t> orc_cols;
+    std::list<uint64_t> orc_type_ids;
+    bool pool_hit;
 
     *fdw_estate = new OrcFdwExecState;
 
@@ -606,7 +1105,16 @@ orcInitExecState(OrcFdwExecState **fdw_estate, char *filename, List *col_orc_fil
     (*fdw_estate)->curr_batch_total_rows = -1;
     (*fdw_estate)->curr_batch_number = 0;
     (*fdw_estate)->curr_batch_row_num = 0;
+    (*fdw_estate)->curr_batch_sel_pos = 0;
+    (*fdw_estate)->curr_batch_has_sel = false;
     (*fdw_estate)->row_num = 0;
+    (*fdw_estate)->pushdown = NIL;
+    (*fdw_estate)->pushdown_exprs = NIL;
+    (*fdw_estate)->pushdown_pending = false;
+    (*fdw_estate)->zero_columns = zero_columns;
+    (*fdw_estate)->batch_cxt = AllocSetContextCreate(CurrentMemoryContext,
+                                                     "orc_fdw batch values",
+                                                     ALLOCSET_DEFAULT_SIZES);
 
     /* Fill the list with required ORC column indexes */
     foreach(lc, col_orc_file_index)
@@ -614,71 +1122,116 @@ orcInitExecState(OrcFdwExecState **fdw_estate, char *filename, List *col_orc_fil
         orc_cols.push_back(lfirst_int(lc));
     }
 
-    /* Include the list in the row reader */
-    if (orc_cols.size() > 0 && blnShouldSetRowReader)
+    foreach(lc, col_orc_type_ids)
+    {
+        orc_type_ids.push_back(lfirst_int(lc));
+    }
+
+    /* Include the list in the row reader; with struct fields selected,
+     * only their streams are read and the parents come along. Scans of
+     * zero columns include none; their row reader is never read. */
+    if (zero_columns != ORC_ZERO_COLUMNS_NONE)
+    {
+        (*fdw_estate)->rowReaderOptions.include(orc_cols);
+    }
+    else if (orc_type_ids.size() > 0 && blnShouldSetRowReader)
+    {
+        (*fdw_estate)->rowReaderOptions.includeTypes(orc_type_ids);
+    }
+    else if (orc_cols.size() > 0 && blnShouldSetRowReader)
     {
         (*fdw_estate)->rowReaderOptions.include(orc_cols);
     }
 
-    (*fdw_estate)->is_valid_reader = orcCreateReader((*fdw_estate)->filename, &((*fdw_estate)->reader), (*fdw_estate)->options, false);
-    (void) orcCreateRowReader(&((*fdw_estate)->reader), &((*fdw_estate)->rowReader), (*fdw_estate)->rowReaderOptions);
+    /* Take the file's reader from the pool; usually the planner's */
+    (*fdw_estate)->pooled_reader = orcReaderPoolCheckout((*fdw_estate)->filename, &((*fdw_estate)->stats), &pool_hit);
+    (*fdw_estate)->reader = &((*fdw_estate)->pooled_reader->reader);
+    (*fdw_estate)->rowReader = &((*fdw_estate)->pooled_reader->row_reader);
+    (*fdw_estate)->batch = &((*fdw_estate)->pooled_reader->batch);
+    (*fdw_estate)->is_valid_reader = true;
+
+    if (pool_hit)
+        (*fdw_estate)->stats.reader_pool_hits++;
+
+    /* Count memory, decompression and row groups for EXPLAIN ANALYZE */
+    (*fdw_estate)->memory_pool = &((*fdw_estate)->pooled_reader->memory_pool);
+    (*fdw_estate)->metrics = &((*fdw_estate)->pooled_reader->metrics);
+
+    (void) orcCreateRowReader((*fdw_estate)->reader, (*fdw_estate)->rowReader, (*fdw_estate)->rowReaderOptions);
+
+    orcScanStatsSetStripes((*fdw_estate)->stats, (*fdw_estate)->reader);
 
-	(*fdw_estate)->batch = ((*fdw_estate)->rowReader)->createRowBatch((*fdw_estate)->batchsize);
-    (*fdw_estate)->batch_data = dynamic_cast<orc::StructVectorBatch *>((*fdw_estate)->batch.get());
+	*(*fdw_estate)->batch = (*(*fdw_estate)->rowReader)->createRowBatch((*fdw_estate)->batchsize);
+    (*fdw_estate)->batch_data = dynamic_cast<orc::StructVectorBatch *>((*fdw_estate)->batch->get());
 
     /* index, column name, internal type, Oid, column size */
-    (*fdw_estate)->cols_info = getMappedColsFromReader(&((*fdw_estate)->reader), &((*fdw_estate)->rowReader), (*fdw_estate)->batch_data);
+    (*fdw_estate)->cols_info = getMappedColsFromReader((*fdw_estate)->reader, (*fdw_estate)->rowReader, (*fdw_estate)->batch_data);
 
     /* Resize the column position list to match tuple */
-    (*fdw_estate)->attr_orc_index.resize(list_length(fdw_scan_tlist));
+    (*fdw_estate)->attr_orc_index.resize(list_length(attr_names));
 
-    /* Store indexes of matching columns in ORC file */
-    foreach(lc, fdw_scan_tlist)
+    /* Names and types were resolved by the planner; match the names to
+     * ORC columns through an index of the columns read, ignoring case as
+     * the planner does. The file's index numbers all of its columns. */
+    if (attr_names != NIL)
     {
-        TargetEntry *tle = lfirst_node(TargetEntry, lc);
-        Var *var = (Var *) tle->expr;
+        std::unordered_map<std::string, int> col_positions;
 
-        Assert(IsA(var, Var));
+        for (i = 0; i < (*fdw_estate)->cols_info.size(); i++)
+            col_positions.emplace(orcFoldColumnName((*fdw_estate)->cols_info[i].name.c_str()), i);
 
-        char *attname = get_attname(rte->relid, var->varattno, false);
-        Oid targetOid = get_atttype(rte->relid, var->varattno);
+        /* Store indexes of matching columns in ORC file */
+        forboth(lc, attr_names, lc_type, attr_types)
+        {
+            char *attname = strVal(lfirst(lc));
+            Oid targetOid = lfirst_oid(lc_type);
+            auto col_position = col_positions.find(orcFoldColumnName(attname));
 
-        /* Let's assume that we will not able to find the column */
-        (*fdw_estate)->attr_orc_index[attnum] = -1;
+            /* Let's assume that we will not able to find the column */
+            (*fdw_estate)->attr_orc_index[attnum] = -1;
 
-        for (i = 0; i < (*fdw_estate)->cols_info.size(); i++)
-        {
-            /* FIXME: Do we need a case insensitive comparison? */
-            if ((*fdw_estate)->cols_info[i].name.compare(attname) == 0)
+            if (col_position != col_positions.end())
             {
-                checkTypeMatch((*fdw_estate)->cols_info[i].col_oid, targetOid, attname);
+                i = col_position->second;
+
+                if ((*fdw_estate)->cols_info[i].kind == OrcPgTypeKind::STRUCT && type_is_rowtype(targetOid))
+                    setCompositeType((*fdw_estate)->cols_info[i], targetOid);
 
                 (*fdw_estate)->attr_orc_index[attnum] = i;
-                setCastingFunc((*fdw_estate)->cols_info[i], targetOid);
+                setCastingFunc((*fdw_estate)->cols_info[i], targetOid, attname);
             }
-        }
 
-        /* Increase the attribute counter */
-        attnum++;
+            /* Increase the attribute counter */
+            attnum++;
+        }
     }
 
     /* No columns found, so let's set to entire row */
     if ((*fdw_estate)->attr_orc_index.size() == 0)
     {
+        std::vector<Oid> rel_types;
+
+        foreach(lc_type, attr_types)
+            rel_types.push_back(lfirst_oid(lc_type));
+
         (*fdw_estate)->attr_orc_index.resize((*fdw_estate)->cols_info.size());
 
-        /* Set the column positions to default */
+        /* Set the column positions to default; attributes are read from
+         * the file columns in order */
         for (i = 0; i < (*fdw_estate)->attr_orc_index.size(); i++)
         {
+            Oid targetOid = (i < rel_types.size()) ? rel_types[i] : InvalidOid;
+
             (*fdw_estate)->attr_orc_index[i] = i;
+            setCastingFunc((*fdw_estate)->cols_info[i], targetOid, (*fdw_estate)->cols_info[i].name.c_str());
         }
     }
 
     /* Set total number of rows in exec state */
-    (*fdw_estate)->total_rows = orcGetNumberOfRows(&((*fdw_estate)->reader));
+    (*fdw_estate)->total_rows = orcGetNumberOfRows((*fdw_estate)->reader);
 
     /* Set numeric defaults */
-    (*fdw_estate)->default_numeric_scale = orcGetDefaultDecimalScale(&((*fdw_estate)->reader));
+    (*fdw_estate)->default_numeric_scale = orcGetDefaultDecimalScale((*fdw_estate)->reader);
 
     return *fdw_estate;
 }
@@ -704,67 +1257,166 @@ checkTypeMatch(Oid srcOid, Oid targetOid, const char *attname)
 /*
  * getDatumForData
  *    Get data for a given column and row from the ORC file, store it in a
- *    Datum based on column's OID, and return it.
+ *    Datum of the table column's type, and return it. Columns with a batch
+ *    kernel are staged for the whole batch the first time a row of the
+ *    batch is read.
  */
 static
 Datum
-getDatumForData(OrcFdwExecState *fdw_estate, int row_in_batch, int col_index, Oid targetOid)
+getDatumForData(OrcFdwExecState *fdw_estate, int row_in_batch, int col_index, bool *isnull)
 {
-    Datum d = (Datum) NULL;
-    int orc_index = col_index;
-    bool is_var_length = false;
+    OrcFdwColInfo &col = fdw_estate->cols_info[col_index];
+    orc::ColumnVectorBatch *field = fdw_estate->batch_data->fields[col.index];
 
-    checkTypeMatch(fdw_estate->cols_info[col_index].col_oid, targetOid, fdw_estate->cols_info[col_index].name.c_str());
+    if (isStagedColumn(col))
+    {
+        if (!col.batch_staged)
+            stageColumn(fdw_estate, col, field);
+
+        *isnull = (col.batch_has_nulls && col.batch_isnull[row_in_batch]);
+        return col.batch_values[row_in_batch];
+    }
 
-    switch(fdw_estate->cols_info[col_index].col_oid)
+    /* No NULL checks when the file or the batch has no NULLs */
+    if (col.hasNull && field->hasNulls && !field->notNull[row_in_batch])
     {
-        case BOOLOID:
-        {
-            d = BoolGetDatum((dynamic_cast<orc::LongVectorBatch *>(fdw_estate->batch_data->fields[orc_index]))->data[row_in_batch]);
-            break;
-        }
-        case INT2OID:
+        *isnull = true;
+        return (Datum) 0;
+    }
+
+    *isnull = false;
+
+    switch (col.cast_kind)
+    {
+        case ORC_CAST_FUNC:
+            return FunctionCall1(col.cast_func, getColumnDatum(fdw_estate, col, field, row_in_batch));
+
+        case ORC_CAST_IO:
+        {
+            char *str = OutputFunctionCall(col.cast_func, getColumnDatum(fdw_estate, col, field, row_in_batch));
+
+            return InputFunctionCall(col.cast_in_func, str, col.cast_ioparam, -1);
+        }
+
+        default:
+            return getColumnDatum(fdw_estate, col, field, row_in_batch);
+    }
+}
+
+/*
+ * isStagedColumn
+ *    Returns true if the column is packed or cast by a batch kernel.
+ */
+static inline
+bool
+isStagedColumn(const OrcFdwColInfo &col)
+{
+    if (col.cast_kind == ORC_CAST_NONE)
+        return (col.pack_kind != ORC_PACK_NONE);
+
+    return (col.cast_kind != ORC_CAST_FUNC && col.cast_kind != ORC_CAST_IO);
+}
+
+/*
+ * stageColumn
+ *    Fills the values and NULL flags of a column for the whole batch.
+ */
+static
+void
+stageColumn(OrcFdwExecState *fdw_estate, OrcFdwColInfo &col, orc::ColumnVectorBatch *field)
+{
+    uint64_t rows = field->numElements;
+    MemoryContext oldcxt;
+
+    col.batch_values.resize(rows);
+    col.batch_isnull.resize(rows);
+
+    /* NULL flags are only expanded when the batch has NULLs */
+    col.batch_has_nulls = (col.hasNull && field->hasNulls);
+
+    if (col.batch_has_nulls)
+        orcExpandNulls(field->notNull.data(), rows, col.batch_isnull.data());
+
+    /* Values that aren't passed by value last until the next batch */
+    oldcxt = MemoryContextSwitchTo(fdw_estate->batch_cxt);
+
+    if (col.cast_kind == ORC_CAST_NONE)
+        orcPackDatums(col.pack_kind, field, rows, col.batch_values.data());
+    else
+        orcCastColumn(col.cast_kind, field, rows, col.batch_values.data());
+
+    MemoryContextSwitchTo(oldcxt);
+    col.batch_staged = true;
+}
+
+/*
+ * getColumnDatum
+ *    Returns the value of a row of a column vector, which may be nested
+ *    in another column, as a Datum of the column's type.
+ */
+static
+Datum
+getColumnDatum(OrcFdwExecState *fdw_estate, const OrcFdwColInfo &col, orc::ColumnVectorBatch *field, int64_t row)
+{
+    Datum d = (Datum) NULL;
+    bool is_var_length = false;
+
+    /* Arrays and composites; other nested types are jsonb */
+    if (col.kind == OrcPgTypeKind::LIST && col.col_oid != JSONBOID)
+        return getArrayDatum(fdw_estate, col, field, row);
+
+    if (col.kind == OrcPgTypeKind::STRUCT && col.tupdesc != NULL)
+        return getCompositeDatum(fdw_estate, col, field, row);
+
+    switch(col.col_oid)
+    {
+        case BOOLOID:
+        {
+            d = BoolGetDatum((dynamic_cast<orc::LongVectorBatch *>(field))->data[row]);
+            break;
+        }
+        case INT2OID:
         {
-            d = Int16GetDatum((dynamic_cast<orc::LongVectorBatch *>(fdw_estate->batch_data->fields[orc_index]))->data[row_in_batch]);
+            d = Int16GetDatum((dynamic_cast<orc::LongVectorBatch *>(field))->data[row]);
             break;
         }
         case INT4OID:
         {
-            d = Int32GetDatum((dynamic_cast<orc::LongVectorBatch *>(fdw_estate->batch_data->fields[orc_index]))->data[row_in_batch]);
+            d = Int32GetDatum((dynamic_cast<orc::LongVectorBatch *>(field))->data[row]);
             break;
         }
         case INT8OID:
         {
-            d = Int8GetDatum((dynamic_cast<orc::LongVectorBatch *>(fdw_estate->batch_data->fields[orc_index]))->data[row_in_batch]);
+            d = Int8GetDatum((dynamic_cast<orc::LongVectorBatch *>(field))->data[row]);
             break;
         }
         case FLOAT4OID:
         {
-            d = Float4GetDatum((dynamic_cast<orc::DoubleVectorBatch *>(fdw_estate->batch_data->fields[orc_index]))->data[row_in_batch]);
+            d = Float4GetDatum((dynamic_cast<orc::DoubleVectorBatch *>(field))->data[row]);
             break;
         }
         case FLOAT8OID:
         {
-            d = Float8GetDatum((dynamic_cast<orc::DoubleVectorBatch *>(fdw_estate->batch_data->fields[orc_index]))->data[row_in_batch]);
+            d = Float8GetDatum((dynamic_cast<orc::DoubleVectorBatch *>(field))->data[row]);
             break;
         }
         /* FIXME: Cross type; currently this case is unreachable */
         case NUMERICOID:
         {
             std::string nvalue;
-            int precision = fdw_estate->cols_info[col_index].precision;
-            int scale = fdw_estate->cols_info[col_index].scale;
+            int precision = col.precision;
+            int scale = col.scale;
 
             /* Decimal64VectorBatch */
-            if (precision == 0 || precision < 18)
+            if (precision == 0 || precision <= 18)
             {
-                int64_t val = (static_cast<orc::Decimal64VectorBatch *>(fdw_estate->batch_data->fields[orc_index]))->values[row_in_batch];
+                int64_t val = (static_cast<orc::Decimal64VectorBatch *>(field))->values[row];
                 nvalue = std::to_string(val);
             }
             /* Decimal128VectorBatch */
             else
             {
-                nvalue = ((orc::Int128)((dynamic_cast<orc::Decimal64VectorBatch *>(fdw_estate->batch_data->fields[orc_index]))->values[row_in_batch])).toString();
+                nvalue = (static_cast<orc::Decimal128VectorBatch *>(field))->values[row].toString();
             }
 
             /* Let's format the numeric data */
@@ -784,7 +1436,14 @@ getDatumForData(OrcFdwExecState *fdw_estate, int row_in_batch, int col_index, Oi
             /* Don't set typmod if we don't have precision and scale data */
             if (scale > 0 && precision > 0)
             {
-                nvalue.insert(precision - scale, ".");
+                /* The point goes before the last scale digits; values
+                 * below 1 are padded with zeros */
+                size_t sign = (nvalue[0] == '-');
+
+                if (nvalue.length() - sign <= (size_t) scale)
+                    nvalue.insert(sign, scale - (nvalue.length() - sign) + 1, '0');
+
+                nvalue.insert(nvalue.length() - scale, ".");
             }
             else
             {
@@ -796,8 +1455,8 @@ getDatumForData(OrcFdwExecState *fdw_estate, int row_in_batch, int col_index, Oi
         }
         case TIMESTAMPOID:
         {
-            int64_t secs = (dynamic_cast<orc::TimestampVectorBatch *>(fdw_estate->batch_data->fields[orc_index]))->data[row_in_batch];
-            int64_t nano = (dynamic_cast<orc::TimestampVectorBatch *>(fdw_estate->batch_data->fields[orc_index]))->nanoseconds[row_in_batch];
+            int64_t secs = (dynamic_cast<orc::TimestampVectorBatch *>(field))->data[row];
+            int64_t nano = (dynamic_cast<orc::TimestampVectorBatch *>(field))->nanoseconds[row];
 
             /* Convert nano to micro and then divide */
             double val = (double) secs + ((double)(nano / 1000L) / USECS_PER_SEC);
@@ -807,7 +1466,16 @@ getDatumForData(OrcFdwExecState *fdw_estate, int row_in_batch, int col_index, Oi
         }
         case DATEOID:
         {
-            d = DateADTGetDatum((dynamic_cast<orc::LongVectorBatch *>(fdw_estate->batch_data->fields[orc_index]))->data[row_in_batch] + (UNIX_EPOCH_JDATE - POSTGRES_EPOCH_JDATE));
+            d = DateADTGetDatum((dynamic_cast<orc::LongVectorBatch *>(field))->data[row] + (UNIX_EPOCH_JDATE - POSTGRES_EPOCH_JDATE));
+            break;
+        }
+        /* Nested types other than arrays and composites */
+        case JSONBOID:
+        {
+            JsonbParseState *state = NULL;
+            JsonbValue *value = pushJsonbColumn(fdw_estate, &state, col, field, row, WJB_VALUE);
+
+            d = JsonbPGetDatum(JsonbValueToJsonb(value));
             break;
         }
         /* Variable lengths are handled later in this function */
@@ -822,7 +1490,7 @@ getDatumForData(OrcFdwExecState *fdw_estate, int row_in_batch, int col_index, Oi
         default:
         {
             /* We should never get to this default, but just in case. */
-            ereport(ERROR, (errmsg("%s: unsupported column data type for column %s", ORC_FDW_NAME, fdw_estate->cols_info[orc_index].name.c_str())));
+            ereport(ERROR, (errmsg("%s: unsupported column data type for column %s", ORC_FDW_NAME, col.name.c_str())));
             break;
         }
     }
@@ -830,10 +1498,10 @@ getDatumForData(OrcFdwExecState *fdw_estate, int row_in_batch, int col_index, Oi
     /* Let's handle all variable length data here */
     if (is_var_length)
     {
-        orc::StringVectorBatch *s = dynamic_cast<orc::StringVectorBatch *>(fdw_estate->batch_data->fields[orc_index]);
-        int64_t orc_data_len = s->length[row_in_batch];
+        orc::StringVectorBatch *s = dynamic_cast<orc::StringVectorBatch *>(field);
+        int64_t orc_data_len = s->length[row];
         int64_t var_len = VARHDRSZ + orc_data_len;
-        char *orc_data = (char *)s->data[row_in_batch];
+        char *orc_data = (char *)s->data[row];
 
         bytea *data = (bytea *) palloc(var_len);
         SET_VARSIZE(data, var_len);
@@ -845,6 +1513,292 @@ getDatumForData(OrcFdwExecState *fdw_estate, int row_in_batch, int col_index, Oi
     return d;
 }
 
+/*
+ * getArrayDatum
+ *    Returns a row of a LIST column as an array; elements are the range of
+ *    the child vector between the offsets of the row.
+ */
+static
+Datum
+getArrayDatum(OrcFdwExecState *fdw_estate, const OrcFdwColInfo &col, orc::ColumnVectorBatch *field, int64_t row)
+{
+    orc::ListVectorBatch *list = static_cast<orc::ListVectorBatch *>(field);
+    orc::ColumnVectorBatch *elements = list->elements.get();
+    const OrcFdwColInfo &elem = col.children[0];
+    int64_t start = list->offsets[row];
+    int nitems = (int) (list->offsets[row + 1] - start);
+    Datum *values;
+    bool *nulls;
+    int dims[1];
+    int lbs[1];
+
+    if (nitems == 0)
+        return PointerGetDatum(construct_empty_array(elem.col_oid));
+
+    values = (Datum *) palloc(nitems * sizeof(Datum));
+    nulls = (bool *) palloc(nitems * sizeof(bool));
+
+    /* Elements of simple types are packed over the range at once */
+    if (elem.pack_kind != ORC_PACK_NONE)
+    {
+        orcPackDatumRange(elem.pack_kind, elements, start, nitems, values);
+
+        if (elements->hasNulls)
+            orcExpandNulls(elements->notNull.data() + start, nitems, (char *) nulls);
+        else
+            memset(nulls, 0, nitems * sizeof(bool));
+    }
+    else
+    {
+        for (int i = 0; i < nitems; i++)
+        {
+            nulls[i] = (elements->hasNulls && !elements->notNull[start + i]);
+            values[i] = nulls[i] ? (Datum) 0 : getColumnDatum(fdw_estate, elem, elements, start + i);
+        }
+    }
+
+    dims[0] = nitems;
+    lbs[0] = 1;
+
+    return PointerGetDatum(construct_md_array(values, nulls, 1, dims, lbs, elem.col_oid, elem.typlen, elem.typbyval, elem.typalign));
+}
+
+/*
+ * getCompositeDatum
+ *    Returns a row of a STRUCT column as a value of its composite type.
+ */
+static
+Datum
+getCompositeDatum(OrcFdwExecState *fdw_estate, const OrcFdwColInfo &col, orc::ColumnVectorBatch *field, int64_t row)
+{
+    orc::StructVectorBatch *fields = static_cast<orc::StructVectorBatch *>(field);
+    int natts = col.tupdesc->natts;
+    Datum *values = (Datum *) palloc(natts * sizeof(Datum));
+    bool *nulls = (bool *) palloc(natts * sizeof(bool));
+
+    for (int attnum = 0; attnum < natts; attnum++)
+    {
+        int i = col.field_index[attnum];
+        orc::ColumnVectorBatch *child = (i >= 0) ? fields->fields[i] : NULL;
+
+        nulls[attnum] = (child == NULL || (child->hasNulls && !child->notNull[row]));
+        values[attnum] = nulls[attnum] ? (Datum) 0 : getColumnDatum(fdw_estate, col.children[i], child, row);
+    }
+
+    return HeapTupleGetDatum(heap_form_tuple(col.tupdesc, values, nulls));
+}
+
+/*
+ * pushJsonbColumn
+ *    Adds a row of a column vector to a jsonb being built: lists become
+ *    arrays, and maps and structs become objects. Strings point into the
+ *    vector until the jsonb is built.
+ */
+static
+JsonbValue *
+pushJsonbColumn(OrcFdwExecState *fdw_estate, JsonbParseState **state, const OrcFdwColInfo &col, orc::ColumnVectorBatch *field, int64_t row, JsonbIteratorToken token)
+{
+    JsonbValue v;
+
+    if (field->hasNulls && !field->notNull[row])
+    {
+        v.type = jbvNull;
+        return pushJsonbScalar(state, &v, token);
+    }
+
+    switch (col.kind)
+    {
+        case OrcPgTypeKind::LIST:
+        {
+            orc::ListVectorBatch *list = static_cast<orc::ListVectorBatch *>(field);
+
+            (void) pushJsonbValue(state, WJB_BEGIN_ARRAY, NULL);
+
+            for (int64_t i = list->offsets[row]; i < list->offsets[row + 1]; i++)
+                (void) pushJsonbColumn(fdw_estate, state, col.children[0], list->elements.get(), i, WJB_ELEM);
+
+            return pushJsonbValue(state, WJB_END_ARRAY, NULL);
+        }
+        case OrcPgTypeKind::MAP:
+        {
+            orc::MapVectorBatch *map = static_cast<orc::MapVectorBatch *>(field);
+
+            (void) pushJsonbValue(state, WJB_BEGIN_OBJECT, NULL);
+
+            for (int64_t i = map->offsets[row]; i < map->offsets[row + 1]; i++)
+            {
+                /* Object keys are strings */
+                if (map->keys->hasNulls && !map->keys->notNull[i])
+                    continue;
+
+                getJsonbScalar(fdw_estate, col.children[0], map->keys.get(), i, &v);
+
+                if (v.type == jbvNumeric)
+                {
+                    char *key = DatumGetCString(DirectFunctionCall1(numeric_out, NumericGetDatum(v.val.numeric)));
+
+                    v.type = jbvString;
+                    v.val.string.val = key;
+                    v.val.string.len = strlen(key);
+                }
+                else if (v.type == jbvBool)
+                {
+                    v.type = jbvString;
+                    v.val.string.val = (char *) (v.val.boolean ? "true" : "false");
+                    v.val.string.len = strlen(v.val.string.val);
+                }
+
+                (void) pushJsonbValue(state, WJB_KEY, &v);
+                (void) pushJsonbColumn(fdw_estate, state, col.children[1], map->elements.get(), i, WJB_VALUE);
+            }
+
+            return pushJsonbValue(state, WJB_END_OBJECT, NULL);
+        }
+        case OrcPgTypeKind::STRUCT:
+        {
+            orc::StructVectorBatch *fields = static_cast<orc::StructVectorBatch *>(field);
+
+            (void) pushJsonbValue(state, WJB_BEGIN_OBJECT, NULL);
+
+            for (uint i = 0; i < col.children.size(); i++)
+            {
+                v.type = jbvString;
+                v.val.string.val = (char *) col.children[i].name.c_str();
+                v.val.string.len = col.children[i].name.length();
+
+                (void) pushJsonbValue(state, WJB_KEY, &v);
+                (void) pushJsonbColumn(fdw_estate, state, col.children[i], fields->fields[i], row, WJB_VALUE);
+            }
+
+            return pushJsonbValue(state, WJB_END_OBJECT, NULL);
+        }
+        default:
+        {
+            getJsonbScalar(fdw_estate, col, field, row, &v);
+            return pushJsonbScalar(state, &v, token);
+        }
+    }
+}
+
+/*
+ * pushJsonbScalar
+ *    Adds a scalar to a jsonb being built; a scalar at the top level is a
+ *    raw scalar array of one element.
+ */
+static
+JsonbValue *
+pushJsonbScalar(JsonbParseState **state, JsonbValue *v, JsonbIteratorToken token)
+{
+    JsonbValue array;
+
+    if (*state != NULL)
+        return pushJsonbValue(state, token, v);
+
+    array.type = jbvArray;
+    array.val.array.rawScalar = true;
+    array.val.array.nElems = 1;
+
+    (void) pushJsonbValue(state, WJB_BEGIN_ARRAY, &array);
+    (void) pushJsonbValue(state, WJB_ELEM, v);
+    return pushJsonbValue(state, WJB_END_ARRAY, NULL);
+}
+
+/*
+ * getJsonbScalar
+ *    Sets v to a row of a column of a simple type. Numbers are JSON
+ *    numbers, except for NaN and infinities; strings point into the
+ *    vector; other types are strings in their text format.
+ */
+static
+void
+getJsonbScalar(OrcFdwExecState *fdw_estate, const OrcFdwColInfo &col, orc::ColumnVectorBatch *field, int64_t row, JsonbValue *v)
+{
+    switch (col.kind)
+    {
+        case OrcPgTypeKind::BOOLEAN:
+        {
+            v->type = jbvBool;
+            v->val.boolean = (static_cast<orc::LongVectorBatch *>(field)->data[row] != 0);
+            break;
+        }
+        case OrcPgTypeKind::BYTE:
+        case OrcPgTypeKind::SHORT:
+        case OrcPgTypeKind::INT:
+        case OrcPgTypeKind::LONG:
+        {
+            int64_t value = static_cast<orc::LongVectorBatch *>(field)->data[row];
+
+            v->type = jbvNumeric;
+#if PG_VERSION_NUM >= 140000
+            v->val.numeric = int64_to_numeric(value);
+#else
+            v->val.numeric = DatumGetNumeric(DirectFunctionCall1(int8_numeric, Int64GetDatum(value)));
+#endif
+            break;
+        }
+        case OrcPgTypeKind::FLOAT:
+        case OrcPgTypeKind::DOUBLE:
+        {
+            double value = static_cast<orc::DoubleVectorBatch *>(field)->data[row];
+
+            if (std::isfinite(value))
+            {
+                v->type = jbvNumeric;
+                v->val.numeric = DatumGetNumeric(DirectFunctionCall1(float8_numeric, Float8GetDatum(value)));
+            }
+            else
+            {
+                v->type = jbvString;
+                v->val.string.val = (char *) (std::isnan(value) ? "NaN" : (value > 0) ? "Infinity" : "-Infinity");
+                v->val.string.len = strlen(v->val.string.val);
+            }
+
+            break;
+        }
+        case OrcPgTypeKind::DECIMAL:
+        {
+            v->type = jbvNumeric;
+            v->val.numeric = DatumGetNumeric(getColumnDatum(fdw_estate, col, field, row));
+            break;
+        }
+        case OrcPgTypeKind::STRING:
+        case OrcPgTypeKind::VARCHAR:
+        case OrcPgTypeKind::CHAR:
+        {
+            orc::StringVectorBatch *s = static_cast<orc::StringVectorBatch *>(field);
+
+            v->type = jbvString;
+            v->val.string.val = s->data[row];
+            v->val.string.len = (int) s->length[row];
+            break;
+        }
+        case OrcPgTypeKind::BINARY:
+        case OrcPgTypeKind::DATE:
+        case OrcPgTypeKind::TIMESTAMP:
+        {
+            Datum d = getColumnDatum(fdw_estate, col, field, row);
+            char *value;
+
+            if (col.kind == OrcPgTypeKind::BINARY)
+                value = DatumGetCString(DirectFunctionCall1(byteaout, d));
+            else if (col.kind == OrcPgTypeKind::DATE)
+                value = DatumGetCString(DirectFunctionCall1(date_out, d));
+            else
+                value = DatumGetCString(DirectFunctionCall1(timestamp_out, d));
+
+            v->type = jbvString;
+            v->val.string.val = value;
+            v->val.string.len = strlen(value);
+            break;
+        }
+        default:
+        {
+            ereport(ERROR, (errmsg("%s: unsupported column data type for column %s", ORC_FDW_NAME, col.name.c_str())));
+            break;
+        }
+    }
+}
+
 /*
  * fillSlot
  *    Fill data in all ORC mappable columns from the ORC file.
@@ -863,10 +1817,7 @@ fillSlot(OrcFdwExecState *fdw_estate, TupleTableSlot *slot)
         /* Column is in the ORC file */
         if (col_index >= 0)
         {
-            Datum d = getDatumForData(fdw_estate, fdw_estate->curr_batch_row_num, col_index, slot->tts_tupleDescriptor->attrs[attnum].atttypid);
-
-            slot->tts_values[attnum] = d;
-            slot->tts_isnull[attnum] = false;
+            slot->tts_values[attnum] = getDatumForData(fdw_estate, fdw_estate->curr_batch_row_num, col_index, &slot->tts_isnull[attnum]);
         }
         else
         {
@@ -874,11 +1825,49 @@ fillSlot(OrcFdwExecState *fdw_estate, TupleTableSlot *slot)
         }
     }
 
-    /* Increment row counters */
-    fdw_estate->curr_batch_row_num++;
+    return slot;
+}
+
+/*
+ * nextFooterRow
+ *    Returns the next row of a scan that needs no column values; a row
+ *    without values per row of the file, or a single row with the count
+ *    of rows of the file in each of its count(*) columns.
+ */
+static
+TupleTableSlot *
+nextFooterRow(OrcFdwExecState *fdw_estate, TupleTableSlot *slot)
+{
+    bool is_count = (fdw_estate->zero_columns == ORC_ZERO_COLUMNS_COUNT);
+    int64_t rows = is_count ? 1 : fdw_estate->total_rows;
+    int attnum;
+
+    /* Rows not sampled are skipped; the count is of the whole file */
+    if (!is_count)
+    {
+        int64_t next_row = orcSampleNextRow(fdw_estate->sample, fdw_estate->row_num, rows);
+
+        fdw_estate->stats.rows_filtered += next_row - fdw_estate->row_num;
+        fdw_estate->row_num = next_row;
+    }
+
+    if (fdw_estate->row_num >= rows)
+    {
+        orcScanStatsEnd(fdw_estate->stats);
+        return slot;
+    }
+
     fdw_estate->row_num++;
 
-    return slot;
+    for (attnum = 0; attnum < slot->tts_tupleDescriptor->natts; attnum++)
+    {
+        slot->tts_values[attnum] = is_count ? Int64GetDatum(fdw_estate->total_rows) : (Datum) 0;
+        slot->tts_isnull[attnum] = !is_count;
+    }
+
+    fdw_estate->stats.rows_returned++;
+
+    return ExecStoreVirtualTuple(slot);
 }
 
 /*
@@ -889,29 +1878,33 @@ extern "C"
 void
 orcGetForeignRelSize(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid)
 {
-	orc::ReaderOptions options;
-	ORC_UNIQUE_PTR<orc::Reader> reader;
-	orc::RowReaderOptions rowReaderOptions;
-	ORC_UNIQUE_PTR<orc::RowReader> rowReader;
-	ORC_UNIQUE_PTR<orc::ColumnVectorBatch> batch;
-    orc::StructVectorBatch *batch_data;
+    OrcPooledReader *pooled_reader;
+	ORC_UNIQUE_PTR<orc::Reader> *reader;
+    bool pool_hit;
 
     OrcFdwPlanState *fdw_private = (OrcFdwPlanState *)(palloc0(sizeof(OrcFdwPlanState)));
 
     baserel->fdw_private = fdw_private;
+    fdw_private->foreigntableid = foreigntableid;
 
     (void) getTableOptionsFromRelID(foreigntableid, fdw_private);
 
-    /* Open the ORC file to fetch relevant information for planning */
-    (void) orcCreateReader(fdw_private->filename, &reader, options, true);
-    (void) orcCreateRowReader(&reader, &rowReader, rowReaderOptions);
+    /* Open the ORC file to fetch relevant information for planning; the
+     * reader is kept in the pool for the scan, and closed by the pool if
+     * planning fails before it's checked in */
+    pooled_reader = orcReaderPoolCheckout(fdw_private->filename, NULL, &pool_hit);
+    reader = &(pooled_reader->reader);
+    orcWarnUnsupportedVersion(fdw_private->filename, reader);
 
-    /* We just need to fetch column data, so let's just set row batch size to 1 */
-	batch = rowReader->createRowBatch(1);
-    batch_data = dynamic_cast<orc::StructVectorBatch *>(batch.get());
+    /* Let's get all the columns in the ORC file; built once per file and
+     * kept with its reader */
+    if (pooled_reader->columns == NULL)
+        pooled_reader->columns = getFileColumns(reader);
 
-    /* Let's get all the columns in the ORC file */
-    std::vector<OrcFdwColInfo> cols_info = getMappedColsFromReader(&reader, &rowReader, batch_data);
+    fdw_private->file_columns = keepFileColumns(pooled_reader->columns);
+
+    const std::vector<OrcFdwColInfo> &cols_info = pooled_reader->columns->cols_info;
+    const std::vector<bool> &lookup = pooled_reader->columns->lookup;
 
     /* Assume that we aren't dealing with aggregates */
     fdw_private->hasAggregate = false;
@@ -921,20 +1914,41 @@ orcGetForeignRelSize(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid)
     fdw_private->col_orc_name = NIL;
     fdw_private->col_orc_oid = NIL;
     fdw_private->col_orc_file_index = NIL;
+    fdw_private->col_orc_type_ids = NIL;
+    fdw_private->col_orc_lookup = NIL;
 
     /* Fill data in lists */
-    for (auto col = cols_info.begin(); col != cols_info.end(); col++)
+    for (size_t i = 0; i < cols_info.size(); i++)
     {
         char *name;
-        name = pstrdup((*col).name.c_str());
+        name = pstrdup(cols_info[i].name.c_str());
 
         fdw_private->col_orc_name = lappend(fdw_private->col_orc_name, makeString(name));
-        fdw_private->col_orc_oid = lappend_oid(fdw_private->col_orc_oid, (*col).col_oid);
-        fdw_private->col_orc_file_index = lappend_int(fdw_private->col_orc_file_index, (*col).index);
+        fdw_private->col_orc_oid = lappend_oid(fdw_private->col_orc_oid, cols_info[i].col_oid);
+        fdw_private->col_orc_file_index = lappend_int(fdw_private->col_orc_file_index, cols_info[i].index);
+
+        if (lookup[i])
+            fdw_private->col_orc_lookup = lappend(fdw_private->col_orc_lookup, makeString(name));
     }
 
     /* Set total number of rows in the ORC file */
-    baserel->rows = fdw_private->rows = orcGetNumberOfRows(&reader);
+    baserel->rows = fdw_private->rows = orcGetNumberOfRows(reader);
+    baserel->tuples = (double) fdw_private->rows;
+
+    /* IS NULL is never true for a column without NULLs in the file */
+    if (hasNullFreeTest(baserel, fdw_private))
+        baserel->rows = 1;
+
+    /* Sampling is fixed when the scan is planned */
+    fdw_private->sample_method = (OrcFdwSampleMethod) orc_sample_method;
+    fdw_private->sample_percent = orc_sample_percent;
+    fdw_private->sample_seed = orc_sample_seed;
+
+    if (fdw_private->sample_method != ORC_SAMPLE_NONE)
+        baserel->rows = clamp_row_est(baserel->rows * fdw_private->sample_percent / 100.0);
+
+    fdw_private->stripes = (*reader)->getNumberOfStripes();
+    fdw_private->row_index_stride = orcGetRowIndexStride(reader);
 
     /* Classify */
     classifyConditions(root, baserel, baserel->baserestrictinfo,
@@ -944,191 +1958,1246 @@ orcGetForeignRelSize(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid)
     fdw_private->startup_cost = ORC_DEFAULT_FDW_STARTUP_COST;
     fdw_private->tuple_cost = ORC_DEFAULT_FDW_TUPLE_COST;
 
-    /* FIXME: Do we need to set any other members? */
-    fdw_private->foreigntableid = foreigntableid;
+    orcReaderPoolCheckin(pooled_reader);
 }
 
 /*
- * orcGetForeignPaths
- *    ORC FDW function set in orc_fdw.c
+ * getFileColumns
+ *    Returns the mappable columns of an ORC file, whether each can look
+ *    up values, and a case insensitive index of their names.
  */
-extern "C"
-void
-orcGetForeignPaths(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid)
+static
+std::shared_ptr<const OrcFdwFileColumns>
+getFileColumns(ORC_UNIQUE_PTR<orc::Reader> *p_reader)
 {
-    OrcFdwPlanState *fdw_private = (OrcFdwPlanState *)(baserel->fdw_private);
-    ForeignPath *path = NULL;
+    std::shared_ptr<OrcFdwFileColumns> columns = std::make_shared<OrcFdwFileColumns>();
+	orc::RowReaderOptions rowReaderOptions;
+	ORC_UNIQUE_PTR<orc::RowReader> rowReader;
+	ORC_UNIQUE_PTR<orc::ColumnVectorBatch> batch;
+    orc::StructVectorBatch *batch_data;
 
-    /* FIXME: We are not considering filters or stats in the ORC file
-     * for this release. */
-    Cost total_cost = fdw_private->startup_cost + (fdw_private->tuple_cost * fdw_private->rows);
+    (void) orcCreateRowReader(p_reader, &rowReader, rowReaderOptions);
 
-    path = create_foreignscan_path(root, baserel, 
-                                        NULL,
-                                        (double)(fdw_private->rows),
-                                        fdw_private->startup_cost,
-                                        total_cost,
-                                        NIL,        /* FIXME: Do we need to add path keys? */
-                                        NULL,       /* FIXME: Add outer rel? */
-                                        NULL,       /* FIXME: Extra plans? */
-                                        (List *) fdw_private);
+    /* We just need to fetch column data, so let's just set row batch size to 1 */
+	batch = rowReader->createRowBatch(1);
+    batch_data = dynamic_cast<orc::StructVectorBatch *>(batch.get());
+
+    columns->cols_info = getMappedColsFromReader(p_reader, &rowReader, batch_data);
+
+    /* Columns that can locate values through bloom filters or stripe
+     * statistics; used for parameterized paths. */
+    std::set<uint64_t> bloom_cols = orcGetBloomFilterColumns(p_reader);
+    std::vector<uint64_t> col_ids;
+    std::vector<orc::TypeKind> kinds;
+
+    for (auto col = columns->cols_info.begin(); col != columns->cols_info.end(); col++)
+    {
+        col_ids.push_back((*col).col_id);
+        kinds.push_back((orc::TypeKind) (*col).kind);
+    }
+
+    std::vector<bool> sorted_cols = orcGetSortedColumns(p_reader, col_ids, kinds);
+
+    for (size_t i = 0; i < columns->cols_info.size(); i++)
+    {
+        const OrcFdwColInfo &col = columns->cols_info[i];
+
+        columns->lookup.push_back(bloom_cols.count(col.col_id) > 0 || sorted_cols[i]);
+
+        /* Of names differing in case only, the first column is used */
+        columns->positions.emplace(orcFoldColumnName(col.name.c_str()), (int) i);
+    }
+
+    return columns;
+}
+
+/*
+ * keepFileColumns
+ *    Returns a reference to the columns of a file that is released with
+ *    the current memory context; the plan state refers to them after the
+ *    reader is back in the pool, where it may be closed.
+ */
+static
+std::shared_ptr<const OrcFdwFileColumns> *
+keepFileColumns(const std::shared_ptr<const OrcFdwFileColumns> &columns)
+{
+    MemoryContextCallback *callback = (MemoryContextCallback *) palloc0(sizeof(MemoryContextCallback));
+    std::shared_ptr<const OrcFdwFileColumns> *kept = new std::shared_ptr<const OrcFdwFileColumns>(columns);
+
+    callback->func = releaseFileColumns;
+    callback->arg = kept;
+    MemoryContextRegisterResetCallback(CurrentMemoryContext, callback);
+
+    return kept;
+}
+
+static
+void
+releaseFileColumns(void *arg)
+{
+    delete (std::shared_ptr<const OrcFdwFileColumns> *) arg;
+}
+
+/*
+ * orcFoldColumnName
+ *    Returns a column name in lower case; names are matched to ORC
+ *    columns ignoring case, as with pg_strcasecmp.
+ */
+std::string
+orcFoldColumnName(const char *name)
+{
+    std::string folded(name);
+
+    for (size_t i = 0; i < folded.size(); i++)
+        folded[i] = (char) pg_tolower((unsigned char) folded[i]);
+
+    return folded;
+}
+
+/*
+ * orcFindFileColumn
+ *    Returns the ORC column of a table column name, or NULL if the file
+ *    has no such column; through the index of the file's column names.
+ */
+const OrcFdwColInfo *
+orcFindFileColumn(const OrcFdwPlanState *fdw_state, const char *name)
+{
+    const OrcFdwFileColumns &columns = **(fdw_state->file_columns);
+    auto position = columns.positions.find(orcFoldColumnName(name));
+
+    if (position == columns.positions.end())
+        return NULL;
+
+    return &columns.cols_info[position->second];
+}
+
+/*
+ * hasNullFreeTest
+ *    Returns true if a restriction tests a column for IS NULL while the
+ *    hasNull statistic of the file says the column has no NULLs.
+ */
+static
+bool
+hasNullFreeTest(RelOptInfo *baserel, OrcFdwPlanState *fdw_state)
+{
+    ListCell *lc;
+
+    foreach(lc, baserel->baserestrictinfo)
+    {
+        RestrictInfo *ri = lfirst_node(RestrictInfo, lc);
+        NullTest *test = (NullTest *) ri->clause;
+        Node *arg;
+        char *attname;
+        const OrcFdwColInfo *col;
+
+        if (!IsA(test, NullTest) || test->nulltesttype != IS_NULL || test->argisrow)
+            continue;
+
+        arg = (Node *) test->arg;
+
+        if (IsA(arg, RelabelType))
+            arg = (Node *) ((RelabelType *) arg)->arg;
+
+        if (!IsA(arg, Var) || ((Var *) arg)->varattno <= 0)
+            continue;
+
+        attname = get_attname(fdw_state->foreigntableid, ((Var *) arg)->varattno, true);
+
+        if (attname == NULL)
+            continue;
+
+        col = orcFindFileColumn(fdw_state, attname);
+
+        if (col != NULL && !col->hasNull)
+            return true;
+    }
+
+    return false;
+}
+
+/*
+ * orcGetForeignPaths
+ *    ORC FDW function set in orc_fdw.c
+ */
+extern "C"
+void
+orcGetForeignPaths(PlannerInfo *root, RelOptInfo *baserel, Oid foreigntableid)
+{
+    OrcFdwPlanState *fdw_private = (OrcFdwPlanState *)(baserel->fdw_private);
+    ForeignPath *path = NULL;
+
+    /* FIXME: We are not considering filters or stats in the ORC file
+     * for this release. */
+    Cost total_cost = fdw_private->startup_cost + (fdw_private->tuple_cost * fdw_private->rows
+                        * orcSampleReadFraction(fdw_private->sample_method, fdw_private->sample_percent));
+
+    path = create_foreignscan_path(root, baserel, 
+                                        NULL,
+                                        baserel->rows,
+                                        fdw_private->startup_cost,
+                                        total_cost,
+                                        NIL,        /* FIXME: Do we need to add path keys? */
+                                        NULL,       /* FIXME: Add outer rel? */
+                                        NULL,       /* FIXME: Extra plans? */
+                                        (List *) fdw_private);
+
+    add_path(baserel, (Path *)path);
+
+    /* Index-like lookups for nested loops */
+    addParamPaths(root, baserel, fdw_private);
+}
+
+/*
+ * isLookupColumn
+ *    Returns true if the ORC column is sorted or has bloom filters.
+ */
+static
+bool
+isLookupColumn(OrcFdwPlanState *fdw_state, const char *orcname)
+{
+    ListCell *lc;
+
+    foreach(lc, fdw_state->col_orc_lookup)
+    {
+        if (strcmp(strVal(lfirst(lc)), orcname) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+/*
+ * ec_member_matches_foreign
+ *    Callback for generate_implied_equalities_for_column; finds the
+ *    equivalence class members of the foreign table one at a time.
+ */
+static
+bool
+ec_member_matches_foreign(PlannerInfo *root, RelOptInfo *rel, EquivalenceClass *ec, EquivalenceMember *em, void *arg)
+{
+    ec_member_foreign_arg *state = (ec_member_foreign_arg *) arg;
+    Expr *expr = em->em_expr;
+
+    /* If we've identified what we're processing in the current scan, we
+     * only want to match that expression. */
+    if (state->current != NULL)
+        return equal(expr, state->current);
+
+    /* Otherwise, ignore anything we've already processed. */
+    if (list_member(state->already_used, expr))
+        return false;
+
+    /* This is the new target to process. */
+    state->current = expr;
+    return true;
+}
+
+/*
+ * addParamPaths
+ *    Adds parameterized paths for equality join clauses on sorted or bloom
+ *    filtered columns. On each rescan, the executor rebuilds the search
+ *    argument for the outer values, so the ORC reader only reads stripes
+ *    and row groups that may contain them.
+ */
+static
+void
+addParamPaths(PlannerInfo *root, RelOptInfo *baserel, OrcFdwPlanState *fdw_private)
+{
+    List *clauses = NIL;
+    List *outer_relids = NIL;
+    ListCell *lc;
+
+    if (fdw_private->col_orc_lookup == NIL)
+        return;
+
+    /* Join clauses that aren't part of equivalence classes */
+    foreach(lc, baserel->joininfo)
+    {
+        RestrictInfo *rinfo = (RestrictInfo *) lfirst(lc);
+
+        if (!join_clause_is_movable_to(rinfo, baserel))
+            continue;
+
+        clauses = lappend(clauses, rinfo);
+    }
+
+    /* Join clauses implied by equivalence classes */
+    if (baserel->has_eclass_joins)
+    {
+        ec_member_foreign_arg arg;
+
+        arg.already_used = NIL;
+
+        for (;;)
+        {
+            List *ec_clauses;
+
+            /* Make clauses, skipping any that join to lateral_referencers */
+            arg.current = NULL;
+            ec_clauses = generate_implied_equalities_for_column(root, baserel, ec_member_matches_foreign, (void *) &arg, baserel->lateral_referencers);
+
+            /* Done if there are no more expressions in the foreign rel */
+            if (arg.current == NULL)
+                break;
+
+            foreach(lc, ec_clauses)
+            {
+                RestrictInfo *rinfo = (RestrictInfo *) lfirst(lc);
+
+                if (join_clause_is_movable_to(rinfo, baserel))
+                    clauses = lappend(clauses, rinfo);
+            }
+
+            /* Try again, now ignoring the expression we found this time */
+            arg.already_used = lappend(arg.already_used, arg.current);
+        }
+    }
+
+    /* Collect distinct outer relations of clauses usable for lookups */
+    foreach(lc, clauses)
+    {
+        RestrictInfo *rinfo = (RestrictInfo *) lfirst(lc);
+        char *orcname = get_param_pushdown_column(baserel, rinfo);
+        Relids required_outer;
+        ListCell *lc_outer;
+        bool found = false;
+
+        if (orcname == NULL || !isLookupColumn(fdw_private, orcname))
+            continue;
+
+        required_outer = bms_union(rinfo->clause_relids, baserel->lateral_relids);
+        required_outer = bms_del_member(required_outer, baserel->relid);
+
+        if (bms_is_empty(required_outer))
+            continue;
+
+        foreach(lc_outer, outer_relids)
+        {
+            if (bms_equal((Relids) lfirst(lc_outer), required_outer))
+            {
+                found = true;
+                break;
+            }
+        }
+
+        if (!found)
+            outer_relids = lappend(outer_relids, required_outer);
+    }
+
+    foreach(lc, outer_relids)
+    {
+        Relids required_outer = (Relids) lfirst(lc);
+        ParamPathInfo *param_info = get_baserel_parampathinfo(root, baserel, required_outer);
+        double rows = param_info->ppi_rows;
+        double stride = (fdw_private->row_index_stride > 0) ? (double) fdw_private->row_index_stride : (double) fdw_private->rows;
+        double groups = ceil((double) fdw_private->rows / Max(stride, 1.0));
+        double groups_read;
+        Cost total_cost;
+        ForeignPath *path;
+
+        /* Matching rows are unlikely to share a row group unless sorted;
+         * let's assume the worst and cap at reading the whole file. */
+        groups_read = Min(groups, Max(rows, 1.0));
+
+        total_cost = fdw_private->startup_cost
+                        + (fdw_private->tuple_cost * groups_read * Min(stride, (double) fdw_private->rows));
+
+        path = create_foreignscan_path(root, baserel,
+                                        NULL,
+                                        rows,
+                                        fdw_private->startup_cost,
+                                        total_cost,
+                                        NIL,
+                                        required_outer,
+                                        NULL,
+                                        (List *) fdw_private);
+
+        add_path(baserel, (Path *) path);
+    }
+}
+
+/*
+ * orcGetForeignUpperPaths
+ *    ORC FDW function set in orc_fdw.c
+ */
+extern "C"
+void
+orcGetForeignUpperPaths(PlannerInfo *root, UpperRelationKind stage, RelOptInfo *input_rel, RelOptInfo *output_rel, void *extra)
+{
+    OrcFdwPlanState *fdw_state = (OrcFdwPlanState *) input_rel->fdw_private;
+    ForeignPath *path;
+
+	if (stage != UPPERREL_GROUP_AGG || fdw_state == NULL)
+        return;
+
+    fdw_state->hasAggregate = true;
+
+    /* count(*) of the whole file is the row count in its footer */
+    if (fdw_state->sample_method != ORC_SAMPLE_NONE || !isFooterCount(root, input_rel, output_rel))
+        return;
+
+    path = create_foreign_upper_path(root, output_rel,
+                                        output_rel->reltarget,
+                                        1,
+                                        fdw_state->startup_cost,
+                                        fdw_state->startup_cost,
+                                        NIL,
+                                        NULL,
+                                        (List *) fdw_state);
+
+    add_path(output_rel, (Path *) path);
+}
+
+/*
+ * isFooterCount
+ *    Returns true if the aggregation of the ORC table only computes
+ *    count(*) over all rows of the file, without grouping or conditions.
+ */
+static
+bool
+isFooterCount(PlannerInfo *root, RelOptInfo *input_rel, RelOptInfo *output_rel)
+{
+    Query *parse = root->parse;
+    ListCell *lc;
+
+    if (input_rel->reloptkind != RELOPT_BASEREL || input_rel->baserestrictinfo != NIL)
+        return false;
+
+    if (parse->groupClause != NIL || parse->groupingSets != NIL || parse->havingQual != NULL)
+        return false;
+
+    foreach(lc, output_rel->reltarget->exprs)
+    {
+        Aggref *aggref = (Aggref *) lfirst(lc);
+
+        if (!IsA(aggref, Aggref) || aggref->aggfnoid != F_COUNT_ || !aggref->aggstar
+            || aggref->aggfilter != NULL || aggref->aggorder != NIL || aggref->aggdistinct != NIL
+            || aggref->aggsplit != AGGSPLIT_SIMPLE)
+        {
+            return false;
+        }
+    }
+
+    return (output_rel->reltarget->exprs != NIL);
+}
+
+/*
+ * orcGetForeignJoinPaths
+ *    We don't want to handling joins remotely, however we do want to set 
+ *    set a flag here to prevent target list pushdown from happening in
+ *    this case.
+ */
+extern "C"
+void
+orcGetForeignJoinPaths(PlannerInfo *root, RelOptInfo *joinrel, RelOptInfo *outerrel, RelOptInfo *innerrel, JoinType jointype, JoinPathExtraData *extra)
+{
+    OrcFdwPlanState *fdw_state = NULL;
+
+    if (outerrel->fdw_private)
+        fdw_state = (OrcFdwPlanState *)(outerrel->fdw_private);
+
+    if (innerrel->fdw_private)
+        fdw_state = (OrcFdwPlanState *)(innerrel->fdw_private);
+
+    if (fdw_state)
+    {
+        fdw_state->hasJoins = true;
+    }
+}
+
+/*
+ * orcGetForeignPlan
+ *    ORC FDW function set in orc_fdw.c
+ */
+extern "C"
+ForeignScan *
+orcGetForeignPlan(PlannerInfo *root, RelOptInfo *baserel,
+            Oid foreigntableid, ForeignPath *best_path, 
+            List *tlist, List *scan_clauses,
+            Plan *outer_plan)
+{
+    Index scan_relid = baserel->relid;
+    OrcFdwPlanState *fdw_state = (OrcFdwPlanState *)(best_path->fdw_private);
+    List *fdw_private;
+    List *fdw_exprs = NIL;
+    List *pushdown_conds;
+    List *pushdown;
+    List *attr_names;
+    List *attr_types;
+    bool blnShouldSetRowReader = (fdw_state->hasAggregate == false && fdw_state->hasJoins == false);
+
+    /* count(*) of the whole file; see orcGetForeignUpperPaths */
+    if (IS_UPPER_REL(baserel))
+        return getFooterCountPlan(fdw_state, tlist, outer_plan);
+
+    /* All conditions are rechecked locally; pushdown only prunes data */
+    scan_clauses = extract_actual_clauses(scan_clauses, false);
+
+    /* Pushdown predicates for the ORC reader; must be built before the
+     * column name list is trimmed to the required columns. Join clauses
+     * of a parameterized path are pushed down as well; the planner
+     * replaces outer values in fdw_exprs with parameters. */
+    pushdown_conds = list_copy(fdw_state->remote_conds);
+
+    if (best_path->path.param_info != NULL)
+    {
+        ListCell *lc;
+
+        foreach(lc, best_path->path.param_info->ppi_clauses)
+        {
+            RestrictInfo *rinfo = lfirst_node(RestrictInfo, lc);
+
+            if (get_param_pushdown_column(baserel, rinfo) != NULL)
+                pushdown_conds = lappend(pushdown_conds, rinfo);
+        }
+    }
+
+    pushdown = build_pushdown_list(baserel, pushdown_conds, &fdw_exprs);
+
+    /* Set column details in a list to be used in the execution state */
+    (void) getColumnNameList(root, baserel, fdw_state, tlist);
+    fdw_private = list_make4(makeString(fdw_state->filename),
+                                fdw_state->col_orc_file_index,
+                                makeInteger(blnShouldSetRowReader),
+                                pushdown);
+    fdw_private = lappend(fdw_private, makeInteger(fdw_state->rescan_cache));
+    fdw_private = lappend(fdw_private, fdw_state->col_orc_type_ids);
+
+    /* We are not going to update the fdw_scan_tlist for the time being.
+     * Scan tlist must also contain any columns required by the query.
+     * So, currently, let's pass NIL and assume that the whole row must
+     * be fetched. In private data, we have a column list to fetch from
+     * from ORC. We'll use that to modify the reader. */
+	List *fdw_scan_tlist = NIL;
+
+    if (blnShouldSetRowReader == true)
+    {
+        fdw_scan_tlist = build_tlist_to_deparse(baserel);
+    }
+
+    /* Look up names and types of the scan tuple once, at planning */
+    getScanAttrs(foreigntableid, fdw_scan_tlist, &attr_names, &attr_types);
+    fdw_private = lappend(fdw_private, attr_names);
+    fdw_private = lappend(fdw_private, attr_types);
+
+    /* Conditions on no column can't prune data, but check anyway */
+    fdw_private = lappend(fdw_private, makeInteger((fdw_state->zero_columns && pushdown == NIL) ? ORC_ZERO_COLUMNS_ROWS : ORC_ZERO_COLUMNS_NONE));
+    fdw_private = lappend(fdw_private, getSamplePrivate(fdw_state));
+
+    /*
+     * Now fix the subplan's tlist --- this might result in inserting
+     * a Result node atop the plan tree.
+     */
+    return make_foreignscan(tlist, 
+                    scan_clauses, 
+                    scan_relid,
+                    fdw_exprs,
+                    fdw_private,
+                    fdw_scan_tlist,
+                    NIL,
+                    outer_plan);
+}
+
+/*
+ * getScanAttrs
+ *    Returns the column names and types of the scan tuple; the columns of
+ *    the target list, or without one, the types of the table's columns.
+ */
+static
+void
+getScanAttrs(Oid foreigntableid, List *fdw_scan_tlist, List **attr_names, List **attr_types)
+{
+    ListCell *lc;
+
+    *attr_names = NIL;
+    *attr_types = NIL;
+
+    if (fdw_scan_tlist == NIL)
+    {
+        Relation rel = table_open(foreigntableid, AccessShareLock);
+        TupleDesc tupleDesc = RelationGetDescr(rel);
+
+        /* Dropped columns have no type */
+        for (int i = 0; i < tupleDesc->natts; i++)
+            *attr_types = lappend_oid(*attr_types, TupleDescAttr(tupleDesc, i)->atttypid);
+
+        table_close(rel, AccessShareLock);
+        return;
+    }
+
+    foreach(lc, fdw_scan_tlist)
+    {
+        TargetEntry *tle = lfirst_node(TargetEntry, lc);
+        Var *var = (Var *) tle->expr;
+
+        Assert(IsA(var, Var));
+
+        *attr_names = lappend(*attr_names, makeString(get_attname(foreigntableid, var->varattno, false)));
+        *attr_types = lappend_oid(*attr_types, get_atttype(foreigntableid, var->varattno));
+    }
+}
+
+/*
+ * getFooterCountPlan
+ *    Returns the plan of a count(*) of the whole file. The scan tuple is
+ *    the count(*) columns of the target list, filled from the footer.
+ */
+static
+ForeignScan *
+getFooterCountPlan(OrcFdwPlanState *fdw_state, List *tlist, Plan *outer_plan)
+{
+    List *fdw_private;
+
+    fdw_private = list_make4(makeString(fdw_state->filename),
+                                NIL,
+                                makeInteger(false),
+                                NIL);
+    fdw_private = lappend(fdw_private, makeInteger(false));
+    fdw_private = lappend(fdw_private, NIL);
+    fdw_private = lappend(fdw_private, NIL);
+    fdw_private = lappend(fdw_private, NIL);
+    fdw_private = lappend(fdw_private, makeInteger(ORC_ZERO_COLUMNS_COUNT));
+    fdw_private = lappend(fdw_private, getSamplePrivate(fdw_state));
+
+    return make_foreignscan(tlist,
+                    NIL,
+                    0,
+                    NIL,
+                    fdw_private,
+                    tlist,
+                    NIL,
+                    outer_plan);
+}
+
+/*
+ * getSamplePrivate
+ *    Returns the sampling method, percentage and seed for fdw_private.
+ */
+static
+List *
+getSamplePrivate(OrcFdwPlanState *fdw_state)
+{
+    return list_make3(makeInteger(fdw_state->sample_method),
+                        makeFloat(psprintf("%.17g", fdw_state->sample_percent)),
+                        makeInteger(fdw_state->sample_seed));
+}
+
+extern "C"
+bool
+orcRecheckForeignScan(ForeignScanState *node, TupleTableSlot *slot)
+{
+    return true;
+}
+
+/*
+ * orcExplainForeignScan
+ *    Put out ORC file reading specific details here
+ */
+extern "C"
+void
+orcExplainForeignScan(ForeignScanState *node, ExplainState *es)
+{
+    OrcFdwExecState *fdw_estate = (OrcFdwExecState *)node->fdw_state;
+    ForeignScan *plan = castNode(ForeignScan, node->ss.ps.plan);
+    List *sample = (List *) list_nth(plan->fdw_private, OrcFdwScanPrivateSample);
+    OrcFdwSampleMethod sample_method = (OrcFdwSampleMethod) intVal(linitial(sample));
+
+    if (es->verbose)
+    {
+        bool hasColumns = false;
+        std::stringstream ss;
+
+        for (auto col = fdw_estate->cols_info.begin(); col != fdw_estate->cols_info.end(); col++)
+        {
+            if (hasColumns)
+                ss << ", ";
+
+            ss << (*col).name;
+            hasColumns = true;
+        }
+
+        ExplainPropertyText("ORC File Reader Columns", hasColumns ? ss.str().c_str() : "none", es);
+    }
+
+    /* TABLESAMPLE isn't allowed on foreign tables; show what's sampled */
+    if (sample_method != ORC_SAMPLE_NONE)
+    {
+        char *sample_text = psprintf("%s (%g) REPEATABLE (%d)",
+                                        orcSampleMethodName(sample_method),
+                                        floatVal(lsecond(sample)),
+                                        intVal(lthird(sample)));
+
+        ExplainPropertyText("ORC File Sample", sample_text, es);
+    }
+
+    if (es->analyze)
+        explainScanStats(fdw_estate, es);
+}
+
+/*
+ * getDecodeNs
+ *    Decode time is the time spent in the row reader other than I/O and
+ *    decompression.
+ */
+static
+uint64_t
+getDecodeNs(OrcFdwExecState *fdw_estate)
+{
+    uint64_t decompress_ns = fdw_estate->metrics->DecompressionLatencyUs * 1000;
+    uint64_t other_ns = fdw_estate->stats.io_ns + decompress_ns;
+
+    return fdw_estate->stats.next_ns - Min(fdw_estate->stats.next_ns, other_ns);
+}
+
+/*
+ * explainScanStats
+ *    Puts out counters collected by the scan.
+ */
+static
+void
+explainScanStats(OrcFdwExecState *fdw_estate, ExplainState *es)
+{
+    OrcFdwScanStats &stats = fdw_estate->stats;
+    uint64_t evaluated = fdw_estate->metrics->EvaluatedRowGroupCount;
+    uint64_t selected = fdw_estate->metrics->SelectedRowGroupCount;
+    uint64_t decompress_ns = fdw_estate->metrics->DecompressionLatencyUs * 1000;
+    uint64_t decode_ns = getDecodeNs(fdw_estate);
+    double fill = 0;
+
+    if (stats.batches > 0)
+        fill = 100.0 * stats.batch_rows / (stats.batches * fdw_estate->batchsize);
+
+    ExplainPropertyInteger("ORC Stripes Read", NULL, stats.stripes_read, es);
+    ExplainPropertyInteger("ORC Stripes Skipped", NULL, stats.stripes_skipped, es);
+    ExplainPropertyInteger("ORC Row Groups Skipped", NULL, evaluated - selected, es);
+    ExplainPropertyInteger("ORC Bytes Read", NULL, stats.bytes_read, es);
+    ExplainPropertyInteger("ORC Batches", NULL, stats.batches, es);
+    ExplainPropertyFloat("ORC Average Batch Fill", "%", fill, 1, es);
+    ExplainPropertyInteger("Rows Removed by ORC Filter", NULL, stats.rows_filtered, es);
+    ExplainPropertyInteger("ORC Peak Memory", "kB", (fdw_estate->memory_pool->getPeak() + 1023) / 1024, es);
+
+    if (es->timing)
+    {
+        ExplainPropertyFloat("ORC I/O Time", "ms", stats.io_ns / 1000000.0, 3, es);
+        ExplainPropertyFloat("ORC Decompression Time", "ms", decompress_ns / 1000000.0, 3, es);
+        ExplainPropertyFloat("ORC Decode Time", "ms", decode_ns / 1000000.0, 3, es);
+        ExplainPropertyFloat("ORC Conversion Time", "ms", stats.convert_ns / 1000000.0, 3, es);
+    }
+}
+
+/*
+ * orcBeginForeignScan
+ *    ORC FDW function set in orc_fdw.c
+ */
+extern "C"
+void
+orcBeginForeignScan(ForeignScanState *node, int eflags)
+{
+    List *col_orc_file_index;
+    List *col_orc_type_ids;
+    List *attr_names;
+    List *attr_types;
+    OrcFdwZeroColumns zero_columns;
+    List *sample;
+    char *filename;
+    bool blnShouldSetRowReader = false;
+    int rtindex;
+	RangeTblEntry *rte;
+    OrcFdwExecState *fdw_estate;
+    ForeignScan *plan = castNode(ForeignScan, node->ss.ps.plan);
+    List *fdw_private = plan->fdw_private;
+    EState *estate = node->ss.ps.state;
+
+	if (plan->scan.scanrelid > 0)
+		rtindex = plan->scan.scanrelid;
+	else
+		rtindex = bms_next_member(plan->fs_relids, -1);
+
+	rte = exec_rt_fetch(rtindex, estate);
+
+    filename = strVal(list_nth(fdw_private, OrcFdwScanPrivateFilename));
+    col_orc_file_index = (List *) list_nth(fdw_private, OrcFdwScanPrivateColIndex);
+    col_orc_type_ids = (List *) list_nth(fdw_private, OrcFdwScanPrivateTypeIds);
+    blnShouldSetRowReader = (bool) intVal(list_nth(fdw_private, OrcFdwScanPrivateSetRowReader));
+    attr_names = (List *) list_nth(fdw_private, OrcFdwScanPrivateAttrNames);
+    attr_types = (List *) list_nth(fdw_private, OrcFdwScanPrivateAttrTypes);
+    zero_columns = (OrcFdwZeroColumns) intVal(list_nth(fdw_private, OrcFdwScanPrivateZeroColumns));
+    sample = (List *) list_nth(fdw_private, OrcFdwScanPrivateSample);
+
+    /* Initialize and set execution state; the reader is the planner's
+     * one from the reader pool when planned in this backend */
+    node->fdw_state = orcInitExecState(&fdw_estate, filename, col_orc_file_index, col_orc_type_ids, attr_names, attr_types, blnShouldSetRowReader, zero_columns);
+
+    /* SYSTEM picks the row groups to read from the file's layout */
+    orcSampleSetup(fdw_estate->sample,
+                    (OrcFdwSampleMethod) intVal(linitial(sample)),
+                    floatVal(lsecond(sample)),
+                    intVal(lthird(sample)),
+                    fdw_estate->reader);
+
+    /* Pushdown values may depend on parameters, so these are evaluated
+     * when the scan starts rather than here; that also keeps EXPLAIN from
+     * evaluating them. */
+    fdw_estate->pushdown = (List *) list_nth(fdw_private, OrcFdwScanPrivatePushdown);
+    fdw_estate->pushdown_exprs = ExecInitExprList(plan->fdw_exprs, (PlanState *) node);
+    fdw_estate->pushdown_pending = (fdw_estate->pushdown != NIL);
+
+    /* Counters are added to pg_stat_orc_fdw when the scan ends */
+    fdw_estate->relid = rte->relid;
+    fdw_estate->report_stats = !(eflags & EXEC_FLAG_EXPLAIN_ONLY);
+    fdw_estate->stats.scans = 1;
+
+    /* Rows are cached in a tuplestore that spills beyond work_mem */
+    fdw_estate->rescan_cache = NULL;
+    fdw_estate->rescan_cache_slot = NULL;
+    fdw_estate->rescan_cache_complete = false;
+    fdw_estate->rescan_cache_replay = false;
+
+    if (intVal(list_nth(fdw_private, OrcFdwScanPrivateRescanCache)) && !(eflags & EXEC_FLAG_EXPLAIN_ONLY))
+    {
+        TupleDesc tupdesc = node->ss.ss_ScanTupleSlot->tts_tupleDescriptor;
+
+        fdw_estate->rescan_cache = tuplestore_begin_heap(false, false, work_mem);
+        fdw_estate->rescan_cache_slot = MakeSingleTupleTableSlot(tupdesc, &TTSOpsMinimalTuple);
+    }
+}
+
+/*
+ * getPushdownType
+ *    Returns the ORC predicate type for a column type.
+ */
+static
+orc::PredicateDataType
+getPushdownType(Oid coltype)
+{
+    switch (coltype)
+    {
+        case BOOLOID:
+            return orc::PredicateDataType::BOOLEAN;
+        case INT2OID:
+        case INT4OID:
+        case INT8OID:
+            return orc::PredicateDataType::LONG;
+        case FLOAT4OID:
+        case FLOAT8OID:
+            return orc::PredicateDataType::FLOAT;
+        case TEXTOID:
+        case VARCHAROID:
+            return orc::PredicateDataType::STRING;
+        case DATEOID:
+            return orc::PredicateDataType::DATE;
+        default:
+            ereport(ERROR, (errmsg("%s: unsupported pushdown column type %u", ORC_FDW_NAME, coltype)));
+    }
+
+    /* Keep compiler quiet */
+    return orc::PredicateDataType::LONG;
+}
+
+/*
+ * getPushdownLong
+ *    Returns an integer or date value as stored in ORC LongVectorBatch.
+ */
+static
+int64_t
+getPushdownLong(Datum value, Oid valtype)
+{
+    switch (valtype)
+    {
+        case INT2OID:
+            return (int64_t) DatumGetInt16(value);
+        case INT4OID:
+            return (int64_t) DatumGetInt32(value);
+        case INT8OID:
+            return (int64_t) DatumGetInt64(value);
+        case DATEOID:
+            /* ORC dates are days since the UNIX epoch */
+            return (int64_t) DatumGetDateADT(value) + (POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE);
+        default:
+            ereport(ERROR, (errmsg("%s: unsupported pushdown value type %u", ORC_FDW_NAME, valtype)));
+    }
+
+    /* Keep compiler quiet */
+    return 0;
+}
+
+/*
+ * getPushdownLiteral
+ *    Converts a non-NULL value to an ORC literal. The literal makes its
+ *    own copy of string data.
+ */
+static
+orc::Literal
+getPushdownLiteral(Datum value, Oid valtype)
+{
+    switch (valtype)
+    {
+        case BOOLOID:
+            return orc::Literal((bool) DatumGetBool(value));
+        case INT2OID:
+        case INT4OID:
+        case INT8OID:
+            return orc::Literal(getPushdownLong(value, valtype));
+        case FLOAT4OID:
+            return orc::Literal((double) DatumGetFloat4(value));
+        case FLOAT8OID:
+            return orc::Literal((double) DatumGetFloat8(value));
+        case TEXTOID:
+        case VARCHAROID:
+        {
+            text *t = DatumGetTextPP(value);
+            return orc::Literal(VARDATA_ANY(t), VARSIZE_ANY_EXHDR(t));
+        }
+        case DATEOID:
+            return orc::Literal(orc::PredicateDataType::DATE, getPushdownLong(value, valtype));
+        default:
+            ereport(ERROR, (errmsg("%s: unsupported pushdown value type %u", ORC_FDW_NAME, valtype)));
+    }
 
-    add_path(baserel, (Path *)path);
+    /* Keep compiler quiet */
+    return orc::Literal(orc::PredicateDataType::LONG);
 }
 
 /*
- * orcGetForeignUpperPaths
- *    ORC FDW function set in orc_fdw.c
+ * getBatchField
+ *    Returns the field of the ORC column in row batches, or -1 if the
+ *    column isn't read.
  */
-extern "C"
-void
-orcGetForeignUpperPaths(PlannerInfo *root, UpperRelationKind stage, RelOptInfo *input_rel, RelOptInfo *output_rel, void *extra)
+static
+int
+getBatchField(OrcFdwExecState *fdw_estate, const std::string &orcname)
 {
-	if (stage == UPPERREL_GROUP_AGG && input_rel->fdw_private)
-        ((OrcFdwPlanState *)input_rel->fdw_private)->hasAggregate = true;
+    for (auto col = fdw_estate->cols_info.begin(); col != fdw_estate->cols_info.end(); col++)
+    {
+        if ((*col).name.compare(orcname) == 0)
+            return (*col).index;
+    }
+
+    return -1;
 }
 
 /*
- * orcGetForeignJoinPaths
- *    We don't want to handling joins remotely, however we do want to set 
- *    set a flag here to prevent target list pushdown from happening in
- *    this case.
+ * addRuntimeFilter
+ *    Adds a runtime filter dropping rows of fetched batches whose values
+ *    of an integer or date column aren't in values, before they are
+ *    converted. Used for large IN lists, typically keys of a join passed
+ *    in as an array parameter.
  */
-extern "C"
+static
 void
-orcGetForeignJoinPaths(PlannerInfo *root, RelOptInfo *joinrel, RelOptInfo *outerrel, RelOptInfo *innerrel, JoinType jointype, JoinPathExtraData *extra)
+addRuntimeFilter(OrcFdwExecState *fdw_estate, const std::string &orcname, const std::vector<int64_t> &values)
 {
-    OrcFdwPlanState *fdw_state = NULL;
+    OrcRuntimeFilter filter;
+    int field = getBatchField(fdw_estate, orcname);
 
-    if (outerrel->fdw_private)
-        fdw_state = (OrcFdwPlanState *)(outerrel->fdw_private);
+    /* The column must be in the batch to filter rows */
+    if (field < 0)
+        return;
 
-    if (innerrel->fdw_private)
-        fdw_state = (OrcFdwPlanState *)(innerrel->fdw_private);
+    orcBuildRuntimeFilter(filter, field, values);
+    fdw_estate->runtime_filters.push_back(filter);
+}
 
-    if (fdw_state)
+/*
+ * addRangeFilter
+ *    Adds a runtime filter for an equality or comparison condition on an
+ *    integer or date column.
+ */
+static
+void
+addRangeFilter(OrcFdwExecState *fdw_estate, const std::string &orcname, OrcPushdownOp op, int64_t value)
+{
+    OrcRuntimeFilter filter;
+    int field = getBatchField(fdw_estate, orcname);
+    int64_t min = PG_INT64_MIN;
+    int64_t max = PG_INT64_MAX;
+
+    if (field < 0)
+        return;
+
+    switch (op)
     {
-        fdw_state->hasJoins = true;
+        case ORC_PUSHDOWN_EQ:
+            min = max = value;
+            break;
+        case ORC_PUSHDOWN_LT:
+            if (value == PG_INT64_MIN)
+                return;
+            max = value - 1;
+            break;
+        case ORC_PUSHDOWN_LE:
+            max = value;
+            break;
+        case ORC_PUSHDOWN_GT:
+            if (value == PG_INT64_MAX)
+                return;
+            min = value + 1;
+            break;
+        case ORC_PUSHDOWN_GE:
+            min = value;
+            break;
+        default:
+            return;
     }
+
+    orcBuildRangeFilter(filter, field, min, max);
+    fdw_estate->runtime_filters.push_back(filter);
 }
 
 /*
- * orcGetForeignPlan
- *    ORC FDW function set in orc_fdw.c
+ * addStringFilter
+ *    Adds a filter for a LIKE prefix or a comparison on a string column.
  */
-extern "C"
-ForeignScan *
-orcGetForeignPlan(PlannerInfo *root, RelOptInfo *baserel,
-            Oid foreigntableid, ForeignPath *best_path, 
-            List *tlist, List *scan_clauses,
-            Plan *outer_plan)
+static
+void
+addStringFilter(OrcFdwExecState *fdw_estate, const std::string &orcname, OrcStringFilterOp op, const std::string &value)
 {
-    Index scan_relid = baserel->relid;
-    OrcFdwPlanState *fdw_state = (OrcFdwPlanState *)(best_path->fdw_private);
-    List *fdw_private;
-    bool blnShouldSetRowReader = (fdw_state->hasAggregate == false && fdw_state->hasJoins == false);
+    OrcStringFilter filter;
+    int field = getBatchField(fdw_estate, orcname);
 
-    scan_clauses = extract_actual_clauses(scan_clauses, false);
+    if (field < 0)
+        return;
 
-    /* Set column details in a list to be used in the execution state */
-    (void) getColumnNameList(baserel, fdw_state, tlist);
-    fdw_private = list_make3(makeString(fdw_state->filename),
-                                fdw_state->col_orc_file_index,
-                                makeInteger(blnShouldSetRowReader));
+    filter.field_index = field;
+    filter.op = op;
+    filter.value = value;
+    fdw_estate->string_filters.push_back(filter);
+}
 
-    /* We are not going to update the fdw_scan_tlist for the time being.
-     * Scan tlist must also contain any columns required by the query.
-     * So, currently, let's pass NIL and assume that the whole row must
-     * be fetched. In private data, we have a column list to fetch from
-     * from ORC. We'll use that to modify the reader. */
-	List *fdw_scan_tlist = NIL;
+/*
+ * getLikePrefix
+ *    Returns the literal bytes a LIKE pattern starts with, up to the first
+ *    wildcard. Backslash escapes the next character, which is also how
+ *    like_escape rewrites patterns with another escape character.
+ */
+static
+std::string
+getLikePrefix(Datum pattern)
+{
+    text *t = DatumGetTextPP(pattern);
+    const char *p = VARDATA_ANY(t);
+    int len = VARSIZE_ANY_EXHDR(t);
+    std::string prefix;
 
-    if (blnShouldSetRowReader == true)
+    for (int i = 0; i < len; i++)
     {
-        fdw_scan_tlist = build_tlist_to_deparse(baserel);
-    }
+        if (p[i] == '%' || p[i] == '_')
+            break;
 
-    /*
-     * Now fix the subplan's tlist --- this might result in inserting
-     * a Result node atop the plan tree.
-     */
-    return make_foreignscan(tlist, 
-                    scan_clauses, 
-                    scan_relid,
-                    NIL, 
-                    fdw_private,
-                    fdw_scan_tlist,
-                    NIL,
-                    outer_plan);
-}
+        if (p[i] == '\\' && ++i >= len)
+            break;
 
-extern "C"
-bool
-orcRecheckForeignScan(ForeignScanState *node, TupleTableSlot *slot)
-{
-    return true;
+        prefix.push_back(p[i]);
+    }
+
+    return prefix;
 }
 
 /*
- * orcExplainForeignScan
- *    Put out ORC file reading specific details here
+ * setSearchArgument
+ *    Evaluates the pushdown values and sets the search argument in row
+ *    reader options. The ORC reader uses it to skip stripes and row
+ *    groups by statistics and bloom filters. NULL values can't match
+ *    anything, so these are left out; the local recheck handles them.
+ *    Returns false if no predicate could be set.
  */
-extern "C"
-void
-orcExplainForeignScan(ForeignScanState *node, ExplainState *es)
+static
+bool
+setSearchArgument(OrcFdwExecState *fdw_estate, ExprContext *econtext)
 {
-    OrcFdwExecState *fdw_estate = (OrcFdwExecState *)node->fdw_state;
+    ORC_UNIQUE_PTR<orc::SearchArgumentBuilder> builder = orc::SearchArgumentFactory::newBuilder();
+    MemoryContext oldcxt = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+    ListCell *lc_pred;
+    ListCell *lc_expr;
+    int leaves = 0;
 
-    if (es->verbose)
+    fdw_estate->runtime_filters.clear();
+    fdw_estate->string_filters.clear();
+
+    builder->startAnd();
+
+    forboth(lc_pred, fdw_estate->pushdown, lc_expr, fdw_estate->pushdown_exprs)
     {
-        bool hasColumns = false;
-        std::stringstream ss;
+        List *pred = (List *) lfirst(lc_pred);
+        ExprState *expr_state = (ExprState *) lfirst(lc_expr);
+        std::string orcname(strVal(linitial(pred)));
+        OrcPushdownOp op = (OrcPushdownOp) intVal(lsecond(pred));
+        orc::PredicateDataType type = getPushdownType((Oid) intVal(lthird(pred)));
+        Oid valtype = exprType((Node *) expr_state->expr);
+        bool isnull;
+        Datum value = ExecEvalExpr(expr_state, econtext, &isnull);
+
+        if (isnull)
+            continue;
 
-        for (auto col = fdw_estate->cols_info.begin(); col != fdw_estate->cols_info.end(); col++)
+        if (op == ORC_PUSHDOWN_EQ)
         {
-            if (hasColumns)
-                ss << ", ";
+            builder->equals(orcname, type, getPushdownLiteral(value, valtype));
+            leaves++;
 
-            ss << (*col).name;
-            hasColumns = true;
+            /* Drops runs of other values of sorted keys in one step */
+            if (type == orc::PredicateDataType::LONG || type == orc::PredicateDataType::DATE)
+                addRangeFilter(fdw_estate, orcname, op, getPushdownLong(value, valtype));
+        }
+        else if (op == ORC_PUSHDOWN_PREFIX)
+        {
+            std::string prefix = getLikePrefix(value);
+            std::string upper = prefix;
+
+            if (prefix.empty())
+                continue;
+
+            /* Strings with the prefix sort by bytes from the prefix up to
+             * the prefix with its last byte incremented */
+            while (!upper.empty() && (unsigned char) upper.back() == 0xFF)
+                upper.pop_back();
+
+            if (upper.empty())
+            {
+                builder->startNot();
+                builder->lessThan(orcname, type, orc::Literal(prefix.data(), prefix.size()));
+                builder->end();
+            }
+            else
+            {
+                upper.back()++;
+                builder->between(orcname, type, orc::Literal(prefix.data(), prefix.size()), orc::Literal(upper.data(), upper.size()));
+            }
+
+            addStringFilter(fdw_estate, orcname, ORC_STRING_PREFIX, prefix);
+            leaves++;
+        }
+        else if (op != ORC_PUSHDOWN_IN)
+        {
+            orc::Literal literal = getPushdownLiteral(value, valtype);
+
+            /* ORC has no greater than; the NOT of a comparison skips
+             * NULLs as well */
+            switch (op)
+            {
+                case ORC_PUSHDOWN_LT:
+                    builder->lessThan(orcname, type, literal);
+                    break;
+                case ORC_PUSHDOWN_LE:
+                    builder->lessThanEquals(orcname, type, literal);
+                    break;
+                case ORC_PUSHDOWN_GT:
+                    builder->startNot();
+                    builder->lessThanEquals(orcname, type, literal);
+                    builder->end();
+                    break;
+                default:
+                    builder->startNot();
+                    builder->lessThan(orcname, type, literal);
+                    builder->end();
+                    break;
+            }
+
+            leaves++;
+
+            if (type == orc::PredicateDataType::LONG || type == orc::PredicateDataType::DATE)
+                addRangeFilter(fdw_estate, orcname, op, getPushdownLong(value, valtype));
+            else if (type == orc::PredicateDataType::STRING)
+            {
+                text *t = DatumGetTextPP(value);
+
+                addStringFilter(fdw_estate, orcname, (OrcStringFilterOp) (ORC_STRING_LT + (op - ORC_PUSHDOWN_LT)),
+                                std::string(VARDATA_ANY(t), VARSIZE_ANY_EXHDR(t)));
+            }
         }
+        else
+        {
+            ArrayType *arr = DatumGetArrayTypeP(value);
+            Oid elemtype = ARR_ELEMTYPE(arr);
+            int16 elmlen;
+            bool elmbyval;
+            char elmalign;
+            Datum *elems;
+            bool *nulls;
+            int nelems;
+            std::vector<orc::Literal> literals;
+
+            get_typlenbyvalalign(elemtype, &elmlen, &elmbyval, &elmalign);
+            deconstruct_array(arr, elemtype, elmlen, elmbyval, elmalign, &elems, &nulls, &nelems);
+
+            if ((type == orc::PredicateDataType::LONG || type == orc::PredicateDataType::DATE)
+                && nelems > ORC_RUNTIME_FILTER_MIN_VALUES)
+            {
+                std::vector<int64_t> values;
+
+                for (int i = 0; i < nelems; i++)
+                {
+                    if (!nulls[i])
+                        values.push_back(getPushdownLong(elems[i], elemtype));
+                }
+
+                if (values.empty() == false)
+                {
+                    int64_t min = *std::min_element(values.begin(), values.end());
+                    int64_t max = *std::max_element(values.begin(), values.end());
+
+                    /* The ORC reader skips stripes and row groups outside
+                     * the range of values */
+                    if (type == orc::PredicateDataType::DATE)
+                        builder->between(orcname, type, orc::Literal(type, min), orc::Literal(type, max));
+                    else
+                        builder->between(orcname, type, orc::Literal(min), orc::Literal(max));
+
+                    addRuntimeFilter(fdw_estate, orcname, values);
+                    leaves++;
+                }
 
-        ExplainPropertyText("ORC File Reader Columns", ss.str().c_str(), es);
+                continue;
+            }
+
+            for (int i = 0; i < nelems; i++)
+            {
+                if (!nulls[i])
+                    literals.push_back(getPushdownLiteral(elems[i], elemtype));
+            }
+
+            if (literals.empty() == false)
+            {
+                builder->in(orcname, type, literals);
+                leaves++;
+            }
+        }
     }
+
+    builder->end();
+
+    if (leaves > 0)
+        fdw_estate->rowReaderOptions.searchArgument(builder->build());
+    else
+        fdw_estate->rowReaderOptions.searchArgument(ORC_UNIQUE_PTR<orc::SearchArgument>());
+
+    MemoryContextSwitchTo(oldcxt);
+    ResetExprContext(econtext);
+
+    return (leaves > 0);
 }
 
 /*
- * orcBeginForeignScan
- *    ORC FDW function set in orc_fdw.c
+ * resetRowReader
+ *    Recreates the row reader with a search argument built from current
+ *    values of pushdown predicates. The reader and its parsed footer are
+ *    kept and so is the row batch as the selected type doesn't change.
  */
-extern "C"
+static
 void
-orcBeginForeignScan(ForeignScanState *node, int eflags)
+resetRowReader(OrcFdwExecState *fdw_estate, ExprContext *econtext)
 {
-    List *col_orc_file_index;
-    char *filename;
-    bool blnShouldSetRowReader = false;
-    int rtindex;
-	RangeTblEntry *rte;
-    OrcFdwExecState *fdw_estate;
-    ForeignScan *plan = castNode(ForeignScan, node->ss.ps.plan);
-    List *fdw_private = plan->fdw_private;
-    List *fdw_scan_tlist = plan->fdw_scan_tlist;
-    EState *estate = node->ss.ps.state;
-
-	if (plan->scan.scanrelid > 0)
-		rtindex = plan->scan.scanrelid;
-	else
-		rtindex = bms_next_member(plan->fs_relids, -1);
+    (void) setSearchArgument(fdw_estate, econtext);
+    (void) orcCreateRowReader(fdw_estate->reader, fdw_estate->rowReader, fdw_estate->rowReaderOptions);
 
-	rte = exec_rt_fetch(rtindex, estate);
-
-    filename = strVal((Value *) linitial(fdw_private));
-    col_orc_file_index = (List *) lsecond(fdw_private);
-    blnShouldSetRowReader = (bool)intVal((Value *)lthird(fdw_private));
-
-    /* Initialize and set execution state */
-    node->fdw_state = orcInitExecState(&fdw_estate, filename, col_orc_file_index, rte, fdw_scan_tlist, blnShouldSetRowReader);
+    fdw_estate->pushdown_pending = false;
+    orcSampleRestart(fdw_estate->sample);
+    fdw_estate->stats.curr_stripe = -1;
+    fdw_estate->curr_batch_total_rows = -1;
+    fdw_estate->curr_batch_number = 0;
+    fdw_estate->curr_batch_row_num = 0;
+    fdw_estate->curr_batch_sel_pos = 0;
+    fdw_estate->row_num = 0;
 }
 
 static
@@ -1154,7 +3223,14 @@ shouldReturnTuple(OrcFdwExecState *fdw_estate, List *node, Node *exprNode)
             {
                 Var *var = (Var *) curNode;
                 int col_index = fdw_estate->attr_orc_index[var->varattno - 1];
-                data = lappend(data, (void *) (getDatumForData(fdw_estate, fdw_estate->curr_batch_row_num, col_index, InvalidOid)));
+                bool isnull;
+                Datum value = getDatumForData(fdw_estate, fdw_estate->curr_batch_row_num, col_index, &isnull);
+
+                /* Leave NULLs to the server */
+                if (isnull)
+                    return BoolGetDatum(true);
+
+                data = lappend(data, (void *) value);
                 break;
             }
             case T_Const:
@@ -1227,32 +3303,116 @@ orcIterateForeignScan(ForeignScanState *node)
 
     ExecClearTuple(slot);
 
-    while (fdw_estate->row_num < fdw_estate->total_rows)
+    /* Replay rows cached by an earlier scan */
+    if (fdw_estate->rescan_cache_replay)
+    {
+        TupleTableSlot *cache_slot = fdw_estate->rescan_cache_slot;
+
+        if (tuplestore_gettupleslot(fdw_estate->rescan_cache, true, false, cache_slot))
+        {
+            /* The cache slot holds the tuple until the next call */
+            slot_getallattrs(cache_slot);
+            memcpy(slot->tts_values, cache_slot->tts_values, sizeof(Datum) * cache_slot->tts_nvalid);
+            memcpy(slot->tts_isnull, cache_slot->tts_isnull, sizeof(bool) * cache_slot->tts_nvalid);
+            ExecStoreVirtualTuple(slot);
+        }
+
+        return slot;
+    }
+
+    /* No column values are needed; rows come from the footer */
+    if (fdw_estate->zero_columns != ORC_ZERO_COLUMNS_NONE)
+        return nextFooterRow(fdw_estate, slot);
+
+    /* Search argument is set once values of pushdown predicates are known */
+    if (fdw_estate->pushdown_pending)
+        resetRowReader(fdw_estate, node->ss.ps.ps_ExprContext);
+
+    while (true)
     {
-        /* Do we need to fetch the next batch? */
-        if (fdw_estate->curr_batch_total_rows == -1
-            || (fdw_estate->row_num % fdw_estate->batch->numElements) == 0)
+        /* Do we need to fetch the next batch? Row groups skipped by the
+         * search argument never reach the batch, so rows are counted per
+         * batch rather than against the file total. */
+        if (fdw_estate->curr_batch_sel_pos >= fdw_estate->curr_batch_total_rows)
         {
+            uint64_t start = orcClockNs();
+            bool hasRows = orcSampleSeek(fdw_estate->sample, fdw_estate->rowReader->get())
+                            && (*fdw_estate->rowReader)->next(**(fdw_estate->batch));
+
+            fdw_estate->stats.next_ns += orcClockNs() - start;
+
             /* If next fails, we've reached the end. */
-            if (! fdw_estate->rowReader->next(*(fdw_estate->batch)))
+            if (! hasRows)
+            {
+                orcScanStatsEnd(fdw_estate->stats);
+                fdw_estate->rescan_cache_complete = (fdw_estate->rescan_cache != NULL);
                 return slot;
+            }
 
-            fdw_estate->batch_data = dynamic_cast<orc::StructVectorBatch *>(fdw_estate->batch.get());
+            orcScanStatsBatch(fdw_estate->stats, (*fdw_estate->rowReader)->getRowNumber(), (*fdw_estate->batch)->numElements);
+
+            fdw_estate->batch_data = dynamic_cast<orc::StructVectorBatch *>(fdw_estate->batch->get());
             fdw_estate->curr_batch_number++;
-            fdw_estate->curr_batch_row_num = 0;
-            fdw_estate->curr_batch_total_rows = fdw_estate->batch->numElements;
+            fdw_estate->curr_batch_sel_pos = 0;
+
+            /* Values staged for the previous batch are gone */
+            MemoryContextReset(fdw_estate->batch_cxt);
+
+            for (auto col = fdw_estate->cols_info.begin(); col != fdw_estate->cols_info.end(); col++)
+                (*col).batch_staged = false;
+
+            /* Drop rows that can't pass runtime filters for the whole batch */
+            fdw_estate->curr_batch_has_sel = !(fdw_estate->runtime_filters.empty() && fdw_estate->string_filters.empty());
+
+            if (!fdw_estate->curr_batch_has_sel)
+                fdw_estate->curr_batch_total_rows = (*fdw_estate->batch)->numElements;
+            else
+                fdw_estate->curr_batch_total_rows = orcApplyRuntimeFilters(fdw_estate->runtime_filters, fdw_estate->string_filters, fdw_estate->batch_data, fdw_estate->curr_batch_sel);
+
+            /* Then rows not sampled */
+            if (fdw_estate->sample.method != ORC_SAMPLE_NONE)
+            {
+                fdw_estate->curr_batch_total_rows = orcSampleBatch(fdw_estate->sample,
+                                                                   (*fdw_estate->rowReader)->getRowNumber(),
+                                                                   (*fdw_estate->batch)->numElements,
+                                                                   fdw_estate->curr_batch_sel,
+                                                                   fdw_estate->curr_batch_total_rows,
+                                                                   fdw_estate->curr_batch_has_sel);
+                fdw_estate->curr_batch_has_sel = true;
+            }
+
+            fdw_estate->stats.rows_filtered += (*fdw_estate->batch)->numElements - fdw_estate->curr_batch_total_rows;
+
+            continue;
         }
 
+        /* Position on the next candidate row */
+        if (!fdw_estate->curr_batch_has_sel)
+            fdw_estate->curr_batch_row_num = fdw_estate->curr_batch_sel_pos;
+        else
+            fdw_estate->curr_batch_row_num = fdw_estate->curr_batch_sel[fdw_estate->curr_batch_sel_pos];
+
+        fdw_estate->curr_batch_sel_pos++;
+        fdw_estate->row_num++;
+
+        uint64_t start = orcClockNs();
+
         /* Found a tuple that we should return */
         if (DatumGetBool(shouldReturnTuple(fdw_estate, node->ss.ps.plan->qual, NULL)) == true)
         {
             /* Store virtual tuple with details in slot */
             ExecStoreVirtualTuple(fillSlot(fdw_estate, slot));
+
+            fdw_estate->stats.convert_ns += orcClockNs() - start;
+            fdw_estate->stats.rows_returned++;
+
+            if (fdw_estate->rescan_cache != NULL)
+                tuplestore_puttupleslot(fdw_estate->rescan_cache, slot);
+
             break;
         }
 
-        fdw_estate->curr_batch_row_num++;
-        fdw_estate->row_num++;
+        fdw_estate->stats.convert_ns += orcClockNs() - start;
     }
 
     return slot;
@@ -1268,16 +3428,96 @@ orcReScanForeignScan(ForeignScanState *node)
 {
     OrcFdwExecState *fdw_estate = (OrcFdwExecState *)(node->fdw_state);
 
+    fdw_estate->stats.scans++;
+
+    /* Rows without values are made again; there is nothing to cache */
+    if (fdw_estate->zero_columns != ORC_ZERO_COLUMNS_NONE)
+    {
+        orcSampleRestart(fdw_estate->sample);
+        fdw_estate->row_num = 0;
+        return;
+    }
+
+    /* Replay from the cache if it has all rows for current parameters */
+    if (rescanFromCache(fdw_estate, node))
+        return;
+
+    /* Parameters of pushdown predicates changed; the search argument must
+     * be rebuilt before the next fetch. */
+    if (fdw_estate->pushdown != NIL && node->ss.ps.chgParam != NULL)
+    {
+        fdw_estate->pushdown_pending = true;
+        return;
+    }
+
     /* Reset all counters and state variables */
-    fdw_estate->rowReader->seekToRow(0);
-    fdw_estate->batch = fdw_estate->rowReader->createRowBatch(fdw_estate->batchsize);
-    fdw_estate->batch_data = dynamic_cast<orc::StructVectorBatch *>(fdw_estate->batch.get());
+    (*fdw_estate->rowReader)->seekToRow(0);
+    orcSampleRestart(fdw_estate->sample);
+    fdw_estate->stats.curr_stripe = -1;
+    *fdw_estate->batch = (*fdw_estate->rowReader)->createRowBatch(fdw_estate->batchsize);
+    fdw_estate->batch_data = dynamic_cast<orc::StructVectorBatch *>(fdw_estate->batch->get());
     fdw_estate->curr_batch_total_rows = -1;
     fdw_estate->curr_batch_number = 0;
     fdw_estate->curr_batch_row_num = 0;
+    fdw_estate->curr_batch_sel_pos = 0;
     fdw_estate->row_num = 0;
 }
 
+/*
+ * rescanFromCache
+ *    Rows returned by the scan only depend on parameters through pushdown
+ *    predicates; the remaining quals are checked by the executor. So the
+ *    cache is valid for rescans unless those parameters change or the
+ *    earlier scan was stopped before the end. Returns true if the rescan
+ *    replays the cache; otherwise the cache is emptied to be filled again.
+ */
+static
+bool
+rescanFromCache(OrcFdwExecState *fdw_estate, ForeignScanState *node)
+{
+    if (fdw_estate->rescan_cache == NULL)
+        return false;
+
+    if (fdw_estate->rescan_cache_complete
+        && (fdw_estate->pushdown == NIL || node->ss.ps.chgParam == NULL))
+    {
+        tuplestore_rescan(fdw_estate->rescan_cache);
+        fdw_estate->rescan_cache_replay = true;
+        return true;
+    }
+
+    tuplestore_clear(fdw_estate->rescan_cache);
+    fdw_estate->rescan_cache_complete = false;
+    fdw_estate->rescan_cache_replay = false;
+
+    return false;
+}
+
+/*
+ * reportScanStats
+ *    Adds counters of the scan to pg_stat_orc_fdw; done once per scan to
+ *    keep lock traffic low.
+ */
+static
+void
+reportScanStats(OrcFdwExecState *fdw_estate)
+{
+    OrcFdwScanStats &stats = fdw_estate->stats;
+    OrcStatsCounters counters;
+
+    counters.scans = stats.scans;
+    counters.rows_returned = stats.rows_returned;
+    counters.rows_filtered = stats.rows_filtered;
+    counters.stripes_read = stats.stripes_read;
+    counters.stripes_skipped = stats.stripes_skipped;
+    counters.bytes_read = stats.bytes_read;
+    counters.io_time = stats.io_ns / 1000000.0;
+    counters.decode_time = getDecodeNs(fdw_estate) / 1000000.0;
+    counters.metadata_cache_hits = fdw_estate->stats.reader_pool_hits;
+
+    orcStatsReport(fdw_estate->relid, fdw_estate->filename.c_str(), &counters);
+}
+
 /*
  * orcEndForeignScan
  *    ORC FDW function set in orc_fdw.c
@@ -1290,18 +3530,20 @@ orcEndForeignScan(ForeignScanState *node)
 
     if (fdw_estate != NULL)
     {
-        if (fdw_estate->is_valid_reader)
-        {
-            if (fdw_estate->batch)
-                fdw_estate->batch.reset();
+        if (fdw_estate->report_stats)
+            reportScanStats(fdw_estate);
 
-            if (fdw_estate->rowReader)
-                fdw_estate->rowReader.reset();
-
-            if (fdw_estate->reader)
-                fdw_estate->reader.reset();
+        if (fdw_estate->rescan_cache != NULL)
+        {
+            tuplestore_end(fdw_estate->rescan_cache);
+            ExecDropSingleTupleTableSlot(fdw_estate->rescan_cache_slot);
         }
 
+        /* Back to the pool with the file open; the row reader and batch
+         * are destroyed */
+        if (fdw_estate->is_valid_reader)
+            orcReaderPoolCheckin(fdw_estate->pooled_reader);
+
         delete fdw_estate;
     }
 }
@@ -0,0 +1,301 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_kernels.cpp
+ *    Kernels packing ORC column vectors into Datums and NULL flags.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ *    A kernel fills the Datums of a whole column vector in one pass. With
+ *    64 bit pass by value Datums, the Datum of an in range int2, int4 or
+ *    int8 value is its int64 value sign extended, so integer columns are
+ *    copied as is; booleans, dates and floats need one vector operation
+ *    per value. AVX2 versions are used when the CPU has AVX2; the scalar
+ *    versions are used otherwise and for the last few rows.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    src/orc_kernels.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+/* ORC FDW header files */
+#include <orc_kernels.h>
+
+/* PostgreSQL header files */
+extern "C"
+{
+    #include "utils/date.h"
+    #include "utils/timestamp.h"
+}
+
+/* AVX2 kernels are compiled for x86-64 and picked at runtime */
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) \
+    && SIZEOF_DATUM == 8 && defined(USE_FLOAT8_BYVAL)
+#define ORC_KERNELS_AVX2 1
+#include <immintrin.h>
+#endif
+
+
+/* Declare the functions to use within this file */
+static void packDatumsScalar(OrcFdwPackKind kind, orc::ColumnVectorBatch *field, uint64_t first, uint64_t start, uint64_t rows, Datum *values);
+static void expandNullsScalar(const char *notNull, uint64_t start, uint64_t rows, char *isnull);
+#ifdef ORC_KERNELS_AVX2
+static uint64_t packDatumsAvx2(OrcFdwPackKind kind, orc::ColumnVectorBatch *field, uint64_t first, uint64_t rows, Datum *values);
+static uint64_t expandNullsAvx2(const char *notNull, uint64_t rows, char *isnull);
+#endif
+
+
+/*
+ * orcKernelsUseAvx2
+ *    Returns true if the AVX2 kernels are used; checked once.
+ */
+bool
+orcKernelsUseAvx2(void)
+{
+#ifdef ORC_KERNELS_AVX2
+    static int use_avx2 = -1;
+
+    if (use_avx2 < 0)
+        use_avx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+
+    return (use_avx2 == 1);
+#else
+    return false;
+#endif
+}
+
+/*
+ * orcPackDatums
+ *    Packs the first rows of a column vector into Datums. Values of NULL
+ *    rows are packed as well; they are ignored with their NULL flags.
+ */
+void
+orcPackDatums(OrcFdwPackKind kind, orc::ColumnVectorBatch *field, uint64_t rows, Datum *values)
+{
+    orcPackDatumRange(kind, field, 0, rows, values);
+}
+
+/*
+ * orcPackDatumRange
+ *    Packs rows of a column vector starting at first into Datums; e.g. the
+ *    elements of a list, which are a range of the child vector.
+ */
+void
+orcPackDatumRange(OrcFdwPackKind kind, orc::ColumnVectorBatch *field, uint64_t first, uint64_t rows, Datum *values)
+{
+    uint64_t start = 0;
+
+#ifdef ORC_KERNELS_AVX2
+    if (orcKernelsUseAvx2())
+        start = packDatumsAvx2(kind, field, first, rows, values);
+#endif
+
+    packDatumsScalar(kind, field, first, start, rows, values);
+}
+
+/*
+ * orcExpandNulls
+ *    Sets the NULL flags of the first rows from the notNull bitmap of a
+ *    column vector; one byte per row in either.
+ */
+void
+orcExpandNulls(const char *notNull, uint64_t rows, char *isnull)
+{
+    uint64_t start = 0;
+
+#ifdef ORC_KERNELS_AVX2
+    if (orcKernelsUseAvx2())
+        start = expandNullsAvx2(notNull, rows, isnull);
+#endif
+
+    expandNullsScalar(notNull, start, rows, isnull);
+}
+
+static
+void
+packDatumsScalar(OrcFdwPackKind kind, orc::ColumnVectorBatch *field, uint64_t first, uint64_t start, uint64_t rows, Datum *values)
+{
+    uint64_t row;
+
+    switch (kind)
+    {
+        case ORC_PACK_INT2:
+        {
+            const int64_t *data = static_cast<orc::LongVectorBatch *>(field)->data.data() + first;
+
+            for (row = start; row < rows; row++)
+                values[row] = Int16GetDatum((int16) data[row]);
+            break;
+        }
+        case ORC_PACK_INT4:
+        {
+            const int64_t *data = static_cast<orc::LongVectorBatch *>(field)->data.data() + first;
+
+            for (row = start; row < rows; row++)
+                values[row] = Int32GetDatum((int32) data[row]);
+            break;
+        }
+        case ORC_PACK_INT8:
+        {
+            const int64_t *data = static_cast<orc::LongVectorBatch *>(field)->data.data() + first;
+
+            for (row = start; row < rows; row++)
+                values[row] = Int64GetDatum(data[row]);
+            break;
+        }
+        case ORC_PACK_BOOL:
+        {
+            const int64_t *data = static_cast<orc::LongVectorBatch *>(field)->data.data() + first;
+
+            for (row = start; row < rows; row++)
+                values[row] = BoolGetDatum(data[row] != 0);
+            break;
+        }
+        case ORC_PACK_DATE:
+        {
+            const int64_t *data = static_cast<orc::LongVectorBatch *>(field)->data.data() + first;
+
+            for (row = start; row < rows; row++)
+                values[row] = DateADTGetDatum((DateADT) (data[row] + (UNIX_EPOCH_JDATE - POSTGRES_EPOCH_JDATE)));
+            break;
+        }
+        case ORC_PACK_FLOAT4:
+        {
+            const double *data = static_cast<orc::DoubleVectorBatch *>(field)->data.data() + first;
+
+            for (row = start; row < rows; row++)
+                values[row] = Float4GetDatum((float4) data[row]);
+            break;
+        }
+        case ORC_PACK_FLOAT8:
+        {
+            const double *data = static_cast<orc::DoubleVectorBatch *>(field)->data.data() + first;
+
+            for (row = start; row < rows; row++)
+                values[row] = Float8GetDatum(data[row]);
+            break;
+        }
+        case ORC_PACK_NONE:
+        default:
+            break;
+    }
+}
+
+static
+void
+expandNullsScalar(const char *notNull, uint64_t start, uint64_t rows, char *isnull)
+{
+    uint64_t row;
+
+    for (row = start; row < rows; row++)
+        isnull[row] = (notNull[row] == 0);
+}
+
+#ifdef ORC_KERNELS_AVX2
+
+/*
+ * packDatumsAvx2
+ *    Packs four rows at a time; returns the number of rows packed.
+ */
+__attribute__((target("avx2")))
+static
+uint64_t
+packDatumsAvx2(OrcFdwPackKind kind, orc::ColumnVectorBatch *field, uint64_t first, uint64_t rows, Datum *values)
+{
+    uint64_t row = 0;
+
+    switch (kind)
+    {
+        /* In range values have the Datum of their int64 value */
+        case ORC_PACK_INT2:
+        case ORC_PACK_INT4:
+        case ORC_PACK_INT8:
+        {
+            const int64_t *data = static_cast<orc::LongVectorBatch *>(field)->data.data() + first;
+
+            for (; row + 4 <= rows; row += 4)
+                _mm256_storeu_si256((__m256i *) &values[row], _mm256_loadu_si256((const __m256i *) &data[row]));
+            break;
+        }
+        case ORC_PACK_BOOL:
+        {
+            const int64_t *data = static_cast<orc::LongVectorBatch *>(field)->data.data() + first;
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i one = _mm256_set1_epi64x(1);
+
+            for (; row + 4 <= rows; row += 4)
+            {
+                __m256i v = _mm256_loadu_si256((const __m256i *) &data[row]);
+
+                _mm256_storeu_si256((__m256i *) &values[row], _mm256_andnot_si256(_mm256_cmpeq_epi64(v, zero), one));
+            }
+            break;
+        }
+        case ORC_PACK_DATE:
+        {
+            const int64_t *data = static_cast<orc::LongVectorBatch *>(field)->data.data() + first;
+            const __m256i epoch = _mm256_set1_epi64x(UNIX_EPOCH_JDATE - POSTGRES_EPOCH_JDATE);
+
+            for (; row + 4 <= rows; row += 4)
+            {
+                __m256i v = _mm256_loadu_si256((const __m256i *) &data[row]);
+
+                _mm256_storeu_si256((__m256i *) &values[row], _mm256_add_epi64(v, epoch));
+            }
+            break;
+        }
+        /* Float4GetDatum sign extends the bits of the float */
+        case ORC_PACK_FLOAT4:
+        {
+            const double *data = static_cast<orc::DoubleVectorBatch *>(field)->data.data() + first;
+
+            for (; row + 4 <= rows; row += 4)
+            {
+                __m128 f = _mm256_cvtpd_ps(_mm256_loadu_pd(&data[row]));
+
+                _mm256_storeu_si256((__m256i *) &values[row], _mm256_cvtepi32_epi64(_mm_castps_si128(f)));
+            }
+            break;
+        }
+        case ORC_PACK_FLOAT8:
+        {
+            const double *data = static_cast<orc::DoubleVectorBatch *>(field)->data.data() + first;
+
+            for (; row + 4 <= rows; row += 4)
+                _mm256_storeu_pd((double *) &values[row], _mm256_loadu_pd(&data[row]));
+            break;
+        }
+        case ORC_PACK_NONE:
+        default:
+            break;
+    }
+
+    return row;
+}
+
+/*
+ * expandNullsAvx2
+ *    Sets 32 NULL flags at a time; returns the number of rows set.
+ */
+__attribute__((target("avx2")))
+static
+uint64_t
+expandNullsAvx2(const char *notNull, uint64_t rows, char *isnull)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+    uint64_t row = 0;
+
+    for (; row + 32 <= rows; row += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *) &notNull[row]);
+
+        _mm256_storeu_si256((__m256i *) &isnull[row], _mm256_and_si256(_mm256_cmpeq_epi8(v, zero), one));
+    }
+
+    return row;
+}
+
+#endif
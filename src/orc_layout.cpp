@@ -0,0 +1,503 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_layout.cpp
+ *    Sorting rows before they're written and measuring how well stripes
+ *    of a file can be skipped.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ *    Stripe and row group statistics only skip data if the values of a
+ *    column are clustered. With sort_by, the rows of an INSERT are sorted
+ *    on the columns before they're written. With cluster_by, rows are
+ *    sorted on the z-order of two or three columns, which keeps ranges of
+ *    each column narrow at once: rows are kept in a tuplestore while the
+ *    range of each column is found, then each value is scaled to the
+ *    column's range and the bits of the columns are interleaved into a
+ *    key. Both sorts use tuplesort and spill to disk beyond work_mem.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    src/orc_layout.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+/* ORC FDW header files */
+#include <orc_layout.h>
+#include <orc_wrapper.h>
+
+/* PostgreSQL and FDW header files */
+extern "C"
+{
+    #include "orc_fdw.h"
+    #include "funcapi.h"
+    #include "miscadmin.h"
+    #include "access/tupdesc.h"
+    #include "catalog/pg_operator.h"
+    #include "catalog/pg_type.h"
+    #include "utils/builtins.h"
+    #include "utils/date.h"
+    #include "utils/memutils.h"
+    #include "utils/timestamp.h"
+    #include "utils/tuplesort.h"
+    #include "utils/tuplestore.h"
+    #include "utils/typcache.h"
+
+    PG_FUNCTION_INFO_V1(orc_file_prunability);
+}
+
+
+/* Number of output columns of orc_file_prunability */
+#define ORC_PRUNABILITY_COLS 4
+
+/* Flips the sign bit so that signed values compare as unsigned */
+#define ORC_SIGN_BIT (UINT64CONST(1) << 63)
+
+
+struct OrcFdwSortState
+{
+    /* Rows written, sorted on sort_by or cluster_by columns */
+    TupleDesc tupdesc;
+    Tuplesortstate *sort;
+
+    /* cluster_by: rows until the range of each column is known */
+    Tuplestorestate *input;
+    int nkeys;
+    int keys[ORC_MAX_CLUSTER_COLUMNS];
+    uint64 min[ORC_MAX_CLUSTER_COLUMNS];
+    uint64 max[ORC_MAX_CLUSTER_COLUMNS];
+
+    /* Memory of the keys of a row, such as numerics cast to float8 */
+    MemoryContext key_cxt;
+};
+
+
+/* Declare the functions to use within this file */
+static int findAttribute(TupleDesc tupdesc, const char *name);
+static bool isClusterType(Oid typid);
+static uint64 getClusterKey(Oid typid, Datum value);
+static int64 getZValue(OrcFdwSortState *state, TupleTableSlot *slot);
+extern "C" Datum orc_file_prunability(PG_FUNCTION_ARGS);
+
+
+/*
+ * findAttribute
+ *    Returns the index of the attribute with a name.
+ */
+static
+int
+findAttribute(TupleDesc tupdesc, const char *name)
+{
+    for (int i = 0; i < tupdesc->natts; i++)
+    {
+        Form_pg_attribute attr = TupleDescAttr(tupdesc, i);
+
+        if (!attr->attisdropped && strcmp(NameStr(attr->attname), name) == 0)
+            return i;
+    }
+
+    ereport(ERROR,
+            (errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+             errmsg("%s: sort column %s is not in the table.", ORC_FDW_NAME, name)));
+
+    return -1;
+}
+
+/*
+ * isClusterType
+ *    Returns true for types getClusterKey can map.
+ */
+static
+bool
+isClusterType(Oid typid)
+{
+    switch (typid)
+    {
+        case BOOLOID:
+        case INT2OID:
+        case INT4OID:
+        case INT8OID:
+        case DATEOID:
+        case TIMESTAMPOID:
+        case FLOAT4OID:
+        case FLOAT8OID:
+        case NUMERICOID:
+        case TEXTOID:
+        case VARCHAROID:
+        case BPCHAROID:
+        case BYTEAOID:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*
+ * getClusterKey
+ *    Maps a value to an unsigned integer of the same order. Strings are
+ *    ordered by their first 8 bytes, which is enough to cluster them.
+ */
+static
+uint64
+getClusterKey(Oid typid, Datum value)
+{
+    switch (typid)
+    {
+        case BOOLOID:
+            return DatumGetBool(value);
+        case INT2OID:
+            return (uint64) (int64) DatumGetInt16(value) ^ ORC_SIGN_BIT;
+        case INT4OID:
+            return (uint64) (int64) DatumGetInt32(value) ^ ORC_SIGN_BIT;
+        case DATEOID:
+            return (uint64) (int64) DatumGetDateADT(value) ^ ORC_SIGN_BIT;
+        case INT8OID:
+            return (uint64) DatumGetInt64(value) ^ ORC_SIGN_BIT;
+        case TIMESTAMPOID:
+            return (uint64) DatumGetTimestamp(value) ^ ORC_SIGN_BIT;
+        case FLOAT4OID:
+        case FLOAT8OID:
+        case NUMERICOID:
+        {
+            double d;
+            uint64 bits;
+
+            if (typid == FLOAT4OID)
+                d = DatumGetFloat4(value);
+            else if (typid == FLOAT8OID)
+                d = DatumGetFloat8(value);
+            else
+                d = DatumGetFloat8(DirectFunctionCall1(numeric_float8, value));
+
+            /* Negative values compare in reverse */
+            memcpy(&bits, &d, sizeof(bits));
+            return (bits & ORC_SIGN_BIT) ? ~bits : (bits | ORC_SIGN_BIT);
+        }
+        default:
+        {
+            struct varlena *v = pg_detoast_datum_packed((struct varlena *) DatumGetPointer(value));
+            const unsigned char *data = (const unsigned char *) VARDATA_ANY(v);
+            int len = Min((int) VARSIZE_ANY_EXHDR(v), (int) sizeof(uint64));
+            uint64 key = 0;
+
+            for (int i = 0; i < (int) sizeof(uint64); i++)
+                key = (key << 8) | ((i < len) ? data[i] : 0);
+
+            if ((Pointer) v != DatumGetPointer(value))
+                pfree(v);
+
+            return key;
+        }
+    }
+}
+
+/*
+ * getZValue
+ *    Scales the cluster_by values of a row to their ranges and interleaves
+ *    their bits, most significant first. NULLs sort first.
+ */
+static
+int64
+getZValue(OrcFdwSortState *state, TupleTableSlot *slot)
+{
+    /* At most 63 bits, so the key sorts as a positive int8 */
+    int bits = 63 / state->nkeys;
+    uint64 scaled[ORC_MAX_CLUSTER_COLUMNS];
+    uint64 z = 0;
+    MemoryContext oldcontext = MemoryContextSwitchTo(state->key_cxt);
+
+    for (int i = 0; i < state->nkeys; i++)
+    {
+        int attnum = state->keys[i];
+        uint64 range = state->max[i] - state->min[i];
+        uint64 key;
+
+        scaled[i] = 0;
+
+        if (slot->tts_isnull[attnum] || range == 0)
+            continue;
+
+        key = getClusterKey(TupleDescAttr(state->tupdesc, attnum)->atttypid, slot->tts_values[attnum]);
+        scaled[i] = (uint64) ((double) (key - state->min[i]) / (double) range * (double) ((UINT64CONST(1) << bits) - 1));
+    }
+
+    MemoryContextSwitchTo(oldcontext);
+    MemoryContextReset(state->key_cxt);
+
+    for (int bit = bits - 1; bit >= 0; bit--)
+    {
+        for (int i = 0; i < state->nkeys; i++)
+            z = (z << 1) | ((scaled[i] >> bit) & 1);
+    }
+
+    return (int64) z;
+}
+
+/*
+ * orcBeginSort
+ *    Starts sorting rows of a table with sort_by or cluster_by set;
+ *    returns NULL if neither is.
+ */
+OrcFdwSortState *
+orcBeginSort(TupleDesc tupdesc, const OrcFdwWriteOptions *options)
+{
+    OrcFdwSortState *state;
+    ListCell *lc;
+
+    if (options->sort_by == NIL && options->cluster_by == NIL)
+        return NULL;
+
+    if (options->sort_by != NIL && options->cluster_by != NIL)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+                 errmsg("%s: sort_by and cluster_by can't be used together.", ORC_FDW_NAME)));
+    }
+
+    state = (OrcFdwSortState *) palloc0(sizeof(OrcFdwSortState));
+    state->tupdesc = tupdesc;
+
+    if (options->sort_by != NIL)
+    {
+        int nkeys = list_length(options->sort_by);
+        AttrNumber *attNums = (AttrNumber *) palloc(nkeys * sizeof(AttrNumber));
+        Oid *sortOperators = (Oid *) palloc(nkeys * sizeof(Oid));
+        Oid *sortCollations = (Oid *) palloc(nkeys * sizeof(Oid));
+        bool *nullsFirstFlags = (bool *) palloc(nkeys * sizeof(bool));
+        int i = 0;
+
+        foreach(lc, options->sort_by)
+        {
+            int attnum = findAttribute(tupdesc, (const char *) lfirst(lc));
+            Form_pg_attribute attr = TupleDescAttr(tupdesc, attnum);
+            TypeCacheEntry *typentry = lookup_type_cache(attr->atttypid, TYPECACHE_LT_OPR);
+
+            if (!OidIsValid(typentry->lt_opr))
+            {
+                ereport(ERROR,
+                        (errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+                         errmsg("%s: column %s can't be sorted.", ORC_FDW_NAME, NameStr(attr->attname))));
+            }
+
+            attNums[i] = attnum + 1;
+            sortOperators[i] = typentry->lt_opr;
+            sortCollations[i] = attr->attcollation;
+            nullsFirstFlags[i] = false;
+            i++;
+        }
+
+        state->sort = tuplesort_begin_heap(tupdesc, nkeys, attNums, sortOperators, sortCollations, nullsFirstFlags, work_mem, NULL, false);
+    }
+    else
+    {
+        foreach(lc, options->cluster_by)
+        {
+            int attnum = findAttribute(tupdesc, (const char *) lfirst(lc));
+            Form_pg_attribute attr = TupleDescAttr(tupdesc, attnum);
+
+            if (!isClusterType(attr->atttypid))
+            {
+                ereport(ERROR,
+                        (errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+                         errmsg("%s: column %s of type %s can't be used in cluster_by.", ORC_FDW_NAME, NameStr(attr->attname), format_type_be(attr->atttypid))));
+            }
+
+            state->keys[state->nkeys] = attnum;
+            state->min[state->nkeys] = PG_UINT64_MAX;
+            state->max[state->nkeys] = 0;
+            state->nkeys++;
+        }
+
+        state->input = tuplestore_begin_heap(false, false, work_mem);
+        state->key_cxt = AllocSetContextCreate(CurrentMemoryContext,
+                                               "orc_fdw cluster keys",
+                                               ALLOCSET_DEFAULT_SIZES);
+    }
+
+    return state;
+}
+
+/*
+ * orcSortPutSlot
+ *    Adds a row to be sorted.
+ */
+void
+orcSortPutSlot(OrcFdwSortState *state, TupleTableSlot *slot)
+{
+    MemoryContext oldcontext;
+
+    if (state->input == NULL)
+    {
+        tuplesort_puttupleslot(state->sort, slot);
+        return;
+    }
+
+    slot_getallattrs(slot);
+    oldcontext = MemoryContextSwitchTo(state->key_cxt);
+
+    for (int i = 0; i < state->nkeys; i++)
+    {
+        int attnum = state->keys[i];
+        uint64 key;
+
+        if (slot->tts_isnull[attnum])
+            continue;
+
+        key = getClusterKey(TupleDescAttr(state->tupdesc, attnum)->atttypid, slot->tts_values[attnum]);
+        state->min[i] = Min(state->min[i], key);
+        state->max[i] = Max(state->max[i], key);
+    }
+
+    MemoryContextSwitchTo(oldcontext);
+    MemoryContextReset(state->key_cxt);
+
+    tuplestore_puttupleslot(state->input, slot);
+}
+
+/*
+ * orcSortFinish
+ *    Sorts the rows and adds them to the writer in order.
+ */
+void
+orcSortFinish(OrcFdwSortState *state, OrcFdwWriter *writer)
+{
+    TupleDesc sort_tupdesc = state->tupdesc;
+    TupleTableSlot *slot;
+
+    if (state->input != NULL)
+    {
+        int natts = state->tupdesc->natts;
+        AttrNumber attNum = natts + 1;
+        Oid sortOperator = Int8LessOperator;
+        Oid sortCollation = InvalidOid;
+        bool nullsFirst = false;
+        TupleTableSlot *input_slot = MakeSingleTupleTableSlot(state->tupdesc, &TTSOpsMinimalTuple);
+        TupleTableSlot *sort_slot;
+
+        /* Rows with their z-value as an extra attribute */
+        sort_tupdesc = CreateTemplateTupleDesc(natts + 1);
+
+        for (int i = 1; i <= natts; i++)
+            TupleDescCopyEntry(sort_tupdesc, i, state->tupdesc, i);
+
+        TupleDescInitEntry(sort_tupdesc, natts + 1, "orc_zvalue", INT8OID, -1, 0);
+
+        sort_slot = MakeSingleTupleTableSlot(sort_tupdesc, &TTSOpsVirtual);
+        state->sort = tuplesort_begin_heap(sort_tupdesc, 1, &attNum, &sortOperator, &sortCollation, &nullsFirst, work_mem, NULL, false);
+
+        while (tuplestore_gettupleslot(state->input, true, false, input_slot))
+        {
+            slot_getallattrs(input_slot);
+
+            ExecClearTuple(sort_slot);
+            memcpy(sort_slot->tts_values, input_slot->tts_values, natts * sizeof(Datum));
+            memcpy(sort_slot->tts_isnull, input_slot->tts_isnull, natts * sizeof(bool));
+            sort_slot->tts_values[natts] = Int64GetDatum(getZValue(state, input_slot));
+            sort_slot->tts_isnull[natts] = false;
+            ExecStoreVirtualTuple(sort_slot);
+
+            tuplesort_puttupleslot(state->sort, sort_slot);
+
+            CHECK_FOR_INTERRUPTS();
+        }
+
+        tuplestore_end(state->input);
+        state->input = NULL;
+        MemoryContextDelete(state->key_cxt);
+
+        ExecDropSingleTupleTableSlot(input_slot);
+        ExecDropSingleTupleTableSlot(sort_slot);
+    }
+
+    tuplesort_performsort(state->sort);
+
+    slot = MakeSingleTupleTableSlot(sort_tupdesc, &TTSOpsMinimalTuple);
+
+    while (tuplesort_gettupleslot(state->sort, true, false, slot, NULL))
+    {
+        /* The writer maps columns to the leading attributes */
+        slot_getallattrs(slot);
+        writer->addRow(slot->tts_values, slot->tts_isnull);
+
+        CHECK_FOR_INTERRUPTS();
+    }
+
+    tuplesort_end(state->sort);
+    state->sort = NULL;
+
+    ExecDropSingleTupleTableSlot(slot);
+}
+
+/*
+ * orc_file_prunability
+ *    Returns for each column of an ORC file how much the minimum and
+ *    maximum values of its stripes overlap; see OrcFdwStripeOverlap.
+ *    Columns of types without comparable statistics have NULLs.
+ */
+extern "C"
+Datum
+orc_file_prunability(PG_FUNCTION_ARGS)
+{
+    char *filename = text_to_cstring(PG_GETARG_TEXT_PP(0));
+    ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+    TupleDesc tupdesc;
+    Tuplestorestate *tupstore;
+    MemoryContext oldcontext;
+    orc::ReaderOptions options;
+    ORC_UNIQUE_PTR<orc::Reader> reader;
+
+    /* Check to see if caller supports us returning a tuplestore */
+    if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("%s: set-valued function called in context that cannot accept a set", ORC_FDW_NAME)));
+
+    if (!(rsinfo->allowedModes & SFRM_Materialize))
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("%s: materialize mode required, but it is not allowed in this context", ORC_FDW_NAME)));
+
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        elog(ERROR, "%s: return type must be a row type", ORC_FDW_NAME);
+
+    oldcontext = MemoryContextSwitchTo(rsinfo->econtext->ecxt_per_query_memory);
+
+    tupstore = tuplestore_begin_heap(true, false, work_mem);
+    rsinfo->returnMode = SFRM_Materialize;
+    rsinfo->setResult = tupstore;
+    rsinfo->setDesc = tupdesc;
+
+    MemoryContextSwitchTo(oldcontext);
+
+    (void) orcCreateReader(filename, &reader, options, false);
+
+    const orc::Type &type = reader->getType();
+
+    for (uint64_t i = 0; i < type.getSubtypeCount(); i++)
+    {
+        const orc::Type *field = type.getSubtype(i);
+        OrcFdwStripeOverlap overlap;
+        Datum values[ORC_PRUNABILITY_COLS];
+        bool nulls[ORC_PRUNABILITY_COLS];
+
+        memset(nulls, 0, sizeof(nulls));
+
+        values[0] = CStringGetTextDatum(type.getFieldName(i).c_str());
+
+        if (orcGetStripeOverlap(&reader, field->getColumnId(), field->getKind(), &overlap))
+        {
+            values[1] = Int64GetDatum(overlap.stripes);
+            values[2] = Float8GetDatum(overlap.overlap);
+            values[3] = Int64GetDatum(overlap.max_overlapping);
+        }
+        else
+        {
+            nulls[1] = nulls[2] = nulls[3] = true;
+        }
+
+        tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+    }
+
+    return (Datum) 0;
+}
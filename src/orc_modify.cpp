@@ -0,0 +1,1037 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_modify.cpp
+ *    INSERT into ORC foreign tables, and compaction and export of ORC
+ *    files.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ *    ORC files can't be appended to, so an INSERT writes a new file with
+ *    the rows of the table's file followed by the inserted rows. The new
+ *    file is written next to the table's file and renamed over it when
+ *    the transaction commits; it's removed if the transaction or the
+ *    subtransaction that wrote it aborts. Until then, other sessions and
+ *    scans in the same transaction read the committed file.
+ *
+ *    An empty file takes the columns of the table, so new ORC files are
+ *    created by pointing a table to an empty file and inserting into it.
+ *    orc_compact and orc_export write their files the same way.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    src/orc_modify.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+/* system header files */
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* C++ header files */
+#include <algorithm>
+#include <cerrno>
+#include <set>
+#include <string>
+#include <vector>
+
+/* ORC FDW header files */
+#include <orc_interface.h>
+#include <orc_interface_typedefs.h>
+#include <orc_layout.h>
+#include <orc_modify.h>
+#include <orc_writer.h>
+#include <orc_wrapper.h>
+
+/* PostgreSQL header files */
+extern "C"
+{
+    #include "orc_fdw.h"
+    #include "funcapi.h"
+    #include "miscadmin.h"
+    #include "access/reloptions.h"
+    #include "access/xact.h"
+    #include "commands/explain.h"
+    #include "executor/executor.h"
+    #include "executor/spi.h"
+    #include "nodes/makefuncs.h"
+    #include "storage/fd.h"
+    #include "storage/lmgr.h"
+    #include "utils/builtins.h"
+    #include "utils/guc.h"
+    #include "utils/jsonb.h"
+    #include "utils/memutils.h"
+    #include "utils/rel.h"
+    #include "utils/typcache.h"
+
+    PG_FUNCTION_INFO_V1(orc_compact);
+    PG_FUNCTION_INFO_V1(orc_export);
+}
+
+
+/* Number of output columns of orc_compact and orc_export */
+#define ORC_COMPACT_COLS 2
+#define ORC_EXPORT_COLS 2
+
+
+/*
+ * File written by the current transaction and the table's file it
+ * replaces at commit. The writer is set while the insert runs.
+ */
+struct OrcFdwPendingFile
+{
+    std::string filename;
+    std::string temp_filename;
+    SubTransactionId subid;
+    OrcFdwWriter *writer;
+};
+
+/*
+ * State of an INSERT kept in ri_FdwState. Rows go to the writer, or to
+ * the sort if the table has sort_by or cluster_by set.
+ */
+struct OrcFdwModifyState
+{
+    OrcFdwWriter *writer;
+    OrcFdwSortState *sort;
+
+    /* Rows inserted; sorted rows reach the writer at the end */
+    uint64_t rows;
+};
+
+/* Files written by the current transaction in the order written */
+static std::vector<OrcFdwPendingFile> pending_files;
+
+static bool xact_callbacks_registered = false;
+static uint32 temp_file_counter = 0;
+
+/* orc_fdw.write_workers */
+static int orc_write_workers = 0;
+
+
+/* Declare the functions to use within this file */
+static std::string addPendingFile(const std::string &filename);
+static OrcFdwModifyState *beginWrite(ResultRelInfo *rinfo);
+static void writeSlot(OrcFdwModifyState *state, TupleTableSlot *slot);
+static void finishWrite(OrcFdwWriter *writer, OrcFdwSortState *sort);
+static void endWrite(ResultRelInfo *rinfo);
+static List *getExportOptions(Jsonb *options);
+static std::string getPartFilename(const std::string &path, int part);
+static void removePendingFile(OrcFdwPendingFile &pending);
+static void orcXactCallback(XactEvent event, void *arg);
+static void orcSubXactCallback(SubXactEvent event, SubTransactionId mySubid, SubTransactionId parentSubid, void *arg);
+
+
+/*
+ * addPendingFile
+ *    Returns the name of a new file that replaces filename when the
+ *    transaction commits. It's written in the same folder so that the
+ *    rename is atomic.
+ */
+static
+std::string
+addPendingFile(const std::string &filename)
+{
+    std::string temp_filename;
+
+    if (!xact_callbacks_registered)
+    {
+        RegisterXactCallback(orcXactCallback, NULL);
+        RegisterSubXactCallback(orcSubXactCallback, NULL);
+        xact_callbacks_registered = true;
+    }
+
+    temp_filename = filename + "." + std::to_string(MyProcPid)
+                    + "." + std::to_string(++temp_file_counter) + ".tmp";
+
+    /* Known before the file is created so that an abort removes it */
+    pending_files.push_back({filename, temp_filename, GetCurrentSubTransactionId(), NULL});
+
+    return temp_filename;
+}
+
+/*
+ * beginWrite
+ *    Creates a writer for a new file of the table and copies the rows of
+ *    the table's file, or of the file written earlier in the transaction,
+ *    into it.
+ */
+static
+OrcFdwModifyState *
+beginWrite(ResultRelInfo *rinfo)
+{
+    Relation rel = rinfo->ri_RelationDesc;
+    Oid relid = RelationGetRelid(rel);
+    OrcFdwPlanState *fdw_state = (OrcFdwPlanState *) palloc0(sizeof(OrcFdwPlanState));
+    orc::ReaderOptions options;
+    ORC_UNIQUE_PTR<orc::Reader> reader;
+    ORC_UNIQUE_PTR<orc::Type> type;
+    std::string source;
+    std::string temp_filename;
+    struct stat stat_buf;
+    OrcFdwModifyState *state = (OrcFdwModifyState *) palloc0(sizeof(OrcFdwModifyState));
+    OrcFdwWriter *writer;
+
+    /* Concurrent writers would each replace the file without the rows of
+     * the other, so they wait for this transaction to end. Readers aren't
+     * blocked. */
+    LockRelationOid(relid, ShareRowExclusiveLock);
+
+    orcInitWriteOptions(&fdw_state->write_options);
+    (void) getTableOptionsFromRelID(relid, fdw_state);
+
+    fdw_state->write_options.workers = orc_write_workers;
+
+    source = fdw_state->filename;
+
+    for (auto pending = pending_files.rbegin(); pending != pending_files.rend(); pending++)
+    {
+        if (pending->filename.compare(fdw_state->filename) != 0)
+            continue;
+
+        if (pending->writer != NULL)
+        {
+            ereport(ERROR, (errmsg("%s: ORC file %s is already being written by this statement.", ORC_FDW_NAME, fdw_state->filename)));
+        }
+
+        source = pending->temp_filename;
+        break;
+    }
+
+    if (stat(source.c_str(), &stat_buf) != 0)
+    {
+        ereport(ERROR,
+                (errcode_for_file_access(),
+                 errmsg("%s: could not stat file \"%s\": %m", ORC_FDW_NAME, source.c_str())));
+    }
+
+    if (stat_buf.st_size == 0)
+        type = orcGetTypeForTupleDesc(RelationGetDescr(rel));
+    else
+        (void) orcCreateReader(source, &reader, options, false);
+
+    temp_filename = addPendingFile(fdw_state->filename);
+
+    writer = new OrcFdwWriter(temp_filename, (reader != NULL) ? reader->getType() : *type, RelationGetDescr(rel), fdw_state->write_options);
+    pending_files.back().writer = writer;
+
+    if (reader != NULL)
+    {
+        reader.reset();
+        writer->appendFile(source);
+    }
+
+    state->writer = writer;
+    state->sort = orcBeginSort(RelationGetDescr(rel), &fdw_state->write_options);
+
+    return state;
+}
+
+/*
+ * writeSlot
+ *    Adds the row in a slot to the file or to the sort.
+ */
+static
+void
+writeSlot(OrcFdwModifyState *state, TupleTableSlot *slot)
+{
+    state->rows++;
+
+    if (state->sort != NULL)
+    {
+        orcSortPutSlot(state->sort, slot);
+        return;
+    }
+
+    slot_getallattrs(slot);
+    state->writer->addRow(slot->tts_values, slot->tts_isnull);
+}
+
+/*
+ * endWrite
+ *    Completes the file; it's renamed when the transaction commits.
+ */
+static
+void
+endWrite(ResultRelInfo *rinfo)
+{
+    OrcFdwModifyState *state = (OrcFdwModifyState *) rinfo->ri_FdwState;
+
+    /* Nothing to do for EXPLAIN */
+    if (state == NULL)
+        return;
+
+    finishWrite(state->writer, state->sort);
+    rinfo->ri_FdwState = NULL;
+}
+
+/*
+ * finishWrite
+ *    Writes the sorted rows, if any, and completes the file of a writer.
+ */
+static
+void
+finishWrite(OrcFdwWriter *writer, OrcFdwSortState *sort)
+{
+    if (sort != NULL)
+        orcSortFinish(sort, writer);
+
+    writer->close();
+
+    for (auto pending = pending_files.begin(); pending != pending_files.end(); pending++)
+    {
+        if (pending->writer == writer)
+            pending->writer = NULL;
+    }
+
+    delete writer;
+}
+
+/*
+ * getExportOptions
+ *    Returns the options of orc_export, given as a JSON object, as a list
+ *    of DefElem with string values.
+ */
+static
+List *
+getExportOptions(Jsonb *options)
+{
+    JsonbIterator *it;
+    JsonbValue v;
+    JsonbIteratorToken r;
+    char *key = NULL;
+    List *result = NIL;
+
+    if (!JB_ROOT_IS_OBJECT(options))
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("%s: options must be a JSON object", ORC_FDW_NAME)));
+    }
+
+    it = JsonbIteratorInit(&options->root);
+
+    while ((r = JsonbIteratorNext(&it, &v, true)) != WJB_DONE)
+    {
+        char *value;
+
+        if (r == WJB_KEY)
+        {
+            key = pnstrdup(v.val.string.val, v.val.string.len);
+            continue;
+        }
+
+        if (r != WJB_VALUE)
+            continue;
+
+        switch (v.type)
+        {
+            case jbvString:
+                value = pnstrdup(v.val.string.val, v.val.string.len);
+                break;
+            case jbvNumeric:
+                value = DatumGetCString(DirectFunctionCall1(numeric_out, NumericGetDatum(v.val.numeric)));
+                break;
+            case jbvBool:
+                value = pstrdup(v.val.boolean ? "true" : "false");
+                break;
+            default:
+                ereport(ERROR,
+                        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                         errmsg("%s: option \"%s\" must be a string, number or boolean", ORC_FDW_NAME, key)));
+                return NIL;
+        }
+
+        result = lappend(result, makeDefElem(key, (Node *) makeString(value), -1));
+    }
+
+    return result;
+}
+
+/*
+ * getPartFilename
+ *    Returns the name of a file of a parallel export: the part number goes
+ *    before the extension, e.g. sales_2.orc.
+ */
+static
+std::string
+getPartFilename(const std::string &path, int part)
+{
+    size_t slash = path.rfind('/');
+    size_t dot = path.rfind('.');
+
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        dot = path.size();
+
+    return path.substr(0, dot) + "_" + std::to_string(part) + path.substr(dot);
+}
+
+/*
+ * removePendingFile
+ *    Closes and removes a file that won't replace the table's file.
+ */
+static
+void
+removePendingFile(OrcFdwPendingFile &pending)
+{
+    if (pending.writer != NULL)
+    {
+        delete pending.writer;
+        pending.writer = NULL;
+    }
+
+    if (unlink(pending.temp_filename.c_str()) != 0 && errno != ENOENT)
+    {
+        ereport(WARNING,
+                (errcode_for_file_access(),
+                 errmsg("%s: could not remove file \"%s\": %m", ORC_FDW_NAME, pending.temp_filename.c_str())));
+    }
+}
+
+/*
+ * orcXactCallback
+ *    Renames files written by the transaction over the tables' files
+ *    before commit; the last file written for a table has all its rows.
+ *    Files are removed on abort.
+ */
+static
+void
+orcXactCallback(XactEvent event, void *arg)
+{
+    switch (event)
+    {
+        case XACT_EVENT_PRE_COMMIT:
+        case XACT_EVENT_PARALLEL_PRE_COMMIT:
+        {
+            std::set<std::string> renamed;
+
+            /* A failed rename aborts the transaction, which removes the
+             * files not renamed yet */
+            while (!pending_files.empty())
+            {
+                OrcFdwPendingFile &pending = pending_files.back();
+
+                if (renamed.count(pending.filename) > 0)
+                {
+                    removePendingFile(pending);
+                }
+                else
+                {
+                    (void) durable_rename(pending.temp_filename.c_str(), pending.filename.c_str(), ERROR);
+                    renamed.insert(pending.filename);
+                }
+
+                pending_files.pop_back();
+            }
+
+            break;
+        }
+        case XACT_EVENT_PRE_PREPARE:
+        {
+            if (!pending_files.empty())
+            {
+                ereport(ERROR,
+                        (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                         errmsg("%s: cannot PREPARE a transaction that has inserted into ORC foreign tables", ORC_FDW_NAME)));
+            }
+
+            break;
+        }
+        case XACT_EVENT_ABORT:
+        case XACT_EVENT_PARALLEL_ABORT:
+        {
+            for (auto pending = pending_files.begin(); pending != pending_files.end(); pending++)
+                removePendingFile(*pending);
+
+            pending_files.clear();
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/*
+ * orcSubXactCallback
+ *    Removes files written by an aborted subtransaction; files of a
+ *    committed one now belong to its parent.
+ */
+static
+void
+orcSubXactCallback(SubXactEvent event, SubTransactionId mySubid, SubTransactionId parentSubid, void *arg)
+{
+    if (event == SUBXACT_EVENT_ABORT_SUB)
+    {
+        for (auto pending = pending_files.begin(); pending != pending_files.end(); )
+        {
+            if (pending->subid != mySubid)
+            {
+                pending++;
+                continue;
+            }
+
+            removePendingFile(*pending);
+            pending = pending_files.erase(pending);
+        }
+    }
+    else if (event == SUBXACT_EVENT_COMMIT_SUB)
+    {
+        for (auto pending = pending_files.begin(); pending != pending_files.end(); pending++)
+        {
+            if (pending->subid == mySubid)
+                pending->subid = parentSubid;
+        }
+    }
+}
+
+/*
+ * orcModifyInit
+ *    Defines orc_fdw.write_workers.
+ */
+extern "C"
+void
+orcModifyInit(void)
+{
+    DefineCustomIntVariable("orc_fdw.write_workers",
+                            "Sets the number of threads encoding and compressing ORC files written by INSERT.",
+                            "Zero encodes on the backend.",
+                            &orc_write_workers,
+                            0,
+                            0,
+                            ORC_MAX_WRITE_WORKERS,
+                            PGC_USERSET,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+}
+
+/*
+ * orcIsForeignRelUpdatable
+ *    ORC FDW function set in orc_fdw.c
+ */
+extern "C"
+int
+orcIsForeignRelUpdatable(Relation rel)
+{
+    return (1 << CMD_INSERT);
+}
+
+/*
+ * orcPlanForeignModify
+ *    ORC FDW function set in orc_fdw.c; the file is read from table
+ *    options at execution.
+ */
+extern "C"
+List *
+orcPlanForeignModify(PlannerInfo *root, ModifyTable *plan, Index resultRelation, int subplan_index)
+{
+    if (plan->operation != CMD_INSERT)
+    {
+        ereport(ERROR, (errmsg("%s: UPDATE and DELETE %s", ORC_FDW_NAME, ORC_MSG_UNSUPPORTED)));
+    }
+
+    return NIL;
+}
+
+/*
+ * orcBeginForeignModify
+ *    ORC FDW function set in orc_fdw.c
+ */
+extern "C"
+void
+orcBeginForeignModify(ModifyTableState *mstate, ResultRelInfo *rinfo, List *fdw_private, int subplan_index, int eflags)
+{
+    if (eflags & EXEC_FLAG_EXPLAIN_ONLY)
+        return;
+
+    rinfo->ri_FdwState = beginWrite(rinfo);
+}
+
+/*
+ * orcExecForeignInsert
+ *    ORC FDW function set in orc_fdw.c
+ */
+extern "C"
+TupleTableSlot *
+orcExecForeignInsert(EState *estate, ResultRelInfo *rinfo, TupleTableSlot *slot, TupleTableSlot *planSlot)
+{
+    writeSlot((OrcFdwModifyState *) rinfo->ri_FdwState, slot);
+
+    return slot;
+}
+
+#if PG_VERSION_NUM >= 140000
+/*
+ * orcGetForeignModifyBatchSize
+ *    ORC FDW function set in orc_fdw.c. RETURNING and row triggers need
+ *    rows to be inserted one at a time.
+ */
+extern "C"
+int
+orcGetForeignModifyBatchSize(ResultRelInfo *rinfo)
+{
+    if (rinfo->ri_projectReturning != NULL
+        || (rinfo->ri_TrigDesc != NULL
+            && (rinfo->ri_TrigDesc->trig_insert_before_row || rinfo->ri_TrigDesc->trig_insert_after_row)))
+    {
+        return 1;
+    }
+
+    return ORC_DEFAULT_WRITE_BATCH_SIZE;
+}
+
+/*
+ * orcExecForeignBatchInsert
+ *    ORC FDW function set in orc_fdw.c
+ */
+extern "C"
+TupleTableSlot **
+orcExecForeignBatchInsert(EState *estate, ResultRelInfo *rinfo, TupleTableSlot **slots, TupleTableSlot **planSlots, int *numSlots)
+{
+    for (int i = 0; i < *numSlots; i++)
+        writeSlot((OrcFdwModifyState *) rinfo->ri_FdwState, slots[i]);
+
+    return slots;
+}
+#endif
+
+/*
+ * orcEndForeignModify
+ *    ORC FDW function set in orc_fdw.c
+ */
+extern "C"
+void
+orcEndForeignModify(EState *estate, ResultRelInfo *rinfo)
+{
+    endWrite(rinfo);
+}
+
+/*
+ * orcBeginForeignInsert
+ *    ORC FDW function set in orc_fdw.c; used by COPY FROM and for
+ *    partitions.
+ */
+extern "C"
+void
+orcBeginForeignInsert(ModifyTableState *mstate, ResultRelInfo *rinfo)
+{
+    rinfo->ri_FdwState = beginWrite(rinfo);
+}
+
+/*
+ * orcEndForeignInsert
+ *    ORC FDW function set in orc_fdw.c
+ */
+extern "C"
+void
+orcEndForeignInsert(EState *estate, ResultRelInfo *rinfo)
+{
+    endWrite(rinfo);
+}
+
+/*
+ * orcExplainForeignModify
+ *    Puts out rows written to the new file.
+ */
+extern "C"
+void
+orcExplainForeignModify(ModifyTableState *mstate, ResultRelInfo *rinfo, List *fdw_private, int subplan_index, struct ExplainState *es)
+{
+    OrcFdwModifyState *state = (OrcFdwModifyState *) rinfo->ri_FdwState;
+
+    if (es->analyze && state != NULL)
+    {
+        ExplainPropertyInteger("ORC Rows Copied", NULL, state->writer->getRowsCopied(), es);
+        ExplainPropertyInteger("ORC Rows Written", NULL, state->rows, es);
+    }
+}
+
+/*
+ * orc_compact
+ *    Merges the ORC files of a folder, in name order, into one file with
+ *    the write options given as name=value pairs. Files with columns other
+ *    than those of the first file are skipped. The rows of each file are
+ *    copied a batch at a time, so memory use doesn't grow with the files.
+ *    Like an INSERT, the file is written next to target_file and takes
+ *    its place when the transaction commits. Returns the files merged.
+ */
+extern "C"
+Datum
+orc_compact(PG_FUNCTION_ARGS)
+{
+    char *source_dir = text_to_cstring(PG_GETARG_TEXT_PP(0));
+    std::string target = text_to_cstring(PG_GETARG_TEXT_PP(1));
+    ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+    TupleDesc tupdesc;
+    Tuplestorestate *tupstore;
+    MemoryContext oldcontext;
+    OrcFdwWriteOptions write_options;
+    std::vector<std::string> sources;
+    std::string source_type;
+    std::string temp_filename;
+    OrcFdwWriter *writer = NULL;
+    DIR *dir;
+    struct dirent *de;
+    struct stat stat_buf;
+    ListCell *lc;
+
+    /* Check to see if caller supports us returning a tuplestore */
+    if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("%s: set-valued function called in context that cannot accept a set", ORC_FDW_NAME)));
+
+    if (!(rsinfo->allowedModes & SFRM_Materialize))
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("%s: materialize mode required, but it is not allowed in this context", ORC_FDW_NAME)));
+
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        elog(ERROR, "%s: return type must be a row type", ORC_FDW_NAME);
+
+    orcInitWriteOptions(&write_options);
+
+    foreach(lc, untransformRelOptions(PG_GETARG_DATUM(2)))
+    {
+        DefElem *def = (DefElem *) lfirst(lc);
+
+        if (!orcParseWriteOption(def, &write_options))
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("%s: invalid option \"%s\"", ORC_FDW_NAME, def->defname)));
+        }
+    }
+
+    write_options.workers = orc_write_workers;
+
+    if (stat(target.c_str(), &stat_buf) == 0)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_DUPLICATE_FILE),
+                 errmsg("%s: file \"%s\" already exists", ORC_FDW_NAME, target.c_str())));
+    }
+
+    dir = AllocateDir(source_dir);
+
+    while ((de = ReadDir(dir, source_dir)) != NULL)
+    {
+        char *file_ext = strrchr(de->d_name, '.');
+        std::string source = std::string(source_dir) + "/" + de->d_name;
+
+        if (file_ext == NULL || pg_strcasecmp(file_ext + 1, ORC_FILE_EXT) != 0)
+            continue;
+
+        /* Some filesystems don't return the type of entries */
+        if (de->d_type == DT_UNKNOWN)
+        {
+            if (stat(source.c_str(), &stat_buf) != 0 || !S_ISREG(stat_buf.st_mode))
+                continue;
+        }
+        else if (de->d_type != DT_REG)
+            continue;
+
+        sources.push_back(source);
+    }
+
+    FreeDir(dir);
+
+    std::sort(sources.begin(), sources.end());
+
+    oldcontext = MemoryContextSwitchTo(rsinfo->econtext->ecxt_per_query_memory);
+
+    tupstore = tuplestore_begin_heap(true, false, work_mem);
+    rsinfo->returnMode = SFRM_Materialize;
+    rsinfo->setResult = tupstore;
+    rsinfo->setDesc = tupdesc;
+
+    MemoryContextSwitchTo(oldcontext);
+
+    for (auto source = sources.begin(); source != sources.end(); source++)
+    {
+        orc::ReaderOptions options;
+        ORC_UNIQUE_PTR<orc::Reader> reader;
+        Datum values[ORC_COMPACT_COLS];
+        bool nulls[ORC_COMPACT_COLS];
+
+        CHECK_FOR_INTERRUPTS();
+
+        /* Empty files are new tables not inserted into yet */
+        if (stat(source->c_str(), &stat_buf) != 0 || stat_buf.st_size == 0)
+            continue;
+
+        (void) orcCreateReader(*source, &reader, options, false);
+
+        if (writer == NULL)
+        {
+            source_type = reader->getType().toString();
+            temp_filename = addPendingFile(target);
+
+            writer = new OrcFdwWriter(temp_filename, reader->getType(), NULL, write_options);
+            pending_files.back().writer = writer;
+        }
+        else if (reader->getType().toString() != source_type)
+        {
+            ereport(WARNING,
+                    (errmsg("%s: ORC file %s doesn't match the columns of %s; skipped.",
+                            ORC_FDW_NAME, source->c_str(), sources.front().c_str())));
+            continue;
+        }
+
+        values[0] = CStringGetTextDatum(source->c_str());
+        values[1] = Int64GetDatum((int64) reader->getNumberOfRows());
+        memset(nulls, 0, sizeof(nulls));
+
+        writer->appendReader(&reader, *source);
+        tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+    }
+
+    if (writer != NULL)
+        finishWrite(writer, NULL);
+
+    return (Datum) 0;
+}
+
+/*
+ * orc_export
+ *    Writes the rows of a query to an ORC file, fetching them through a
+ *    cursor so that memory use doesn't grow with the result. Options are
+ *    the write options of foreign tables and:
+ *    - parallel: number of files to write; each is encoded by its own
+ *      write worker, so the files are compressed at the same time.
+ *    - split_by: column whose hash picks the file of a row, so rows with
+ *      the same value go to the same file; rows are dealt out in turn
+ *      without it.
+ *    - fetch_size: rows fetched from the query at a time.
+ *    Like an INSERT, the files appear when the transaction commits; files
+ *    that already exist aren't overwritten. Returns each file written with
+ *    its number of rows.
+ */
+extern "C"
+Datum
+orc_export(PG_FUNCTION_ARGS)
+{
+    char *query = text_to_cstring(PG_GETARG_TEXT_PP(0));
+    std::string path = text_to_cstring(PG_GETARG_TEXT_PP(1));
+    ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+    TupleDesc tupdesc;
+    TupleDesc query_tupdesc;
+    Tuplestorestate *tupstore;
+    MemoryContext oldcontext;
+    MemoryContext fetch_context;
+    OrcFdwWriteOptions write_options;
+    int parallel = 1;
+    int fetch_size = ORC_EXPORT_FETCH_SIZE;
+    char *split_by = NULL;
+    int split_attnum = -1;
+    TypeCacheEntry *split_type = NULL;
+    SPIPlanPtr plan;
+    Portal portal;
+    TupleTableSlot *slot;
+    ORC_UNIQUE_PTR<orc::Type> type;
+    std::vector<OrcFdwModifyState> parts;
+    std::vector<std::string> filenames;
+    uint64_t next_part = 0;
+    struct stat stat_buf;
+    ListCell *lc;
+
+    /* Check to see if caller supports us returning a tuplestore */
+    if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("%s: set-valued function called in context that cannot accept a set", ORC_FDW_NAME)));
+
+    if (!(rsinfo->allowedModes & SFRM_Materialize))
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("%s: materialize mode required, but it is not allowed in this context", ORC_FDW_NAME)));
+
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        elog(ERROR, "%s: return type must be a row type", ORC_FDW_NAME);
+
+    orcInitWriteOptions(&write_options);
+
+    foreach(lc, getExportOptions(PG_GETARG_JSONB_P(2)))
+    {
+        DefElem *def = (DefElem *) lfirst(lc);
+        bool valid = true;
+
+        if (strcmp(def->defname, "parallel") == 0)
+            valid = parse_int(defGetString(def), &parallel, 0, NULL) && parallel >= 1 && parallel <= ORC_MAX_WRITE_WORKERS;
+        else if (strcmp(def->defname, "fetch_size") == 0)
+            valid = parse_int(defGetString(def), &fetch_size, 0, NULL) && fetch_size > 0;
+        else if (strcmp(def->defname, "split_by") == 0)
+            split_by = defGetString(def);
+        else if (!orcParseWriteOption(def, &write_options))
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("%s: invalid option \"%s\"", ORC_FDW_NAME, def->defname)));
+        }
+
+        if (!valid)
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("%s: invalid value for option \"%s\": \"%s\"",
+                            ORC_FDW_NAME, def->defname, defGetString(def))));
+        }
+    }
+
+    /* A worker per file so that all files are encoded at once */
+    write_options.workers = (parallel > 1) ? Max(orc_write_workers, parallel) : orc_write_workers;
+
+    oldcontext = MemoryContextSwitchTo(rsinfo->econtext->ecxt_per_query_memory);
+
+    tupstore = tuplestore_begin_heap(true, false, work_mem);
+    rsinfo->returnMode = SFRM_Materialize;
+    rsinfo->setResult = tupstore;
+    rsinfo->setDesc = tupdesc;
+
+    MemoryContextSwitchTo(oldcontext);
+
+    if (SPI_connect() != SPI_OK_CONNECT)
+        elog(ERROR, "%s: SPI_connect failed", ORC_FDW_NAME);
+
+    plan = SPI_prepare_cursor(query, 0, NULL, CURSOR_OPT_NO_SCROLL);
+
+    if (plan == NULL)
+        elog(ERROR, "%s: SPI_prepare_cursor failed: %s", ORC_FDW_NAME, SPI_result_code_string(SPI_result));
+
+    portal = SPI_cursor_open(NULL, plan, NULL, NULL, false);
+    query_tupdesc = portal->tupDesc;
+
+    /* Columns are written by name */
+    for (int attnum = 0; attnum < query_tupdesc->natts; attnum++)
+    {
+        Form_pg_attribute attr = TupleDescAttr(query_tupdesc, attnum);
+
+        for (int other = 0; other < attnum; other++)
+        {
+            if (strcmp(NameStr(TupleDescAttr(query_tupdesc, other)->attname), NameStr(attr->attname)) == 0)
+            {
+                ereport(ERROR,
+                        (errcode(ERRCODE_DUPLICATE_COLUMN),
+                         errmsg("%s: column name \"%s\" appears more than once in the query", ORC_FDW_NAME, NameStr(attr->attname))));
+            }
+        }
+
+        if (split_by != NULL && strcmp(split_by, NameStr(attr->attname)) == 0)
+            split_attnum = attnum;
+    }
+
+    if (split_by != NULL)
+    {
+        if (split_attnum < 0)
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_UNDEFINED_COLUMN),
+                     errmsg("%s: split_by column %s is not in the query.", ORC_FDW_NAME, split_by)));
+        }
+
+        split_type = lookup_type_cache(TupleDescAttr(query_tupdesc, split_attnum)->atttypid, TYPECACHE_HASH_PROC_FINFO);
+
+        if (!OidIsValid(split_type->hash_proc))
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_UNDEFINED_FUNCTION),
+                     errmsg("%s: column %s can't be used in split_by.", ORC_FDW_NAME, split_by)));
+        }
+    }
+
+    type = orcGetTypeForTupleDesc(query_tupdesc);
+    slot = MakeSingleTupleTableSlot(query_tupdesc, &TTSOpsHeapTuple);
+
+    for (int part = 0; part < parallel; part++)
+    {
+        std::string filename = (parallel > 1) ? getPartFilename(path, part) : path;
+        std::string temp_filename;
+        OrcFdwModifyState state;
+
+        if (stat(filename.c_str(), &stat_buf) == 0)
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_DUPLICATE_FILE),
+                     errmsg("%s: file \"%s\" already exists", ORC_FDW_NAME, filename.c_str())));
+        }
+
+        temp_filename = addPendingFile(filename);
+        state.writer = new OrcFdwWriter(temp_filename, *type, query_tupdesc, write_options);
+        pending_files.back().writer = state.writer;
+        state.sort = orcBeginSort(query_tupdesc, &write_options);
+        state.rows = 0;
+
+        parts.push_back(state);
+        filenames.push_back(filename);
+    }
+
+    /* Memory used to write the rows of a fetch */
+    fetch_context = AllocSetContextCreate(CurrentMemoryContext,
+                                          "orc_fdw export fetch",
+                                          ALLOCSET_DEFAULT_SIZES);
+
+    for (;;)
+    {
+        SPI_cursor_fetch(portal, true, fetch_size);
+
+        if (SPI_processed == 0)
+            break;
+
+        oldcontext = MemoryContextSwitchTo(fetch_context);
+
+        for (uint64 i = 0; i < SPI_processed; i++)
+        {
+            uint64_t part = 0;
+
+            ExecStoreHeapTuple(SPI_tuptable->vals[i], slot, false);
+
+            if (split_type != NULL)
+            {
+                bool isnull;
+                Datum value = slot_getattr(slot, split_attnum + 1, &isnull);
+
+                if (!isnull)
+                    part = DatumGetUInt32(FunctionCall1Coll(&split_type->hash_proc_finfo,
+                                                            TupleDescAttr(query_tupdesc, split_attnum)->attcollation,
+                                                            value)) % parallel;
+            }
+            else
+            {
+                part = next_part++ % parallel;
+            }
+
+            writeSlot(&parts[part], slot);
+        }
+
+        MemoryContextSwitchTo(oldcontext);
+        MemoryContextReset(fetch_context);
+
+        ExecClearTuple(slot);
+        SPI_freetuptable(SPI_tuptable);
+
+        CHECK_FOR_INTERRUPTS();
+    }
+
+    SPI_cursor_close(portal);
+
+    for (size_t part = 0; part < parts.size(); part++)
+    {
+        Datum values[ORC_EXPORT_COLS];
+        bool nulls[ORC_EXPORT_COLS];
+
+        finishWrite(parts[part].writer, parts[part].sort);
+
+        values[0] = CStringGetTextDatum(filenames[part].c_str());
+        values[1] = Int64GetDatum((int64) parts[part].rows);
+        memset(nulls, 0, sizeof(nulls));
+
+        tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+    }
+
+    ExecDropSingleTupleTableSlot(slot);
+    SPI_finish();
+
+    return (Datum) 0;
+}
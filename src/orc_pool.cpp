@@ -0,0 +1,291 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_pool.cpp
+ *    Per backend pool of ORC file readers reused across scans.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ *    Opening an ORC file reads and parses its tail: postscript, footer
+ *    and metadata. A scan checks a reader out of the pool and creates its
+ *    row readers from it; when the scan ends, the reader goes back with
+ *    its file still open, so the planner and later queries on the same
+ *    file skip the open and the parse. Readers are validated with stat
+ *    before reuse, and the least recently used idle readers are closed
+ *    above orc_fdw.reader_pool_size. The pool keeps owning a reader while
+ *    it's checked out, so readers checked out by a scan that aborts are
+ *    closed along with the scan's row reader.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    src/orc_pool.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+/* C++ header files */
+#include <list>
+#include <new>
+
+/* ORC FDW header files */
+#include <orc_pool.h>
+
+/* Apache ORC header files */
+#include <orc/Exceptions.hh>
+#include <orc/OrcFile.hh>
+
+/* PostgreSQL and FDW header files */
+extern "C"
+{
+    #include "orc_fdw.h"
+    #include "access/xact.h"
+    #include "utils/guc.h"
+}
+
+
+/* Maximum number of readers kept open; zero closes readers after scans */
+static int orc_reader_pool_size = ORC_DEFAULT_READER_POOL_SIZE;
+
+/* Pooled readers, most recently used first */
+static std::list<OrcPooledReader> reader_pool;
+
+/* Declare the functions to use within this file */
+static bool isSameFile(const OrcPooledReader &entry, const struct stat &st);
+static void evictReaders(void);
+static void orcPoolXactCallback(XactEvent event, void *arg);
+static void orcPoolSubXactCallback(SubXactEvent event, SubTransactionId mySubid, SubTransactionId parentSubid, void *arg);
+
+
+/*
+ * orcReaderPoolInit
+ *    Defines orc_fdw.reader_pool_size and registers the callbacks closing
+ *    readers of aborted scans.
+ */
+extern "C"
+void
+orcReaderPoolInit(void)
+{
+    DefineCustomIntVariable("orc_fdw.reader_pool_size",
+                            "Sets the number of ORC files each backend keeps open for later scans.",
+                            "Zero closes files when scans end.",
+                            &orc_reader_pool_size,
+                            ORC_DEFAULT_READER_POOL_SIZE,
+                            0,
+                            ORC_MAX_READER_POOL_SIZE,
+                            PGC_USERSET,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
+    RegisterXactCallback(orcPoolXactCallback, NULL);
+    RegisterSubXactCallback(orcPoolSubXactCallback, NULL);
+}
+
+/*
+ * orcReaderPoolCheckout
+ *    Checks out a reader of filename; an idle pooled reader of the same
+ *    file if there is one, otherwise a new one. Reads from the file are
+ *    counted in stats, if given, until the reader is checked in. Returns
+ *    the pool entry, which keeps owning the reader.
+ */
+OrcPooledReader *
+orcReaderPoolCheckout(const std::string &filename, OrcFdwScanStats *stats, bool *hit)
+{
+    OrcPooledReader *entry = NULL;
+    struct stat st;
+    bool has_stat = (stat(filename.c_str(), &st) == 0);
+
+    *hit = false;
+
+    for (auto pooled = reader_pool.begin(); pooled != reader_pool.end(); )
+    {
+        if (pooled->in_use || pooled->filename != filename)
+        {
+            pooled++;
+            continue;
+        }
+
+        if (has_stat && isSameFile(*pooled, st))
+        {
+            reader_pool.splice(reader_pool.begin(), reader_pool, pooled);
+            entry = &reader_pool.front();
+            *hit = true;
+            break;
+        }
+
+        /* The file was replaced or rewritten since it was opened */
+        pooled = reader_pool.erase(pooled);
+    }
+
+    if (entry == NULL)
+    {
+        std::string error;
+
+        reader_pool.emplace_front();
+        entry = &reader_pool.front();
+
+        entry->filename = filename;
+        entry->dev = 0;
+        entry->ino = 0;
+        entry->size = -1;
+        entry->mtime.tv_sec = 0;
+        entry->mtime.tv_nsec = 0;
+
+        if (has_stat)
+        {
+            entry->dev = st.st_dev;
+            entry->ino = st.st_ino;
+            entry->size = st.st_size;
+            entry->mtime = st.st_mtim;
+        }
+
+        entry->stream = NULL;
+        entry->in_use = false;
+
+        /* Let's catch exceptions and throw an error */
+        try
+        {
+            ORC_UNIQUE_PTR<orc::InputStream> inStream =
+                orc::readLocalFile(filename.c_str());
+            orc::ReaderOptions options;
+
+            entry->stream = new OrcCountingInputStream(std::move(inStream), stats);
+            inStream.reset(entry->stream);
+
+            /* Count memory, decompression and row groups for EXPLAIN ANALYZE */
+            options.setMemoryPool(entry->memory_pool);
+            options.setReaderMetrics(&entry->metrics);
+
+            entry->reader = orc::createReader(std::move(inStream), options);
+        }
+        catch (orc::ParseError& err)
+        {
+            error = err.what();
+        }
+
+        if (!error.empty() || entry->reader == NULL)
+        {
+            reader_pool.pop_front();
+
+            ereport(ERROR, (errmsg("%s: %s", ORC_FDW_NAME,
+                                   error.empty() ? "Unable to create reader for ORC file." : error.c_str())));
+        }
+    }
+
+    entry->in_use = true;
+    entry->subid = GetCurrentSubTransactionId();
+
+    /* Counters start from zero for the scan; the tail stays allocated */
+    entry->stream->setStats(stats);
+    entry->memory_pool.resetPeak();
+    entry->metrics.~ReaderMetrics();
+    new (&entry->metrics) orc::ReaderMetrics();
+
+    return entry;
+}
+
+/*
+ * orcReaderPoolCheckin
+ *    Returns a reader to the pool, destroying the row reader and batch
+ *    of the scan. Other row readers created from it must be destroyed
+ *    first.
+ */
+void
+orcReaderPoolCheckin(OrcPooledReader *entry)
+{
+    entry->batch.reset();
+    entry->row_reader.reset();
+    entry->stream->setStats(NULL);
+    entry->in_use = false;
+
+    evictReaders();
+}
+
+/*
+ * isSameFile
+ *    Returns true if st describes the file the pooled reader opened.
+ */
+static
+bool
+isSameFile(const OrcPooledReader &entry, const struct stat &st)
+{
+    return (entry.dev == st.st_dev
+            && entry.ino == st.st_ino
+            && entry.size == st.st_size
+            && entry.mtime.tv_sec == st.st_mtim.tv_sec
+            && entry.mtime.tv_nsec == st.st_mtim.tv_nsec);
+}
+
+/*
+ * evictReaders
+ *    Closes the least recently used idle readers above the pool size.
+ */
+static
+void
+evictReaders(void)
+{
+    size_t size = reader_pool.size();
+
+    for (auto pooled = reader_pool.end(); pooled != reader_pool.begin() && size > (size_t) orc_reader_pool_size; )
+    {
+        pooled--;
+
+        if (pooled->in_use)
+            continue;
+
+        pooled = reader_pool.erase(pooled);
+        size--;
+    }
+}
+
+/*
+ * orcPoolXactCallback
+ *    Closes readers checked out by scans of an aborted transaction, and
+ *    their row readers; the scans never end.
+ */
+static
+void
+orcPoolXactCallback(XactEvent event, void *arg)
+{
+    if (event != XACT_EVENT_ABORT && event != XACT_EVENT_PARALLEL_ABORT)
+        return;
+
+    for (auto pooled = reader_pool.begin(); pooled != reader_pool.end(); )
+    {
+        if (pooled->in_use)
+            pooled = reader_pool.erase(pooled);
+        else
+            pooled++;
+    }
+}
+
+/*
+ * orcPoolSubXactCallback
+ *    Closes readers checked out by scans of an aborted subtransaction;
+ *    readers of a committed one now belong to its parent.
+ */
+static
+void
+orcPoolSubXactCallback(SubXactEvent event, SubTransactionId mySubid, SubTransactionId parentSubid, void *arg)
+{
+    for (auto pooled = reader_pool.begin(); pooled != reader_pool.end(); )
+    {
+        if (!pooled->in_use || pooled->subid != mySubid)
+        {
+            pooled++;
+            continue;
+        }
+
+        if (event == SUBXACT_EVENT_ABORT_SUB)
+        {
+            pooled = reader_pool.erase(pooled);
+            continue;
+        }
+
+        if (event == SUBXACT_EVENT_COMMIT_SUB)
+            pooled->subid = parentSubid;
+
+        pooled++;
+    }
+}
@@ -0,0 +1,361 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_sample.cpp
+ *    Seeded SYSTEM and BERNOULLI sampling of ORC foreign table scans.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ *    PostgreSQL only allows TABLESAMPLE on tables and materialized views,
+ *    so scans of ORC foreign tables are sampled with orc_fdw.sample_method,
+ *    orc_fdw.sample_percent and orc_fdw.sample_seed, as set when a query
+ *    is planned. SYSTEM picks row groups by hash before the scan starts,
+ *    and the row reader seeks from one picked group to the next, so only
+ *    the streams of those groups are read. BERNOULLI reads every batch and
+ *    drops the rows not picked from its selection vector. The hash mixes
+ *    row numbers with the seed, so the same seed picks the same rows of a
+ *    file in every scan.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    src/orc_sample.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+/* C++ header files */
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+/* ORC FDW header files */
+#include <orc_sample.h>
+
+/* PostgreSQL and FDW header files */
+extern "C"
+{
+    #include "orc_fdw.h"
+    #include "utils/guc.h"
+}
+
+
+/* Sampling of scans planned now */
+int orc_sample_method = ORC_SAMPLE_NONE;
+double orc_sample_percent = ORC_DEFAULT_SAMPLE_PERCENT;
+int orc_sample_seed = 0;
+
+static const struct config_enum_entry sample_method_options[] =
+{
+    {"none", ORC_SAMPLE_NONE, false},
+    {"system", ORC_SAMPLE_SYSTEM, false},
+    {"bernoulli", ORC_SAMPLE_BERNOULLI, false},
+    {NULL, 0, false}
+};
+
+/* Declare the functions to use within this file */
+static inline uint64_t mixBits(uint64_t value);
+static inline bool isSampled(const OrcFdwSample &sample, uint64_t row);
+static void addRange(OrcFdwSample &sample, uint64_t start, uint64_t end);
+
+
+/*
+ * orcSampleInit
+ *    Defines orc_fdw.sample_method, orc_fdw.sample_percent and
+ *    orc_fdw.sample_seed.
+ */
+extern "C"
+void
+orcSampleInit(void)
+{
+    DefineCustomEnumVariable("orc_fdw.sample_method",
+                             "Sets the sampling method of ORC foreign table scans.",
+                             "SYSTEM reads whole row groups; BERNOULLI reads all rows and keeps some.",
+                             &orc_sample_method,
+                             ORC_SAMPLE_NONE,
+                             sample_method_options,
+                             PGC_USERSET,
+                             0,
+                             NULL,
+                             NULL,
+                             NULL);
+
+    DefineCustomRealVariable("orc_fdw.sample_percent",
+                             "Sets the percentage of an ORC file sampled by scans.",
+                             NULL,
+                             &orc_sample_percent,
+                             ORC_DEFAULT_SAMPLE_PERCENT,
+                             0.0,
+                             100.0,
+                             PGC_USERSET,
+                             0,
+                             NULL,
+                             NULL,
+                             NULL);
+
+    DefineCustomIntVariable("orc_fdw.sample_seed",
+                            "Sets the seed of sampled ORC foreign table scans.",
+                            "Scans with the same seed sample the same rows of a file.",
+                            &orc_sample_seed,
+                            0,
+                            INT_MIN,
+                            INT_MAX,
+                            PGC_USERSET,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+}
+
+/*
+ * orcSampleSetup
+ *    Sets up sampling of a scan of the file of p_reader. For SYSTEM, the
+ *    row groups to read are picked here; stripes if the file has no row
+ *    index to seek with.
+ */
+void
+orcSampleSetup(OrcFdwSample &sample, OrcFdwSampleMethod method, double percent, int seed, ORC_UNIQUE_PTR<orc::Reader> *p_reader)
+{
+    double fraction = std::max(percent, 0.0) / 100.0;
+
+    sample.method = method;
+    sample.seed = mixBits((uint32_t) seed);
+    sample.ranges.clear();
+
+    orcSampleRestart(sample);
+
+    /* All rows are kept; it's a plain scan */
+    if (fraction >= 1.0)
+        sample.method = ORC_SAMPLE_NONE;
+
+    if (sample.method == ORC_SAMPLE_NONE)
+        return;
+
+    /* Kept if the hash is below; never for 0 percent */
+    sample.threshold = (uint64_t) std::ldexp(fraction, 64);
+
+    if (sample.method == ORC_SAMPLE_SYSTEM)
+    {
+        uint64_t stride = (*p_reader)->getRowIndexStride();
+        uint64_t nstripes = (*p_reader)->getNumberOfStripes();
+        uint64_t first_row = 0;
+
+        for (uint64_t i = 0; i < nstripes; i++)
+        {
+            uint64_t stripe_rows = (*p_reader)->getStripe(i)->getNumberOfRows();
+            uint64_t end_row = first_row + stripe_rows;
+            uint64_t group_rows = (stride > 0) ? stride : stripe_rows;
+
+            /* Row groups start at the start of their stripe */
+            for (uint64_t start = first_row; start < end_row; start += group_rows)
+            {
+                if (isSampled(sample, start))
+                    addRange(sample, start, std::min(start + group_rows, end_row));
+            }
+
+            first_row = end_row;
+        }
+    }
+}
+
+/*
+ * orcSampleRestart
+ *    Starts the sample over for a scan from the first row.
+ */
+void
+orcSampleRestart(OrcFdwSample &sample)
+{
+    sample.curr_range = 0;
+    sample.next_row = 0;
+}
+
+/*
+ * orcSampleSeek
+ *    Moves the row reader to the next row group picked by SYSTEM before a
+ *    batch is read, unless it's already in one. Returns false if no rows
+ *    are left to read.
+ */
+bool
+orcSampleSeek(OrcFdwSample &sample, orc::RowReader *rowReader)
+{
+    if (sample.method != ORC_SAMPLE_SYSTEM)
+        return true;
+
+    while (sample.curr_range < sample.ranges.size() && sample.ranges[sample.curr_range].second <= sample.next_row)
+        sample.curr_range++;
+
+    if (sample.curr_range == sample.ranges.size())
+        return false;
+
+    if (sample.ranges[sample.curr_range].first > sample.next_row)
+    {
+        sample.next_row = sample.ranges[sample.curr_range].first;
+        rowReader->seekToRow(sample.next_row);
+    }
+
+    return true;
+}
+
+/*
+ * orcSampleBatch
+ *    Drops rows not sampled from the selection vector of a batch of rows
+ *    starting at first_row in the file. Without has_sel, all rows of the
+ *    batch are candidates. Returns the number of rows left in sel.
+ */
+int64_t
+orcSampleBatch(OrcFdwSample &sample, uint64_t first_row, uint64_t rows, std::vector<uint32_t> &sel, int64_t nsel, bool has_sel)
+{
+    int64_t count = (has_sel ? nsel : (int64_t) rows);
+    int64_t kept = 0;
+
+    sample.next_row = first_row + rows;
+
+    if (!has_sel)
+    {
+        if (sel.size() < rows)
+            sel.resize(rows);
+
+        for (uint64_t i = 0; i < rows; i++)
+            sel[i] = (uint32_t) i;
+    }
+
+    if (sample.method == ORC_SAMPLE_BERNOULLI)
+    {
+        /* Branch free; a row is written over if it isn't kept */
+        for (int64_t i = 0; i < count; i++)
+        {
+            uint32_t pos = sel[i];
+
+            sel[kept] = pos;
+            kept += isSampled(sample, first_row + pos);
+        }
+    }
+    else if (sample.method == ORC_SAMPLE_SYSTEM)
+    {
+        size_t range = sample.curr_range;
+
+        /* A batch may run past the end of a picked row group */
+        for (int64_t i = 0; i < count; i++)
+        {
+            uint64_t row = first_row + sel[i];
+
+            while (range < sample.ranges.size() && sample.ranges[range].second <= row)
+                range++;
+
+            if (range == sample.ranges.size())
+                break;
+
+            if (sample.ranges[range].first <= row)
+                sel[kept++] = sel[i];
+        }
+    }
+    else
+        kept = count;
+
+    return kept;
+}
+
+/*
+ * orcSampleNextRow
+ *    Returns the first sampled row at or after row; total_rows if none.
+ *    Used by scans that need no column values.
+ */
+uint64_t
+orcSampleNextRow(OrcFdwSample &sample, uint64_t row, uint64_t total_rows)
+{
+    switch (sample.method)
+    {
+        case ORC_SAMPLE_SYSTEM:
+        {
+            while (sample.curr_range < sample.ranges.size() && sample.ranges[sample.curr_range].second <= row)
+                sample.curr_range++;
+
+            if (sample.curr_range == sample.ranges.size())
+                return total_rows;
+
+            return std::max(row, sample.ranges[sample.curr_range].first);
+        }
+        case ORC_SAMPLE_BERNOULLI:
+        {
+            while (row < total_rows && !isSampled(sample, row))
+                row++;
+
+            return row;
+        }
+        case ORC_SAMPLE_NONE:
+        default:
+            return row;
+    }
+}
+
+/*
+ * orcSampleReadFraction
+ *    Returns the fraction of the file read by a sampled scan, for costing.
+ */
+double
+orcSampleReadFraction(OrcFdwSampleMethod method, double percent)
+{
+    if (method == ORC_SAMPLE_SYSTEM)
+        return std::min(std::max(percent, 0.0), 100.0) / 100.0;
+
+    return 1.0;
+}
+
+/*
+ * orcSampleMethodName
+ *    Returns the name of a sampling method as in TABLESAMPLE.
+ */
+const char *
+orcSampleMethodName(OrcFdwSampleMethod method)
+{
+    switch (method)
+    {
+        case ORC_SAMPLE_SYSTEM:
+            return "SYSTEM";
+        case ORC_SAMPLE_BERNOULLI:
+            return "BERNOULLI";
+        case ORC_SAMPLE_NONE:
+        default:
+            return "NONE";
+    }
+}
+
+/*
+ * mixBits
+ *    Returns a 64 bit hash of value; the finalizer of splitmix64.
+ */
+static inline
+uint64_t
+mixBits(uint64_t value)
+{
+    value += UINT64_C(0x9E3779B97F4A7C15);
+    value = (value ^ (value >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    value = (value ^ (value >> 27)) * UINT64_C(0x94D049BB133111EB);
+
+    return value ^ (value >> 31);
+}
+
+/*
+ * isSampled
+ *    Returns true if the row, or the group starting at the row, is kept.
+ */
+static inline
+bool
+isSampled(const OrcFdwSample &sample, uint64_t row)
+{
+    return (mixBits(row + sample.seed) < sample.threshold);
+}
+
+/*
+ * addRange
+ *    Adds rows from start up to end to the picked ranges; merged with the
+ *    last range if adjacent, so the reader doesn't seek between them.
+ */
+static
+void
+addRange(OrcFdwSample &sample, uint64_t start, uint64_t end)
+{
+    if (!sample.ranges.empty() && sample.ranges.back().second == start)
+        sample.ranges.back().second = end;
+    else
+        sample.ranges.push_back(std::make_pair(start, end));
+}
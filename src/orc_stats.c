@@ -0,0 +1,355 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_stats.c
+ *    Cumulative scan statistics of ORC foreign tables kept in shared
+ *    memory.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ *    Counters are kept per database, foreign table and file in a shared
+ *    hash table. A scan collects its counters locally and adds them to
+ *    the hash table once when it ends, so short queries take the lock
+ *    only once and in shared mode unless a new entry is created.
+ *
+ *    Shared memory is only available if the library is loaded through
+ *    shared_preload_libraries; otherwise nothing is collected and the
+ *    view is empty.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    src/orc_stats.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+/* PG includes */
+#include "postgres.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "storage/ipc.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
+#include "utils/builtins.h"
+#include "utils/guc.h"
+#include "utils/hsearch.h"
+#include "utils/tuplestore.h"
+
+/* ORC FDW specific includes */
+#include <orc_fdw.h>
+#include <orc_stats.h>
+
+
+/* Number of output columns of pg_stat_orc_fdw */
+#define ORC_STATS_COLS 12
+
+
+/* Hash key; filename is zero padded so the key may be hashed as a blob */
+typedef struct OrcStatsKey
+{
+    Oid dbid;
+    Oid relid;
+    char filename[MAXPGPATH];
+} OrcStatsKey;
+
+/* Hash entry; the mutex protects the counters */
+typedef struct OrcStatsEntry
+{
+    OrcStatsKey key;
+    slock_t mutex;
+    OrcStatsCounters counters;
+} OrcStatsEntry;
+
+/* Shared state; the lock protects the hash table */
+typedef struct OrcStatsSharedState
+{
+    LWLock *lock;
+} OrcStatsSharedState;
+
+
+PG_FUNCTION_INFO_V1(pg_stat_orc_fdw);
+PG_FUNCTION_INFO_V1(pg_stat_orc_fdw_reset);
+
+/* Maximum number of table and file entries */
+static int orc_stats_max = ORC_STATS_DEFAULT_MAX;
+
+/* Links to shared memory state */
+static OrcStatsSharedState *orc_stats_state = NULL;
+static HTAB *orc_stats_hash = NULL;
+
+/* Saved hook values */
+#if PG_VERSION_NUM >= 150000
+static shmem_request_hook_type prev_shmem_request_hook = NULL;
+#endif
+static shmem_startup_hook_type prev_shmem_startup_hook = NULL;
+
+/* Declare the functions to use within this file */
+static Size orcStatsMemsize(void);
+static void orcStatsShmemRequest(void);
+static void orcStatsShmemStartup(void);
+
+
+/*
+ * orcStatsInit
+ *    Called from _PG_init; sets up shared memory if the library is being
+ *    preloaded.
+ */
+void
+orcStatsInit(void)
+{
+    if (!process_shared_preload_libraries_in_progress)
+        return;
+
+    DefineCustomIntVariable("orc_fdw.stats_max",
+                            "Sets the maximum number of tables and files tracked by pg_stat_orc_fdw.",
+                            NULL,
+                            &orc_stats_max,
+                            ORC_STATS_DEFAULT_MAX,
+                            100,
+                            INT_MAX / 2,
+                            PGC_POSTMASTER,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
+#if PG_VERSION_NUM >= 150000
+    prev_shmem_request_hook = shmem_request_hook;
+    shmem_request_hook = orcStatsShmemRequest;
+#else
+    orcStatsShmemRequest();
+#endif
+
+    prev_shmem_startup_hook = shmem_startup_hook;
+    shmem_startup_hook = orcStatsShmemStartup;
+}
+
+/*
+ * orcStatsMemsize
+ *    Shared memory needed for the state and the hash table.
+ */
+static
+Size
+orcStatsMemsize(void)
+{
+    return add_size(MAXALIGN(sizeof(OrcStatsSharedState)),
+                    hash_estimate_size(orc_stats_max, sizeof(OrcStatsEntry)));
+}
+
+/*
+ * orcStatsShmemRequest
+ *    Requests shared memory and the lock.
+ */
+static
+void
+orcStatsShmemRequest(void)
+{
+#if PG_VERSION_NUM >= 150000
+    if (prev_shmem_request_hook)
+        prev_shmem_request_hook();
+#endif
+
+    RequestAddinShmemSpace(orcStatsMemsize());
+    RequestNamedLWLockTranche(ORC_FDW_NAME, 1);
+}
+
+/*
+ * orcStatsShmemStartup
+ *    Creates or attaches to the shared state and hash table.
+ */
+static
+void
+orcStatsShmemStartup(void)
+{
+    HASHCTL info;
+    bool found;
+
+    if (prev_shmem_startup_hook)
+        prev_shmem_startup_hook();
+
+    LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+
+    orc_stats_state = ShmemInitStruct("orc_fdw stats",
+                                      sizeof(OrcStatsSharedState),
+                                      &found);
+
+    if (!found)
+        orc_stats_state->lock = &(GetNamedLWLockTranche(ORC_FDW_NAME))->lock;
+
+    memset(&info, 0, sizeof(info));
+    info.keysize = sizeof(OrcStatsKey);
+    info.entrysize = sizeof(OrcStatsEntry);
+
+    orc_stats_hash = ShmemInitHash("orc_fdw stats hash",
+                                   orc_stats_max, orc_stats_max,
+                                   &info,
+                                   HASH_ELEM | HASH_BLOBS);
+
+    LWLockRelease(AddinShmemInitLock);
+}
+
+/*
+ * orcStatsReport
+ *    Adds counters of a scan to the entry of the table and file. If the
+ *    hash table is full, counters of new tables and files are dropped.
+ */
+void
+orcStatsReport(Oid relid, const char *filename, const OrcStatsCounters *counters)
+{
+    OrcStatsKey key;
+    OrcStatsEntry *entry;
+
+    if (orc_stats_state == NULL || orc_stats_hash == NULL)
+        return;
+
+    memset(&key, 0, sizeof(key));
+    key.dbid = MyDatabaseId;
+    key.relid = relid;
+    strlcpy(key.filename, filename, sizeof(key.filename));
+
+    LWLockAcquire(orc_stats_state->lock, LW_SHARED);
+
+    entry = (OrcStatsEntry *) hash_search(orc_stats_hash, &key, HASH_FIND, NULL);
+
+    /* Creating an entry needs the exclusive lock */
+    if (entry == NULL)
+    {
+        bool found;
+
+        LWLockRelease(orc_stats_state->lock);
+        LWLockAcquire(orc_stats_state->lock, LW_EXCLUSIVE);
+
+        entry = (OrcStatsEntry *) hash_search(orc_stats_hash, &key, HASH_ENTER_NULL, &found);
+
+        if (entry != NULL && !found)
+        {
+            SpinLockInit(&entry->mutex);
+            memset(&entry->counters, 0, sizeof(entry->counters));
+        }
+    }
+
+    if (entry != NULL)
+    {
+        SpinLockAcquire(&entry->mutex);
+
+        entry->counters.scans += counters->scans;
+        entry->counters.rows_returned += counters->rows_returned;
+        entry->counters.rows_filtered += counters->rows_filtered;
+        entry->counters.stripes_read += counters->stripes_read;
+        entry->counters.stripes_skipped += counters->stripes_skipped;
+        entry->counters.bytes_read += counters->bytes_read;
+        entry->counters.io_time += counters->io_time;
+        entry->counters.decode_time += counters->decode_time;
+        entry->counters.metadata_cache_hits += counters->metadata_cache_hits;
+
+        SpinLockRelease(&entry->mutex);
+    }
+
+    LWLockRelease(orc_stats_state->lock);
+}
+
+/*
+ * pg_stat_orc_fdw
+ *    Returns counters of all tables and files.
+ */
+Datum
+pg_stat_orc_fdw(PG_FUNCTION_ARGS)
+{
+    ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+    TupleDesc tupdesc;
+    Tuplestorestate *tupstore;
+    MemoryContext oldcontext;
+    HASH_SEQ_STATUS hash_seq;
+    OrcStatsEntry *entry;
+
+    /* Check to see if caller supports us returning a tuplestore */
+    if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("%s: set-valued function called in context that cannot accept a set", ORC_FDW_NAME)));
+
+    if (!(rsinfo->allowedModes & SFRM_Materialize))
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("%s: materialize mode required, but it is not allowed in this context", ORC_FDW_NAME)));
+
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        elog(ERROR, "%s: return type must be a row type", ORC_FDW_NAME);
+
+    oldcontext = MemoryContextSwitchTo(rsinfo->econtext->ecxt_per_query_memory);
+
+    tupstore = tuplestore_begin_heap(true, false, work_mem);
+    rsinfo->returnMode = SFRM_Materialize;
+    rsinfo->setResult = tupstore;
+    rsinfo->setDesc = tupdesc;
+
+    MemoryContextSwitchTo(oldcontext);
+
+    /* Nothing is collected unless the library is preloaded */
+    if (orc_stats_state == NULL || orc_stats_hash == NULL)
+        return (Datum) 0;
+
+    LWLockAcquire(orc_stats_state->lock, LW_SHARED);
+
+    hash_seq_init(&hash_seq, orc_stats_hash);
+    while ((entry = (OrcStatsEntry *) hash_seq_search(&hash_seq)) != NULL)
+    {
+        Datum values[ORC_STATS_COLS];
+        bool nulls[ORC_STATS_COLS];
+        OrcStatsCounters counters;
+        int i = 0;
+
+        memset(nulls, 0, sizeof(nulls));
+
+        SpinLockAcquire(&entry->mutex);
+        counters = entry->counters;
+        SpinLockRelease(&entry->mutex);
+
+        values[i++] = ObjectIdGetDatum(entry->key.dbid);
+        values[i++] = ObjectIdGetDatum(entry->key.relid);
+        values[i++] = CStringGetTextDatum(entry->key.filename);
+        values[i++] = Int64GetDatumFast(counters.scans);
+        values[i++] = Int64GetDatumFast(counters.rows_returned);
+        values[i++] = Int64GetDatumFast(counters.rows_filtered);
+        values[i++] = Int64GetDatumFast(counters.stripes_read);
+        values[i++] = Int64GetDatumFast(counters.stripes_skipped);
+        values[i++] = Int64GetDatumFast(counters.bytes_read);
+        values[i++] = Float8GetDatumFast(counters.io_time);
+        values[i++] = Float8GetDatumFast(counters.decode_time);
+        values[i++] = Int64GetDatumFast(counters.metadata_cache_hits);
+
+        Assert(i == ORC_STATS_COLS);
+
+        tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+    }
+
+    LWLockRelease(orc_stats_state->lock);
+
+    return (Datum) 0;
+}
+
+/*
+ * pg_stat_orc_fdw_reset
+ *    Removes all entries.
+ */
+Datum
+pg_stat_orc_fdw_reset(PG_FUNCTION_ARGS)
+{
+    HASH_SEQ_STATUS hash_seq;
+    OrcStatsEntry *entry;
+
+    if (orc_stats_state == NULL || orc_stats_hash == NULL)
+        PG_RETURN_VOID();
+
+    LWLockAcquire(orc_stats_state->lock, LW_EXCLUSIVE);
+
+    hash_seq_init(&hash_seq, orc_stats_hash);
+    while ((entry = (OrcStatsEntry *) hash_seq_search(&hash_seq)) != NULL)
+        hash_search(orc_stats_hash, &entry->key, HASH_REMOVE, NULL);
+
+    LWLockRelease(orc_stats_state->lock);
+
+    PG_RETURN_VOID();
+}
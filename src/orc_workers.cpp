@@ -0,0 +1,164 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_workers.cpp
+ *    Pool of threads encoding ORC data for writers of a backend.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ *    Tasks are taken in the order submitted by the first idle thread.
+ *    Threads block all signals so that signal handlers of the backend
+ *    keep running on the backend's thread. When the pool shrinks, extra
+ *    threads exit once no tasks are left.
+ *
+ *    Nothing in this file calls PostgreSQL functions.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    src/orc_workers.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+/* system header files */
+#include <signal.h>
+#include <pthread.h>
+
+/* C++ header files */
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* ORC FDW header files */
+#include <orc_workers.h>
+
+
+/*
+ * Allocated on first use and never freed; threads may still be waiting
+ * on it while the backend exits.
+ */
+struct OrcFdwWorkerPool
+{
+    std::mutex lock;
+    std::condition_variable wakeup;
+    std::deque<std::function<void()>> tasks;
+    std::vector<std::thread> threads;
+
+    /* Threads with a lower index keep running */
+    size_t size = 0;
+};
+
+static OrcFdwWorkerPool *pool = NULL;
+
+
+/* Declare the functions to use within this file */
+static void workerMain(size_t index);
+
+
+/*
+ * workerMain
+ *    Runs tasks until the pool shrinks below index.
+ */
+static
+void
+workerMain(size_t index)
+{
+    std::unique_lock<std::mutex> guard(pool->lock);
+
+    for (;;)
+    {
+        std::function<void()> task;
+
+        pool->wakeup.wait(guard, [index] { return !pool->tasks.empty() || index >= pool->size; });
+
+        if (pool->tasks.empty())
+            return;
+
+        task = std::move(pool->tasks.front());
+        pool->tasks.pop_front();
+
+        guard.unlock();
+        task();
+        guard.lock();
+    }
+}
+
+/*
+ * orcWorkersResize
+ *    Starts or stops threads to have the given number running. Throws
+ *    std::system_error if a thread can't be started.
+ */
+void
+orcWorkersResize(int workers)
+{
+    size_t size = (size_t) workers;
+    std::vector<std::thread> stopped;
+
+    if (pool == NULL)
+        pool = new OrcFdwWorkerPool();
+
+    {
+        std::lock_guard<std::mutex> guard(pool->lock);
+
+        if (size == pool->size)
+            return;
+
+        pool->size = size;
+
+        while (pool->threads.size() > size)
+        {
+            stopped.push_back(std::move(pool->threads.back()));
+            pool->threads.pop_back();
+        }
+    }
+
+    pool->wakeup.notify_all();
+
+    for (auto &thread : stopped)
+        thread.join();
+
+    while (pool->threads.size() < size)
+    {
+        sigset_t all;
+        sigset_t old;
+
+        sigfillset(&all);
+        pthread_sigmask(SIG_SETMASK, &all, &old);
+
+        try
+        {
+            std::thread thread(workerMain, pool->threads.size());
+
+            std::lock_guard<std::mutex> guard(pool->lock);
+            pool->threads.push_back(std::move(thread));
+        }
+        catch (...)
+        {
+            pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+            std::lock_guard<std::mutex> guard(pool->lock);
+            pool->size = pool->threads.size();
+            throw;
+        }
+
+        pthread_sigmask(SIG_SETMASK, &old, NULL);
+    }
+}
+
+/*
+ * orcWorkersSubmit
+ *    Queues a task for the next idle thread. The pool must have been
+ *    resized to at least one thread.
+ */
+void
+orcWorkersSubmit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> guard(pool->lock);
+        pool->tasks.push_back(std::move(task));
+    }
+
+    pool->wakeup.notify_one();
+}
@@ -16,6 +16,10 @@
  *-------------------------------------------------------------------------
  */
 
+/* C++ header files */
+#include <algorithm>
+#include <type_traits>
+
 /* ORC FDW header files */
 #include <orc_wrapper.h>
 #include <orc_interface_typedefs.h>
@@ -34,19 +38,27 @@ extern "C"
 
 /* Declare the functions to use within this file */
 static std::string IsSupportedVersion(ORC_UNIQUE_PTR<orc::Reader> *p_reader);
+static OrcFileColInfo getColInfo(ORC_UNIQUE_PTR<orc::Reader> *p_reader, const orc::Type *type, const std::string &name, int index);
+template <typename StatsType>
+static bool isStripeStatsOrdered(const orc::StripeStatistics *prev, const orc::StripeStatistics *curr, uint64_t col_id);
+static bool isColumnOrdered(orc::TypeKind kind, const orc::StripeStatistics *prev, const orc::StripeStatistics *curr, uint64_t col_id);
+template <typename StatsType>
+static bool getStripeOverlap(ORC_UNIQUE_PTR<orc::Reader> *p_reader, uint64_t col_id, OrcFdwStripeOverlap *overlap);
 
 
 /*
  * orcCreateReader
  *    Creates Apache ORC file reader for file in a safe way for fdw.
  *    Creates a reader for the specified filename and stores it in
- *    the unique_ptr in p_reader.
+ *    the unique_ptr in p_reader. If stats is given, reads from the file
+ *    are counted in it.
  */
 bool
 orcCreateReader(std::string filename,
                     ORC_UNIQUE_PTR<orc::Reader> *p_reader, 
                     orc::ReaderOptions &options,
-                    bool blnVersionWarn)
+                    bool blnVersionWarn,
+                    OrcFdwScanStats *stats)
 {
     /* Let's catch exceptions and throw an error */
     try
@@ -54,6 +66,9 @@ orcCreateReader(std::string filename,
         ORC_UNIQUE_PTR<orc::InputStream> inStream =
             orc::readLocalFile(filename.c_str());
 
+        if (stats != NULL)
+            inStream.reset(new OrcCountingInputStream(std::move(inStream), stats));
+
         *p_reader = orc::createReader(std::move(inStream), options);
     }
     catch (orc::ParseError& err)
@@ -61,16 +76,27 @@ orcCreateReader(std::string filename,
         ereport(ERROR, (errmsg("%s: %s", ORC_FDW_NAME, err.what())));
     }
 
-    /* Throw a warning for unsupported ORC version */
+    if (blnVersionWarn)
+        orcWarnUnsupportedVersion(filename, p_reader);
+
+    /* *p_reader should never by NULL here, but just in case */
+    return ((*p_reader) != NULL);
+}
+
+/*
+ * orcWarnUnsupportedVersion
+ *    Throws a warning for unsupported ORC version.
+ */
+void
+orcWarnUnsupportedVersion(const std::string &filename, ORC_UNIQUE_PTR<orc::Reader> *p_reader)
+{
     std::string fileVersion = IsSupportedVersion(p_reader);
-    if (fileVersion.empty() == false && blnVersionWarn )
+
+    if (fileVersion.empty() == false)
     {
         ereport(WARNING, (errmsg("%s: Unsupported ORC file %s version 0.11.", ORC_FDW_NAME, filename.c_str()),
                          (errhint("This may still work, but it's strongly recommended to use files that are supported by the fdw."))));
     }
-
-    /* *p_reader should never by NULL here, but just in case */
-    return ((*p_reader) != NULL);
 }
 
 /*
@@ -146,25 +172,300 @@ orcGetColsInfo(ORC_UNIQUE_PTR<orc::Reader> *p_reader, ORC_UNIQUE_PTR<orc::RowRea
     // for (uint col_index = 0; col_index < (*p_rowReader)->getSelectedType().getSubtypeCount(); col_index++)
     for (uint col_index = 0; col_index < root->fields.size(); col_index++)
     {
-        OrcFileColInfo col;
-        auto orc_col_id = (*p_rowReader)->getSelectedType().getSubtype(col_index)->getColumnId();
-
-        col.hasNull = (*p_reader)->getColumnStatistics(orc_col_id)->hasNull();
-        col.kind = (*p_rowReader)->getSelectedType().getSubtype(col_index)->getKind();
-        col.max_length = (*p_rowReader)->getSelectedType().getSubtype(col_index)->getMaximumLength();
-        col.precision = (*p_rowReader)->getSelectedType().getSubtype(col_index)->getPrecision();
-        col.scale = (*p_rowReader)->getSelectedType().getSubtype(col_index)->getScale();
+        const orc::Type &type = (*p_rowReader)->getSelectedType();
 
         /* Index must be fixed if the rowReader was created for specific columns */
-        col.index = col_index;
-        col.name = (*p_rowReader)->getSelectedType().getFieldName(col_index);
-
-        col_list.push_back(col);
+        col_list.push_back(getColInfo(p_reader, type.getSubtype(col_index), type.getFieldName(col_index), col_index));
     }
 
     return col_list;
 }
 
+/*
+ * getColInfo
+ *    Returns meta data of a column and of the types nested in it.
+ */
+static
+OrcFileColInfo
+getColInfo(ORC_UNIQUE_PTR<orc::Reader> *p_reader, const orc::Type *type, const std::string &name, int index)
+{
+    OrcFileColInfo col;
+
+    col.hasNull = (*p_reader)->getColumnStatistics(type->getColumnId())->hasNull();
+    col.kind = type->getKind();
+    col.max_length = type->getMaximumLength();
+    col.precision = type->getPrecision();
+    col.scale = type->getScale();
+    col.index = index;
+    col.col_id = type->getColumnId();
+    col.name = name;
+
+    for (uint64_t i = 0; i < type->getSubtypeCount(); i++)
+    {
+        std::string child_name;
+
+        if (col.kind == orc::STRUCT)
+            child_name = type->getFieldName(i);
+        else if (col.kind == orc::MAP)
+            child_name = (i == 0) ? "key" : "value";
+        else
+            child_name = "element";
+
+        col.children.push_back(getColInfo(p_reader, type->getSubtype(i), child_name, (int) i));
+    }
+
+    return col;
+}
+
+/*
+ * orcGetBloomFilterColumns
+ *    Returns ids of columns that have bloom filter streams. Writers use
+ *    the same bloom filter columns for all stripes of a file, so we only
+ *    need to read the footer of the first stripe.
+ */
+std::set<uint64_t>
+orcGetBloomFilterColumns(ORC_UNIQUE_PTR<orc::Reader> *p_reader)
+{
+    std::set<uint64_t> cols;
+
+    if ((*p_reader)->getNumberOfStripes() == 0)
+        return cols;
+
+    try
+    {
+        ORC_UNIQUE_PTR<orc::StripeInformation> stripe = (*p_reader)->getStripe(0);
+
+        for (uint64_t i = 0; i < stripe->getNumberOfStreams(); i++)
+        {
+            ORC_UNIQUE_PTR<orc::StreamInformation> stream = stripe->getStreamInformation(i);
+
+            if (stream->getKind() == orc::StreamKind_BLOOM_FILTER
+                || stream->getKind() == orc::StreamKind_BLOOM_FILTER_UTF8)
+            {
+                cols.insert(stream->getColumnId());
+            }
+        }
+    }
+    catch (std::exception& err)
+    {
+        ereport(ERROR, (errmsg("%s: %s", ORC_FDW_NAME, err.what())));
+    }
+
+    return cols;
+}
+
+/*
+ * isStripeStatsOrdered
+ *    Returns true if the column has minimum and maximum values in the
+ *    current stripe that come after the maximum of the previous stripe.
+ */
+template <typename StatsType>
+static
+bool
+isStripeStatsOrdered(const orc::StripeStatistics *prev, const orc::StripeStatistics *curr, uint64_t col_id)
+{
+    const StatsType *stats = dynamic_cast<const StatsType *>(curr->getColumnStatistics(col_id));
+    const StatsType *prev_stats;
+
+    if (stats == NULL || !stats->hasMinimum() || !stats->hasMaximum())
+        return false;
+
+    if (prev == NULL)
+        return true;
+
+    prev_stats = dynamic_cast<const StatsType *>(prev->getColumnStatistics(col_id));
+
+    return (prev_stats->getMaximum() < stats->getMinimum());
+}
+
+/*
+ * isColumnOrdered
+ *    Calls isStripeStatsOrdered with the statistics type of the column;
+ *    false for types that can't be located by stripe statistics.
+ */
+static
+bool
+isColumnOrdered(orc::TypeKind kind, const orc::StripeStatistics *prev, const orc::StripeStatistics *curr, uint64_t col_id)
+{
+    switch (kind)
+    {
+        case orc::BYTE:
+        case orc::SHORT:
+        case orc::INT:
+        case orc::LONG:
+            return isStripeStatsOrdered<orc::IntegerColumnStatistics>(prev, curr, col_id);
+        case orc::FLOAT:
+        case orc::DOUBLE:
+            return isStripeStatsOrdered<orc::DoubleColumnStatistics>(prev, curr, col_id);
+        case orc::STRING:
+        case orc::VARCHAR:
+            return isStripeStatsOrdered<orc::StringColumnStatistics>(prev, curr, col_id);
+        case orc::DATE:
+            return isStripeStatsOrdered<orc::DateColumnStatistics>(prev, curr, col_id);
+        default:
+            return false;
+    }
+}
+
+/*
+ * orcGetSortedColumns
+ *    Returns for each column whether the file is sorted or clustered on it
+ *    such that the stripe statistics can locate a value, i.e. minimum and
+ *    maximum values of the column in each stripe are in order and don't
+ *    overlap with the next stripe. The statistics of each stripe are read
+ *    once for all columns, without its row index, and reading stops once
+ *    no column is left in order. A file with a single stripe is not
+ *    considered sorted; its statistics can't narrow down a lookup.
+ */
+std::vector<bool>
+orcGetSortedColumns(ORC_UNIQUE_PTR<orc::Reader> *p_reader, const std::vector<uint64_t> &col_ids, const std::vector<orc::TypeKind> &kinds)
+{
+    uint64_t stripes = (*p_reader)->getNumberOfStripes();
+    std::vector<bool> sorted(col_ids.size(), false);
+
+    if (stripes < 2)
+        return sorted;
+
+    sorted.assign(col_ids.size(), true);
+
+    try
+    {
+        ORC_UNIQUE_PTR<orc::StripeStatistics> prev;
+
+        for (uint64_t i = 0; i < stripes; i++)
+        {
+            ORC_UNIQUE_PTR<orc::StripeStatistics> curr = (*p_reader)->getStripeStatistics(i, false);
+            bool any_sorted = false;
+
+            for (size_t col = 0; col < col_ids.size(); col++)
+            {
+                if (!sorted[col])
+                    continue;
+
+                sorted[col] = isColumnOrdered(kinds[col], prev.get(), curr.get(), col_ids[col]);
+                any_sorted = any_sorted || sorted[col];
+            }
+
+            if (!any_sorted)
+                break;
+
+            prev = std::move(curr);
+        }
+    }
+    catch (std::exception& err)
+    {
+        /* Missing or unreadable statistics; treat as not sorted */
+        sorted.assign(col_ids.size(), false);
+    }
+
+    return sorted;
+}
+
+/*
+ * getStripeOverlap
+ *    Counts for each stripe the other stripes whose minimum and maximum
+ *    values of the column overlap its own. Stripes without a minimum,
+ *    i.e. only NULLs, are left out. Returns false if no stripe has one.
+ */
+template <typename StatsType>
+static
+bool
+getStripeOverlap(ORC_UNIQUE_PTR<orc::Reader> *p_reader, uint64_t col_id, OrcFdwStripeOverlap *overlap)
+{
+    typedef typename std::decay<decltype(std::declval<StatsType>().getMinimum())>::type Value;
+    std::vector<Value> mins;
+    std::vector<Value> maxs;
+    std::vector<Value> sorted_mins;
+    std::vector<Value> sorted_maxs;
+    uint64_t total = 0;
+
+    for (uint64_t i = 0; i < (*p_reader)->getNumberOfStripes(); i++)
+    {
+        ORC_UNIQUE_PTR<orc::StripeStatistics> curr = (*p_reader)->getStripeStatistics(i);
+        const StatsType *stats = dynamic_cast<const StatsType *>(curr->getColumnStatistics(col_id));
+
+        if (stats == NULL || !stats->hasMinimum() || !stats->hasMaximum())
+            continue;
+
+        mins.push_back(stats->getMinimum());
+        maxs.push_back(stats->getMaximum());
+    }
+
+    if (mins.empty())
+        return false;
+
+    sorted_mins = mins;
+    sorted_maxs = maxs;
+    std::sort(sorted_mins.begin(), sorted_mins.end());
+    std::sort(sorted_maxs.begin(), sorted_maxs.end());
+
+    overlap->stripes = mins.size();
+    overlap->max_overlapping = 0;
+
+    for (size_t i = 0; i < mins.size(); i++)
+    {
+        /* Stripes starting at or before this one ends, less those ending
+         * before it starts and the stripe itself */
+        uint64_t starting = std::upper_bound(sorted_mins.begin(), sorted_mins.end(), maxs[i]) - sorted_mins.begin();
+        uint64_t ended = std::lower_bound(sorted_maxs.begin(), sorted_maxs.end(), mins[i]) - sorted_maxs.begin();
+        uint64_t count = starting - ended - 1;
+
+        total += count;
+        overlap->max_overlapping = std::max(overlap->max_overlapping, count);
+    }
+
+    overlap->overlap = (mins.size() > 1) ? (double) total / (mins.size() * (mins.size() - 1)) : 0;
+    return true;
+}
+
+/*
+ * orcGetStripeOverlap
+ *    Computes overlap of stripe statistics of a column; returns false if
+ *    the column's type or the file has no comparable statistics.
+ */
+bool
+orcGetStripeOverlap(ORC_UNIQUE_PTR<orc::Reader> *p_reader, uint64_t col_id, orc::TypeKind kind, OrcFdwStripeOverlap *overlap)
+{
+    try
+    {
+        switch (kind)
+        {
+            case orc::BYTE:
+            case orc::SHORT:
+            case orc::INT:
+            case orc::LONG:
+                return getStripeOverlap<orc::IntegerColumnStatistics>(p_reader, col_id, overlap);
+            case orc::FLOAT:
+            case orc::DOUBLE:
+                return getStripeOverlap<orc::DoubleColumnStatistics>(p_reader, col_id, overlap);
+            case orc::STRING:
+            case orc::VARCHAR:
+            case orc::CHAR:
+                return getStripeOverlap<orc::StringColumnStatistics>(p_reader, col_id, overlap);
+            case orc::DATE:
+                return getStripeOverlap<orc::DateColumnStatistics>(p_reader, col_id, overlap);
+            case orc::TIMESTAMP:
+                return getStripeOverlap<orc::TimestampColumnStatistics>(p_reader, col_id, overlap);
+            default:
+                return false;
+        }
+    }
+    catch (std::exception& err)
+    {
+        return false;
+    }
+}
+
+/*
+ * orcGetRowIndexStride
+ *    Returns number of rows in a row group; 0 if the file has no row index.
+ */
+uint64_t
+orcGetRowIndexStride(ORC_UNIQUE_PTR<orc::Reader> *p_reader)
+{
+    return (*p_reader)->getRowIndexStride();
+}
+
 /*
  * IsSupportedVersion
  *    To be used internally in this file, for a supported version, returns
@@ -0,0 +1,976 @@
+/*-------------------------------------------------------------------------
+ *
+ * orc_writer.cpp
+ *    Writes rows of PostgreSQL tuples to an ORC file.
+ *
+ * 2020, Hamid Quddus Akhtar.
+ *
+ *    Values are converted from Datums into a row batch that is added to
+ *    the Apache ORC writer once full; the writer encodes and compresses
+ *    the batches into stripes. Columns map to attributes of the tuple by
+ *    name ignoring case, the same way as in a scan.
+ *
+ *    The ORC writer can only be used by one thread at a time, so write
+ *    workers don't split a file; a worker encodes the batches of a file
+ *    in order while the backend converts the next rows, and each file
+ *    written at the same time takes its own worker.
+ *
+ * Copyright (c) 2020, Highgo Software Inc.
+ *
+ * IDENTIFICATION
+ *    src/orc_writer.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+/* C++ header files */
+#include <algorithm>
+#include <chrono>
+#include <set>
+
+/* ORC FDW header files */
+#include <orc_workers.h>
+#include <orc_writer.h>
+#include <orc_wrapper.h>
+
+/* PostgreSQL and FDW header files */
+extern "C"
+{
+    #include "orc_fdw.h"
+    #include "miscadmin.h"
+    #include "catalog/pg_type.h"
+    #include "commands/defrem.h"
+    #include "utils/builtins.h"
+    #include "utils/date.h"
+    #include "utils/guc.h"
+    #include "utils/memutils.h"
+    #include "utils/numeric.h"
+    #include "utils/timestamp.h"
+    #include "utils/varlena.h"
+}
+
+
+/* Declare the functions to use within this file */
+static int getOrcKind(Oid typid);
+static bool isVarLength(OrcPgTypeKind kind);
+static ORC_UNIQUE_PTR<orc::Type> copyType(const orc::Type &type);
+
+
+/*
+ * getOrcKind
+ *    Returns the ORC type kind that a PG type is read from; the reverse
+ *    of the mapping in getColMetaData. Returns -1 for unsupported types.
+ */
+static
+int
+getOrcKind(Oid typid)
+{
+    switch (typid)
+    {
+        case BOOLOID:
+            return orc::BOOLEAN;
+        case INT2OID:
+            return orc::SHORT;
+        case INT4OID:
+            return orc::INT;
+        case INT8OID:
+            return orc::LONG;
+        case FLOAT4OID:
+            return orc::FLOAT;
+        case FLOAT8OID:
+            return orc::DOUBLE;
+        case NUMERICOID:
+            return orc::DECIMAL;
+        case TEXTOID:
+            return orc::STRING;
+        case VARCHAROID:
+            return orc::VARCHAR;
+        case CHAROID:
+            return orc::CHAR;
+        case BYTEAOID:
+            return orc::BINARY;
+        case TIMESTAMPOID:
+            return orc::TIMESTAMP;
+        case DATEOID:
+            return orc::DATE;
+        default:
+            return -1;
+    }
+}
+
+/*
+ * isVarLength
+ *    Returns true for columns stored in a StringVectorBatch.
+ */
+static
+bool
+isVarLength(OrcPgTypeKind kind)
+{
+    return (kind == OrcPgTypeKind::STRING
+            || kind == OrcPgTypeKind::VARCHAR
+            || kind == OrcPgTypeKind::CHAR
+            || kind == OrcPgTypeKind::BINARY);
+}
+
+/*
+ * copyType
+ *    Returns a copy of an ORC type tree; the writer needs a type that
+ *    outlives the reader it was taken from.
+ */
+static
+ORC_UNIQUE_PTR<orc::Type>
+copyType(const orc::Type &type)
+{
+    switch (type.getKind())
+    {
+        case orc::STRUCT:
+        {
+            ORC_UNIQUE_PTR<orc::Type> copy = orc::createStructType();
+
+            for (uint64_t i = 0; i < type.getSubtypeCount(); i++)
+                copy->addStructField(type.getFieldName(i), copyType(*type.getSubtype(i)));
+
+            return copy;
+        }
+        case orc::LIST:
+            return orc::createListType(copyType(*type.getSubtype(0)));
+        case orc::MAP:
+            return orc::createMapType(copyType(*type.getSubtype(0)), copyType(*type.getSubtype(1)));
+        case orc::UNION:
+        {
+            ORC_UNIQUE_PTR<orc::Type> copy = orc::createUnionType();
+
+            for (uint64_t i = 0; i < type.getSubtypeCount(); i++)
+                copy->addUnionChild(copyType(*type.getSubtype(i)));
+
+            return copy;
+        }
+        case orc::DECIMAL:
+            return orc::createDecimalType(type.getPrecision(), type.getScale());
+        case orc::CHAR:
+        case orc::VARCHAR:
+            return orc::createCharType(type.getKind(), type.getMaximumLength());
+        default:
+            return orc::createPrimitiveType(type.getKind());
+    }
+}
+
+/*
+ * orcGetTypeForTupleDesc
+ *    Returns the ORC type of a file for the columns of a table. Numeric
+ *    columns without a precision are written as decimal(38, 18) and
+ *    varchar columns without a length as strings.
+ */
+ORC_UNIQUE_PTR<orc::Type>
+orcGetTypeForTupleDesc(TupleDesc tupdesc)
+{
+    ORC_UNIQUE_PTR<orc::Type> type = orc::createStructType();
+
+    for (int attnum = 0; attnum < tupdesc->natts; attnum++)
+    {
+        Form_pg_attribute attr = TupleDescAttr(tupdesc, attnum);
+        int kind = getOrcKind(attr->atttypid);
+        int32 typmod = attr->atttypmod - VARHDRSZ;
+        ORC_UNIQUE_PTR<orc::Type> field;
+
+        if (attr->attisdropped)
+            continue;
+
+        switch (kind)
+        {
+            case -1:
+                ereport(ERROR, (errmsg("%s: unsupported column data type for column %s", ORC_FDW_NAME, NameStr(attr->attname))));
+                break;
+            case orc::DECIMAL:
+                if (typmod >= 0)
+                    field = orc::createDecimalType((typmod >> 16) & 0xffff, typmod & 0xffff);
+                else
+                    field = orc::createDecimalType(38, 18);
+                break;
+            case orc::VARCHAR:
+                if (typmod >= 0)
+                    field = orc::createCharType(orc::VARCHAR, typmod);
+                else
+                    field = orc::createPrimitiveType(orc::STRING);
+                break;
+            case orc::CHAR:
+                field = orc::createCharType(orc::CHAR, 1);
+                break;
+            default:
+                field = orc::createPrimitiveType((orc::TypeKind) kind);
+                break;
+        }
+
+        type->addStructField(NameStr(attr->attname), std::move(field));
+    }
+
+    return type;
+}
+
+/*
+ * orcInitWriteOptions
+ *    Sets writer options to defaults.
+ */
+void
+orcInitWriteOptions(OrcFdwWriteOptions *options)
+{
+    options->stripe_size = ORC_DEFAULT_STRIPE_SIZE;
+    options->row_index_stride = ORC_DEFAULT_ROW_INDEX_STRIDE;
+    options->row_index_stride_set = false;
+    options->compression = orc::CompressionKind_ZLIB;
+    options->compression_strategy = orc::CompressionStrategy_SPEED;
+    options->bloom_filter_columns = NIL;
+    options->bloom_filter_fpp = ORC_DEFAULT_BLOOM_FILTER_FPP;
+    options->sort_by = NIL;
+    options->cluster_by = NIL;
+    options->workers = 0;
+}
+
+/*
+ * orcParseWriteOption
+ *    Validates a writer table option and sets it in options unless that
+ *    is NULL. Returns false if def is not a writer option.
+ */
+bool
+orcParseWriteOption(DefElem *def, OrcFdwWriteOptions *options)
+{
+    const char *value = defGetString(def);
+    bool valid = true;
+
+    if (strcmp(def->defname, "stripe_size") == 0)
+    {
+        int stripe_size;
+
+        /* Accepts memory units, e.g. 64MB */
+        valid = parse_int(value, &stripe_size, GUC_UNIT_BYTE, NULL) && stripe_size > 0;
+
+        if (valid && options != NULL)
+            options->stripe_size = stripe_size;
+    }
+    else if (strcmp(def->defname, "row_index_stride") == 0)
+    {
+        int row_index_stride;
+
+        valid = parse_int(value, &row_index_stride, 0, NULL) && row_index_stride >= 0;
+
+        if (valid && options != NULL)
+        {
+            options->row_index_stride = row_index_stride;
+            options->row_index_stride_set = true;
+        }
+    }
+    else if (strcmp(def->defname, "compression") == 0)
+    {
+        orc::CompressionKind compression = orc::CompressionKind_NONE;
+
+        if (pg_strcasecmp(value, "none") == 0)
+            compression = orc::CompressionKind_NONE;
+        else if (pg_strcasecmp(value, "zlib") == 0)
+            compression = orc::CompressionKind_ZLIB;
+        else if (pg_strcasecmp(value, "snappy") == 0)
+            compression = orc::CompressionKind_SNAPPY;
+        else if (pg_strcasecmp(value, "lz4") == 0)
+            compression = orc::CompressionKind_LZ4;
+        else if (pg_strcasecmp(value, "zstd") == 0)
+            compression = orc::CompressionKind_ZSTD;
+        else
+            valid = false;
+
+        if (valid && options != NULL)
+            options->compression = compression;
+    }
+    else if (strcmp(def->defname, "compression_strategy") == 0)
+    {
+        orc::CompressionStrategy strategy = orc::CompressionStrategy_SPEED;
+
+        if (pg_strcasecmp(value, "speed") == 0)
+            strategy = orc::CompressionStrategy_SPEED;
+        else if (pg_strcasecmp(value, "compression") == 0)
+            strategy = orc::CompressionStrategy_COMPRESSION;
+        else
+            valid = false;
+
+        if (valid && options != NULL)
+            options->compression_strategy = strategy;
+    }
+    else if (strcmp(def->defname, "bloom_filter_columns") == 0)
+    {
+        List *columns = NIL;
+
+        /* Comma separated column names, quoted as identifiers if needed */
+        valid = SplitIdentifierString(pstrdup(value), ',', &columns) && columns != NIL;
+
+        if (valid && options != NULL)
+            options->bloom_filter_columns = columns;
+    }
+    else if (strcmp(def->defname, "sort_by") == 0)
+    {
+        List *columns = NIL;
+
+        valid = SplitIdentifierString(pstrdup(value), ',', &columns) && columns != NIL;
+
+        if (valid && options != NULL)
+            options->sort_by = columns;
+    }
+    else if (strcmp(def->defname, "cluster_by") == 0)
+    {
+        List *columns = NIL;
+
+        valid = SplitIdentifierString(pstrdup(value), ',', &columns)
+                && list_length(columns) >= ORC_MIN_CLUSTER_COLUMNS
+                && list_length(columns) <= ORC_MAX_CLUSTER_COLUMNS;
+
+        if (valid && options != NULL)
+            options->cluster_by = columns;
+    }
+    else if (strcmp(def->defname, "bloom_filter_fpp") == 0)
+    {
+        double fpp;
+
+        valid = parse_real(value, &fpp, 0, NULL) && fpp > 0 && fpp < 1;
+
+        if (valid && options != NULL)
+            options->bloom_filter_fpp = fpp;
+    }
+    else
+    {
+        return false;
+    }
+
+    if (!valid)
+    {
+        ereport(ERROR,
+                (errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+                 errmsg("%s: invalid value for option \"%s\": \"%s\"",
+                        ORC_FDW_NAME, def->defname, value)));
+    }
+
+    return true;
+}
+
+/*
+ * OrcFdwWriter
+ *    Creates filename and a writer for the ORC type. Each column of the
+ *    type maps to the attribute of the same name; columns without one are
+ *    written as NULLs. All attributes must map to a column of the same
+ *    type.
+ */
+OrcFdwWriter::OrcFdwWriter(const std::string &filename, const orc::Type &file_type, TupleDesc tupdesc, const OrcFdwWriteOptions &options)
+    : filename(filename),
+      current(0),
+      batch_data(NULL),
+      encoding(false),
+      cancelled(false),
+      workers(options.workers),
+      batch_rows(0),
+      rows_written(0),
+      rows_copied(0)
+{
+    orc::WriterOptions writer_options;
+    std::set<uint64_t> bloom_cols;
+    ListCell *lc;
+
+    type = copyType(file_type);
+
+    /* Freed with the context the writer is created in */
+    row_cxt = AllocSetContextCreate(CurrentMemoryContext,
+                                    "orc_fdw write row",
+                                    ALLOCSET_DEFAULT_SIZES);
+
+    for (uint64_t i = 0; i < type->getSubtypeCount(); i++)
+    {
+        const orc::Type *field = type->getSubtype(i);
+        OrcFdwWriteCol col;
+
+        col.attnum = -1;
+        col.kind = (OrcPgTypeKind) field->getKind();
+        col.precision = (int) field->getPrecision();
+        col.scale = (int) field->getScale();
+
+        for (int attnum = 0; tupdesc != NULL && attnum < tupdesc->natts; attnum++)
+        {
+            Form_pg_attribute attr = TupleDescAttr(tupdesc, attnum);
+
+            if (attr->attisdropped || pg_strcasecmp(type->getFieldName(i).c_str(), NameStr(attr->attname)) != 0)
+                continue;
+
+            if (getOrcKind(attr->atttypid) != (int) col.kind
+                && !(attr->atttypid == INT2OID && col.kind == OrcPgTypeKind::BYTE)
+                && !(attr->atttypid == VARCHAROID && col.kind == OrcPgTypeKind::STRING))
+            {
+                ereport(ERROR, (errmsg("%s: Unable to write data for column %s with data type mismatch against ORC file.", ORC_FDW_NAME, NameStr(attr->attname))));
+            }
+
+            col.attnum = attnum;
+            break;
+        }
+
+        /* Only columns of simple types may be left NULL */
+        if (tupdesc != NULL && col.attnum < 0
+            && (col.kind == OrcPgTypeKind::LIST
+                || col.kind == OrcPgTypeKind::MAP
+                || col.kind == OrcPgTypeKind::STRUCT
+                || col.kind == OrcPgTypeKind::UNION_UNSUPPORTED))
+        {
+            ereport(ERROR, (errmsg("%s: Unable to write ORC file %s with unsupported column %s.", ORC_FDW_NAME, filename.c_str(), type->getFieldName(i).c_str())));
+        }
+
+        cols.push_back(col);
+    }
+
+    /* Values of every attribute must be stored */
+    for (int attnum = 0; tupdesc != NULL && attnum < tupdesc->natts; attnum++)
+    {
+        Form_pg_attribute attr = TupleDescAttr(tupdesc, attnum);
+        bool found = false;
+
+        for (auto col = cols.begin(); col != cols.end() && !found; col++)
+            found = ((*col).attnum == attnum);
+
+        if (!attr->attisdropped && !found)
+        {
+            ereport(ERROR, (errmsg("%s: column %s is not in ORC file.", ORC_FDW_NAME, NameStr(attr->attname))));
+        }
+    }
+
+    foreach(lc, options.bloom_filter_columns)
+    {
+        const char *name = (const char *) lfirst(lc);
+        uint64_t i;
+
+        for (i = 0; i < type->getSubtypeCount(); i++)
+        {
+            if (pg_strcasecmp(type->getFieldName(i).c_str(), name) == 0)
+                break;
+        }
+
+        if (i == type->getSubtypeCount())
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_FDW_INVALID_ATTRIBUTE_VALUE),
+                     errmsg("%s: bloom filter column %s is not in ORC file.", ORC_FDW_NAME, name)));
+        }
+
+        bloom_cols.insert(type->getSubtype(i)->getColumnId());
+    }
+
+    writer_options.setStripeSize(options.stripe_size);
+    if (!options.row_index_stride_set && (options.sort_by != NIL || options.cluster_by != NIL))
+        writer_options.setRowIndexStride(ORC_SORTED_ROW_INDEX_STRIDE);
+    else
+        writer_options.setRowIndexStride(options.row_index_stride);
+    writer_options.setCompression(options.compression);
+    writer_options.setCompressionStrategy(options.compression_strategy);
+
+    if (!bloom_cols.empty())
+    {
+        writer_options.setColumnsUseBloomFilter(bloom_cols);
+        writer_options.setBloomFilterFPP(options.bloom_filter_fpp);
+    }
+
+    try
+    {
+        if (workers > 0)
+            orcWorkersResize(workers);
+
+        out = orc::writeLocalFile(filename);
+        writer = orc::createWriter(*type, out.get(), writer_options);
+
+        /* One batch is filled while the others wait for the worker */
+        batches.resize((workers > 0) ? ORC_WRITE_QUEUED_BATCHES : 1);
+
+        for (size_t i = 0; i < batches.size(); i++)
+        {
+            batches[i].batch = writer->createRowBatch(ORC_DEFAULT_WRITE_BATCH_SIZE);
+            batches[i].var_data.resize(cols.size());
+
+            if (i != current)
+                free_batches.push_back(i);
+        }
+
+        batch_data = dynamic_cast<orc::StructVectorBatch *>(batches[current].batch.get());
+    }
+    catch (std::exception& err)
+    {
+        ereport(ERROR, (errmsg("%s: %s", ORC_FDW_NAME, err.what())));
+    }
+}
+
+/*
+ * ~OrcFdwWriter
+ *    Waits for the worker to stop using the writer; queued batches are
+ *    dropped.
+ */
+OrcFdwWriter::~OrcFdwWriter()
+{
+    std::unique_lock<std::mutex> guard(lock);
+
+    cancelled = true;
+    changed.wait(guard, [this] { return !encoding; });
+}
+
+/*
+ * setValue
+ *    Stores a value in the current row of a column's batch.
+ */
+void
+OrcFdwWriter::setValue(OrcFdwWriteCol &col, orc::ColumnVectorBatch *field, std::vector<char> &var_data, Datum value)
+{
+    switch (col.kind)
+    {
+        case OrcPgTypeKind::BOOLEAN:
+            static_cast<orc::LongVectorBatch *>(field)->data[batch_rows] = DatumGetBool(value);
+            break;
+        case OrcPgTypeKind::BYTE:
+            if (DatumGetInt16(value) < INT8_MIN || DatumGetInt16(value) > INT8_MAX)
+            {
+                ereport(ERROR,
+                        (errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+                         errmsg("%s: value %d out of range for an ORC byte column.", ORC_FDW_NAME, DatumGetInt16(value))));
+            }
+
+            static_cast<orc::LongVectorBatch *>(field)->data[batch_rows] = DatumGetInt16(value);
+            break;
+        case OrcPgTypeKind::SHORT:
+            static_cast<orc::LongVectorBatch *>(field)->data[batch_rows] = DatumGetInt16(value);
+            break;
+        case OrcPgTypeKind::INT:
+            static_cast<orc::LongVectorBatch *>(field)->data[batch_rows] = DatumGetInt32(value);
+            break;
+        case OrcPgTypeKind::LONG:
+            static_cast<orc::LongVectorBatch *>(field)->data[batch_rows] = DatumGetInt64(value);
+            break;
+        case OrcPgTypeKind::FLOAT:
+            static_cast<orc::DoubleVectorBatch *>(field)->data[batch_rows] = DatumGetFloat4(value);
+            break;
+        case OrcPgTypeKind::DOUBLE:
+            static_cast<orc::DoubleVectorBatch *>(field)->data[batch_rows] = DatumGetFloat8(value);
+            break;
+        case OrcPgTypeKind::DECIMAL:
+        {
+            Datum rounded;
+            char *str;
+            std::string digits;
+            size_t first;
+
+            if (numeric_is_nan(DatumGetNumeric(value)))
+            {
+                ereport(ERROR,
+                        (errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+                         errmsg("%s: NaN can't be written to an ORC decimal column.", ORC_FDW_NAME)));
+            }
+
+            /* ORC stores the unscaled value; round to the column's scale
+             * and drop the decimal point */
+            rounded = DirectFunctionCall2(numeric_round, value, Int32GetDatum(col.scale));
+            str = DatumGetCString(DirectFunctionCall1(numeric_out, rounded));
+            digits = str;
+            pfree(str);
+
+            digits.erase(std::remove(digits.begin(), digits.end(), '.'), digits.end());
+
+            /* Only significant digits count, so 0.05 fits decimal(2, 2) */
+            first = digits.find_first_not_of("-0");
+            if (first != std::string::npos && (int) (digits.length() - first) > col.precision)
+            {
+                ereport(ERROR,
+                        (errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+                         errmsg("%s: numeric value out of range for decimal(%d, %d).", ORC_FDW_NAME, col.precision, col.scale)));
+            }
+
+            if (col.precision <= 18)
+                static_cast<orc::Decimal64VectorBatch *>(field)->values[batch_rows] = std::stoll(digits);
+            else
+                static_cast<orc::Decimal128VectorBatch *>(field)->values[batch_rows] = orc::Int128(digits);
+
+            break;
+        }
+        case OrcPgTypeKind::STRING:
+        case OrcPgTypeKind::VARCHAR:
+        case OrcPgTypeKind::BINARY:
+        {
+            struct varlena *v = pg_detoast_datum_packed((struct varlena *) DatumGetPointer(value));
+            int64_t len = VARSIZE_ANY_EXHDR(v);
+
+            /* Pointers are set when the batch is full as the buffer may
+             * move while growing */
+            var_data.insert(var_data.end(), VARDATA_ANY(v), VARDATA_ANY(v) + len);
+            static_cast<orc::StringVectorBatch *>(field)->length[batch_rows] = len;
+
+            if ((Pointer) v != DatumGetPointer(value))
+                pfree(v);
+
+            break;
+        }
+        case OrcPgTypeKind::CHAR:
+        {
+            var_data.push_back(DatumGetChar(value));
+            static_cast<orc::StringVectorBatch *>(field)->length[batch_rows] = 1;
+            break;
+        }
+        case OrcPgTypeKind::TIMESTAMP:
+        {
+            Timestamp ts = DatumGetTimestamp(value);
+            int64_t usecs;
+            int64_t secs;
+
+            if (TIMESTAMP_NOT_FINITE(ts))
+            {
+                ereport(ERROR,
+                        (errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+                         errmsg("%s: infinite timestamps can't be written to an ORC file.", ORC_FDW_NAME)));
+            }
+
+            /* Seconds since the UNIX epoch, rounded down, and nanoseconds */
+            usecs = ts + (int64_t) (POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE) * USECS_PER_DAY;
+            secs = usecs / USECS_PER_SEC;
+
+            if (usecs % USECS_PER_SEC < 0)
+                secs--;
+
+            static_cast<orc::TimestampVectorBatch *>(field)->data[batch_rows] = secs;
+            static_cast<orc::TimestampVectorBatch *>(field)->nanoseconds[batch_rows] = (usecs - secs * USECS_PER_SEC) * 1000;
+            break;
+        }
+        case OrcPgTypeKind::DATE:
+        {
+            DateADT date = DatumGetDateADT(value);
+
+            if (DATE_NOT_FINITE(date))
+            {
+                ereport(ERROR,
+                        (errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+                         errmsg("%s: infinite dates can't be written to an ORC file.", ORC_FDW_NAME)));
+            }
+
+            static_cast<orc::LongVectorBatch *>(field)->data[batch_rows] = date + (POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE);
+            break;
+        }
+        default:
+            /* Unmapped columns are always NULL */
+            ereport(ERROR, (errmsg("%s: unsupported column data type for ORC writer.", ORC_FDW_NAME)));
+            break;
+    }
+}
+
+/*
+ * addRow
+ *    Adds a row of values in the order of attributes to the batch. Values
+ *    are converted in a context reset for each row.
+ */
+void
+OrcFdwWriter::addRow(Datum *values, bool *isnull)
+{
+    MemoryContext oldcxt = MemoryContextSwitchTo(row_cxt);
+
+    for (size_t i = 0; i < cols.size(); i++)
+    {
+        OrcFdwWriteCol &col = cols[i];
+        orc::ColumnVectorBatch *field = batch_data->fields[i];
+
+        if (col.attnum < 0 || isnull[col.attnum])
+        {
+            field->notNull[batch_rows] = 0;
+            field->hasNulls = true;
+
+            if (isVarLength(col.kind))
+                static_cast<orc::StringVectorBatch *>(field)->length[batch_rows] = 0;
+
+            continue;
+        }
+
+        field->notNull[batch_rows] = 1;
+        setValue(col, field, batches[current].var_data[i], values[col.attnum]);
+    }
+
+    MemoryContextSwitchTo(oldcxt);
+    MemoryContextReset(row_cxt);
+
+    rows_written++;
+
+    if (++batch_rows == ORC_DEFAULT_WRITE_BATCH_SIZE)
+        flush();
+}
+
+/*
+ * flush
+ *    Adds the buffered rows to the ORC writer, or queues them for the
+ *    worker and moves on to a free batch.
+ */
+void
+OrcFdwWriter::flush()
+{
+    OrcFdwWriteBatch &full = batches[current];
+
+    if (batch_rows == 0)
+        return;
+
+    for (size_t i = 0; i < cols.size(); i++)
+    {
+        orc::ColumnVectorBatch *field = batch_data->fields[i];
+
+        if (isVarLength(cols[i].kind))
+        {
+            orc::StringVectorBatch *s = static_cast<orc::StringVectorBatch *>(field);
+            char *data = full.var_data[i].data();
+
+            for (uint64_t row = 0; row < batch_rows; row++)
+            {
+                s->data[row] = data;
+                data += s->length[row];
+            }
+        }
+
+        field->numElements = batch_rows;
+    }
+
+    batch_data->numElements = batch_rows;
+
+    if (workers > 0)
+    {
+        bool submit;
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+
+            queued.push_back(current);
+            submit = !encoding;
+            encoding = true;
+        }
+
+        if (submit)
+        {
+            try
+            {
+                orcWorkersSubmit([this] { encodeBatches(); });
+            }
+            catch (std::exception& err)
+            {
+                std::lock_guard<std::mutex> guard(lock);
+
+                encoding = false;
+                cancelled = true;
+            }
+        }
+
+        nextBatch();
+    }
+    else
+    {
+        try
+        {
+            writer->add(*full.batch);
+        }
+        catch (std::exception& err)
+        {
+            ereport(ERROR, (errmsg("%s: %s", ORC_FDW_NAME, err.what())));
+        }
+    }
+
+    for (size_t i = 0; i < cols.size(); i++)
+    {
+        batch_data->fields[i]->hasNulls = false;
+        batches[current].var_data[i].clear();
+    }
+
+    batch_rows = 0;
+}
+
+/*
+ * nextBatch
+ *    Waits for a batch to be free and makes it the current batch. Errors
+ *    of the worker are raised here.
+ */
+void
+OrcFdwWriter::nextBatch()
+{
+    for (;;)
+    {
+        std::string message;
+        bool found = false;
+
+        {
+            std::unique_lock<std::mutex> guard(lock);
+
+            if (free_batches.empty() && error.empty() && !cancelled)
+                changed.wait_for(guard, std::chrono::milliseconds(10));
+
+            if (!error.empty())
+                message = error;
+            else if (cancelled)
+                message = "write worker could not be started";
+            else if (!free_batches.empty())
+            {
+                current = free_batches.back();
+                free_batches.pop_back();
+                found = true;
+            }
+        }
+
+        if (!message.empty())
+            ereport(ERROR, (errmsg("%s: %s", ORC_FDW_NAME, message.c_str())));
+
+        if (found)
+            break;
+
+        CHECK_FOR_INTERRUPTS();
+    }
+
+    batch_data = static_cast<orc::StructVectorBatch *>(batches[current].batch.get());
+}
+
+/*
+ * encodeBatches
+ *    Runs on a worker thread; adds queued batches to the ORC writer in
+ *    order until none is left.
+ */
+void
+OrcFdwWriter::encodeBatches()
+{
+    for (;;)
+    {
+        size_t next;
+        bool skip;
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+
+            if (queued.empty())
+            {
+                encoding = false;
+                changed.notify_all();
+                return;
+            }
+
+            next = queued.front();
+            skip = (cancelled || !error.empty());
+        }
+
+        if (!skip)
+        {
+            try
+            {
+                writer->add(*batches[next].batch);
+            }
+            catch (std::exception& err)
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                error = err.what();
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+
+            queued.pop_front();
+            free_batches.push_back(next);
+            changed.notify_all();
+        }
+    }
+}
+
+/*
+ * waitForWorker
+ *    Waits until the worker has added all queued batches to the ORC
+ *    writer, so that the backend may use it.
+ */
+void
+OrcFdwWriter::waitForWorker()
+{
+    for (;;)
+    {
+        std::string message;
+        bool done;
+
+        {
+            std::unique_lock<std::mutex> guard(lock);
+
+            if (encoding)
+                changed.wait_for(guard, std::chrono::milliseconds(10));
+
+            done = !encoding;
+            message = error;
+        }
+
+        if (!message.empty())
+            ereport(ERROR, (errmsg("%s: %s", ORC_FDW_NAME, message.c_str())));
+
+        if (done)
+            break;
+
+        CHECK_FOR_INTERRUPTS();
+    }
+}
+
+/*
+ * appendFile
+ *    Copies all rows of an ORC file with the same type as the one being
+ *    written; batches are added as read without converting values.
+ */
+void
+OrcFdwWriter::appendFile(const std::string &source)
+{
+    orc::ReaderOptions options;
+    ORC_UNIQUE_PTR<orc::Reader> reader;
+
+    (void) orcCreateReader(source, &reader, options, false);
+    appendReader(&reader, source);
+}
+
+/*
+ * appendReader
+ *    Copies all rows of a file already opened by the caller.
+ */
+void
+OrcFdwWriter::appendReader(ORC_UNIQUE_PTR<orc::Reader> *reader, const std::string &source)
+{
+    orc::RowReaderOptions rowReaderOptions;
+    ORC_UNIQUE_PTR<orc::RowReader> rowReader;
+
+    flush();
+    waitForWorker();
+
+    if ((*reader)->getType().toString() != type->toString())
+    {
+        ereport(ERROR, (errmsg("%s: ORC file %s doesn't match the columns of %s.", ORC_FDW_NAME, source.c_str(), filename.c_str())));
+    }
+
+    (void) orcCreateRowReader(reader, &rowReader, rowReaderOptions);
+
+    try
+    {
+        ORC_UNIQUE_PTR<orc::ColumnVectorBatch> copy = rowReader->createRowBatch(ORC_DEFAULT_WRITE_BATCH_SIZE);
+
+        while (rowReader->next(*copy))
+        {
+            writer->add(*copy);
+            rows_copied += copy->numElements;
+
+            CHECK_FOR_INTERRUPTS();
+        }
+    }
+    catch (std::exception& err)
+    {
+        ereport(ERROR, (errmsg("%s: %s", ORC_FDW_NAME, err.what())));
+    }
+}
+
+/*
+ * close
+ *    Writes the remaining rows and the file footer.
+ */
+void
+OrcFdwWriter::close()
+{
+    flush();
+    waitForWorker();
+
+    try
+    {
+        writer->close();
+    }
+    catch (std::exception& err)
+    {
+        ereport(ERROR, (errmsg("%s: %s", ORC_FDW_NAME, err.what())));
+    }
+}